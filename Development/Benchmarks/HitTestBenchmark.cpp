@@ -0,0 +1,169 @@
+#include <GL/glew.h>
+#include <SFML/Graphics.hpp>
+#include <json/json.h>
+#include <sstream>
+#include <list>
+#include <deque>
+#include <math.h>
+#include <stdio.h>
+#include "SuperSmartPointer.hpp"
+#include "StringID.hpp"
+#include "GenericConfig.hpp"
+#include "Delegate.h"
+#include "Signal.h"
+using namespace Gallant;
+#include "Math.hpp"
+#include "Input.hpp"
+#include "Sprite.hpp"
+#include "TextureAtlas.hpp"
+#include "TextureCache.hpp"
+#include "DrawCommandList.hpp"
+#include "SpriteBatch.hpp"
+#include "TextEngine.hpp"
+#include "Future.hpp"
+#include "ThreadPool.hpp"
+#include "StringUtils.hpp"
+#include "GapBuffer.hpp"
+#include "GUI.hpp"
+
+//!<The widgets are laid out in a grid covering the window, so every query hits one
+#define BENCHMARK_COLUMNS 100
+#define BENCHMARK_ROWS 100
+#define BENCHMARK_WIDGET_WIDTH 10
+#define BENCHMARK_WIDGET_HEIGHT 6
+#define BENCHMARK_QUERIES 100000
+#define BENCHMARK_MOVES 10000
+#define BENCHMARK_REBUILDS 100
+
+bool LoadFile(const char *Path, std::string &Out)
+{
+	FILE *In = fopen(Path, "rt");
+
+	if(!In)
+		return false;
+
+	fseek(In, 0, SEEK_END);
+
+	int Size = ftell(In);
+
+	fseek(In, 0, SEEK_SET);
+
+	Out.resize(Size);
+
+	fread(&Out[0], sizeof(char), Size, In);
+
+	fclose(In);
+
+	Out.resize(strlen(Out.c_str()));
+
+	return true;
+};
+
+/*!
+	Moves the mouse to a different widget every time, so nothing is answered from the previous query
+*/
+void MoveMouse(InputCenter &Input, unsigned long i)
+{
+	Input.MousePosition = Vector2((float)((i * 7919) % (BENCHMARK_COLUMNS * BENCHMARK_WIDGET_WIDTH)),
+		(float)((i * 104729) % (BENCHMARK_ROWS * BENCHMARK_WIDGET_HEIGHT)));
+};
+
+//Must be run from the Content directory, like the sample, since the widgets need a skin
+int main(int argc, char **argv)
+{
+	sf::RenderWindow Window;
+	Window.create(sf::VideoMode(BENCHMARK_COLUMNS * BENCHMARK_WIDGET_WIDTH, BENCHMARK_ROWS * BENCHMARK_WIDGET_HEIGHT), "HitTestBenchmark");
+
+	if(!Window.isOpen())
+		return 1;
+
+	InputCenter Input;
+	UIManager UI(&Window, &Input);
+
+	std::string Skin;
+
+	if(!LoadFile("UIThemes/PolyCode/skin.cfg", Skin))
+	{
+		printf("Unable to load the skin, run this from the Content directory\n");
+
+		return 1;
+	};
+
+	SuperSmartPointer<GenericConfig> Config(new GenericConfig());
+
+	if(!Config->DeSerialize(Skin))
+		return 1;
+
+	UI.SetSkin(Config);
+
+	SuperSmartPointer<UIPanel> Root(new UIFrame(&UI));
+	UI.AddElement(MakeStringID("HitTestBenchmarkRoot"), Root);
+	Root->SetSize(Vector2((float)Window.getSize().x, (float)Window.getSize().y));
+
+	std::vector<SuperSmartPointer<UIPanel> > Widgets;
+
+	for(unsigned long y = 0; y < BENCHMARK_ROWS; y++)
+	{
+		for(unsigned long x = 0; x < BENCHMARK_COLUMNS; x++)
+		{
+			SuperSmartPointer<UIPanel> Widget(new UIFrame(&UI));
+			UI.AddElement(MakeStringID("HitTestBenchmarkWidget" + StringUtils::MakeIntString((long)Widgets.size())), Widget);
+			Root->AddChildren(Widget);
+			Widget->SetPosition(Vector2((float)(x * BENCHMARK_WIDGET_WIDTH), (float)(y * BENCHMARK_WIDGET_HEIGHT)));
+			Widget->SetSize(Vector2((float)BENCHMARK_WIDGET_WIDTH - 1, (float)BENCHMARK_WIDGET_HEIGHT - 1));
+
+			Widgets.push_back(Widget);
+		};
+	};
+
+	UI.Update();
+
+	unsigned long Hits = 0;
+	sf::Clock Clock;
+
+	//Nothing changes between queries, so the index is only searched
+	for(unsigned long i = 0; i < BENCHMARK_QUERIES; i++)
+	{
+		MoveMouse(Input, i);
+
+		Hits += UI.GetMouseOverElement().Get() != NULL;
+	};
+
+	float QueryTime = Clock.restart().asSeconds();
+
+	//One widget moves before every query, like dragging or scrolling, which only re-inserts that widget
+	for(unsigned long i = 0; i < BENCHMARK_MOVES; i++)
+	{
+		UIPanel *Widget = Widgets[(i * 31) % Widgets.size()];
+
+		Widget->SetPosition(Widget->GetPosition() + Vector2(0, i % 2 ? -1.f : 1.f));
+
+		MoveMouse(Input, i);
+
+		Hits += UI.GetMouseOverElement().Get() != NULL;
+	};
+
+	float MoveTime = Clock.restart().asSeconds();
+
+	//One widget is hidden or shown before every query, which rebuilds the whole index
+	for(unsigned long i = 0; i < BENCHMARK_REBUILDS; i++)
+	{
+		UIPanel *Widget = Widgets[(i / 2 * 31) % Widgets.size()];
+
+		Widget->SetVisible(!Widget->IsVisible());
+
+		MoveMouse(Input, i);
+
+		Hits += UI.GetMouseOverElement().Get() != NULL;
+	};
+
+	float RebuildTime = Clock.restart().asSeconds();
+
+	printf("%lu widgets\n", (unsigned long)Widgets.size());
+	printf("%-24s %10.2f us/query\n", "Query", QueryTime * 1e6f / BENCHMARK_QUERIES);
+	printf("%-24s %10.2f us/query\n", "Move then query", MoveTime * 1e6f / BENCHMARK_MOVES);
+	printf("%-24s %10.2f us/query\n", "Rebuild then query", RebuildTime * 1e6f / BENCHMARK_REBUILDS);
+	printf("(%lu hits)\n", Hits);
+
+	return 0;
+};
@@ -0,0 +1,304 @@
+#include <map>
+#include <list>
+#include <vector>
+#include <sstream>
+#include <GL/glew.h>
+#include <SFML/Graphics.hpp>
+#include <math.h>
+#include <stdio.h>
+#include "SuperSmartPointer.hpp"
+#include "StringID.hpp"
+#include "Math.hpp"
+#include "Sprite.hpp"
+#include "TextureAtlas.hpp"
+#include "DrawCommandList.hpp"
+#include "SpriteBatch.hpp"
+#include "TextEngine.hpp"
+
+#define BENCHMARK_FONT_SIZE 12
+#define BENCHMARK_WIDTH 400
+//!<How many characters are broken into lines per text size, spread among as many calls as it takes
+#define BENCHMARK_CHARACTERS (1024 * 1024 * 4)
+//!<The same for FitTextOnRect, which is quadratic, so it's given far fewer
+#define BENCHMARK_FITTEXT_CHARACTERS (1024 * 100)
+
+//The line breaking GUI.cpp used before TextEngine::BreakLines, kept to compare against
+static Rect MeasureTextSimple(const sf::String &Str, const sf::Font *Font,
+										unsigned long FontSize)
+{
+	if(!Font)
+		return Rect();
+
+	//Workaround for newline strings
+	if(Str.getSize() == 0)
+		return Rect(0, 0, 0, (float)FontSize);
+
+	return TextEngine::Instance.Measure(Str, Font, FontSize);
+};
+
+/*!
+*	Formatting logic:
+*	#1: Split Words and Lines
+*	#2: For each word, keep adding it together until you exceed either size.x or size.y
+*	#3: Check if we can recover by verifying if the old sentence works.
+*	If it does, add a new line and continue if the size.y is less than the text height.
+*/
+static std::vector<sf::String> FitTextOnRect(const sf::String &String, const sf::Font *Font,
+													   long FontSize, const Vector2 &Size)
+{
+	std::vector<sf::String> Lines;
+
+	std::wstring str = String.toWideString();
+
+	std::vector<std::wstring> Fragments;
+
+	//Extract Fragments
+
+	unsigned long Offset = 0, PreviousOffset = 0;
+
+	for(;;)
+	{
+		PreviousOffset = Offset;
+
+		long MatchSpace = str.find(L' ', PreviousOffset), MatchNewLine = str.find(L'\n', PreviousOffset);
+		long Match = std::wstring::npos;
+
+		if(MatchSpace != -1)
+		{
+			Match = MatchSpace;
+		};
+
+		if(MatchNewLine != -1 && (MatchSpace == -1 || MatchNewLine < MatchSpace))
+		{
+			Match = MatchNewLine;
+		};
+
+		if(Match == std::wstring::npos)
+		{
+			if(Offset < str.length())
+			{
+				Fragments.push_back(str.substr(Offset));
+			};
+
+			break;
+		};
+
+		if(Match - PreviousOffset > 0)
+		{
+			Fragments.push_back(str.substr(PreviousOffset, Match - PreviousOffset));
+
+			if(Match == MatchNewLine)
+				Fragments.push_back(L"\n");
+		}
+		else if(Match == MatchNewLine) //Add empty newlines
+		{
+			Fragments.push_back(L"\n");
+		};
+
+		Offset = Match + 1;
+	};
+
+	Vector2 CurrentSize;
+
+	std::wstringstream stream, stream2;
+
+	bool First = true;
+
+	std::wstring CurrentText;
+	long NewLineIndex = -1;
+
+	while(CurrentSize.y < Size.y)
+	{
+		if(!First)
+			stream << " ";
+
+		if(First)
+			First = false;
+
+		if(Fragments.size() && Fragments[0].at(0) != L'\n')
+			stream << Fragments[0];
+
+		if(Fragments.size() && ((NewLineIndex = Fragments[0].find(L'\n')) == 0 || NewLineIndex == 1))
+		{
+			if(!First)
+				stream.str(stream.str().substr(0, stream.str().length() - 1));
+
+			Lines.push_back(stream.str());
+
+			CurrentText += stream.str() + L"\n";
+
+			stream.str(L"");
+			stream2.str(L"");
+
+			Fragments.erase(Fragments.begin());
+
+			First = true;
+
+			continue;
+		};
+
+		CurrentSize = MeasureTextSimple(CurrentText + stream.str(), Font, FontSize).ToFullSize();
+
+		//Early-out
+		if(CurrentSize.y > Size.y)
+		{
+			return Lines;
+		};
+
+		if(CurrentSize.x > Size.x)
+		{
+			//Recover old sentence
+			if(stream2.str().length() != 0)
+				stream.str(stream2.str());
+
+			CurrentSize = MeasureTextSimple(stream.str(), Font, FontSize).ToFullSize();
+
+			if(CurrentSize.x > Size.x) //So by default it would exceed size
+			{
+				return Lines;
+			};
+
+			//Verify the old text
+			CurrentSize = MeasureTextSimple(CurrentText + stream.str(), Font, FontSize).ToFullSize();
+
+			bool IgnoreNewLine = CurrentText.length() && CurrentText[CurrentText.length() - 1] == '\n';
+
+			if(!IgnoreNewLine)
+			{
+				//Remove extra space
+				if(!First)
+				{
+					CurrentText = CurrentText.substr(0, CurrentText.length() - 1);
+				};
+
+				CurrentText += L"\n";
+			};
+
+			//If we added text, add that line to our Lines and reset everything
+			if(stream.str().length())
+			{
+				Lines.push_back(stream.str());
+
+				stream.str(L"");
+				stream2.str(L"");
+			};
+
+			stream.str(L"");
+			stream2.str(L"");
+
+			First = true;
+
+			continue;
+		};
+
+		//Save the last working text here
+		if(Fragments.size())
+		{
+			stream2.str(stream.str());
+
+			Fragments.erase(Fragments.begin());
+		}
+		else //Final check here
+		{
+			CurrentSize = MeasureTextSimple(CurrentText + stream.str(), Font, FontSize).ToFullSize();
+
+			if(CurrentSize.x > Size.x || CurrentSize.y > Size.y)
+			{
+				return Lines;
+			};
+
+			Lines.push_back(stream.str());
+
+			return Lines;
+		};
+	};
+
+	if(stream.str().length())
+		Lines.push_back(stream.str());
+
+	return Lines;
+};
+
+/*!
+	Makes words of 1 to 12 letters with a paragraph break every 40 words or so, the same every time
+*/
+sf::String MakeText(unsigned long Length)
+{
+	std::string Out;
+	Out.reserve(Length);
+
+	unsigned long Seed = 12345;
+
+	while(Out.size() < Length)
+	{
+		Seed = Seed * 1103515245 + 12345;
+
+		unsigned long WordLength = 1 + (Seed >> 16) % 12;
+
+		for(unsigned long i = 0; i < WordLength && Out.size() < Length; i++)
+		{
+			Out.push_back((char)('a' + (Seed >> (i + 8)) % 26));
+		};
+
+		if(Out.size() < Length)
+			Out.push_back((Seed >> 24) % 40 == 0 ? '\n' : ' ');
+	};
+
+	return sf::String(Out);
+};
+
+void RunBenchmark(const sf::Font *Font, unsigned long Length)
+{
+	sf::String Text = MakeText(Length);
+	std::vector<TextLineSpan> Lines;
+	std::vector<sf::String> FitLines;
+	unsigned long Iterations = BENCHMARK_CHARACTERS / Length, FitIterations = BENCHMARK_FITTEXT_CHARACTERS / Length;
+
+	//Warm up the glyph cache so only line breaking is measured
+	TextEngine::Instance.BreakLines(Text, Font, BENCHMARK_FONT_SIZE, Vector2(BENCHMARK_WIDTH, 9999999), Lines);
+
+	sf::Clock Clock;
+
+	for(unsigned long i = 0; i < Iterations; i++)
+	{
+		TextEngine::Instance.BreakLines(Text, Font, BENCHMARK_FONT_SIZE, Vector2(BENCHMARK_WIDTH, 9999999), Lines);
+	};
+
+	float Time = Clock.restart().asSeconds();
+
+	for(unsigned long i = 0; i < FitIterations; i++)
+	{
+		FitLines = FitTextOnRect(Text, Font, BENCHMARK_FONT_SIZE, Vector2(BENCHMARK_WIDTH, 9999999));
+	};
+
+	float FitTime = Clock.restart().asSeconds();
+
+	printf("%6lu KB %-14s %10.3f ms/call %10.2f ns/character %8lu lines\n", Length / 1024, "BreakLines", Time * 1000.0f / Iterations,
+		Time * 1e9f / (Iterations * Length), (unsigned long)Lines.size());
+	printf("%6lu KB %-14s %10.3f ms/call %10.2f ns/character %8lu lines\n", Length / 1024, "FitTextOnRect", FitTime * 1000.0f / FitIterations,
+		FitTime * 1e9f / (FitIterations * Length), (unsigned long)FitLines.size());
+};
+
+//Must be run from the Content directory, since it uses the sample's font
+int main(int argc, char **argv)
+{
+	//Glyphs are rendered into textures, which need a context
+	sf::Context Context;
+
+	sf::Font Font;
+
+	if(!Font.loadFromFile("sans.ttf"))
+	{
+		printf("Unable to load the font, run this from the Content directory\n");
+
+		return 1;
+	};
+
+	printf("Font size %u, %u pixels wide\n", BENCHMARK_FONT_SIZE, BENCHMARK_WIDTH);
+
+	RunBenchmark(&Font, 1024);
+	RunBenchmark(&Font, 1024 * 10);
+	RunBenchmark(&Font, 1024 * 100);
+
+	return 0;
+};
@@ -0,0 +1,157 @@
+#include <vector>
+#include <stdio.h>
+#include <SFML/System.hpp>
+#include "SuperSmartPointer.hpp"
+
+/*!
+	The previous SuperSmartPointer, which tracks every copy in a list, kept here to compare against
+*/
+template<typename type>
+class ObserverSmartPointer
+{
+private:
+	class Container
+	{
+	public:
+		typedef std::vector<ObserverSmartPointer *> ObserverList;
+		ObserverList Observers;
+		type *Object;
+
+		Container() : Object(NULL) {};
+
+		void Add(ObserverSmartPointer *Observer)
+		{
+			Observers.push_back(Observer);
+		};
+
+		void Remove(ObserverSmartPointer *Observer)
+		{
+			for(typename ObserverList::iterator it = Observers.begin(); it != Observers.end(); it++)
+			{
+				if(*it == Observer)
+				{
+					Observer->Content = NULL;
+
+					Observers.erase(it);
+
+					if(Observers.size() == 0)
+					{
+						delete Object;
+						delete this;
+					};
+
+					break;
+				};
+			};
+		};
+	};
+
+	Container *Content;
+public:
+	ObserverSmartPointer() : Content(NULL) {};
+	explicit ObserverSmartPointer(type *Object) : Content(new Container())
+	{
+		Content->Object = Object;
+		Content->Add(this);
+	};
+
+	ObserverSmartPointer(const ObserverSmartPointer &o) : Content(NULL)
+	{
+		*this = o;
+	};
+
+	~ObserverSmartPointer()
+	{
+		if(Content)
+			Content->Remove(this);
+	};
+
+	ObserverSmartPointer &operator=(const ObserverSmartPointer &o)
+	{
+		if(Content == o.Content || this == &o)
+			return *this;
+
+		if(Content)
+			Content->Remove(this);
+
+		Content = o.Content;
+
+		if(Content)
+			Content->Add(this);
+
+		return *this;
+	};
+
+	type *Get()
+	{
+		return Content ? Content->Object : NULL;
+	};
+};
+
+class Element
+{
+public:
+	unsigned long Value;
+
+	Element() : Value(1) {};
+};
+
+//!<How many long-lived copies exist while the hot loops run, like a panel referenced by its parent, layout, and manager
+#define BENCHMARK_LIVE_COPIES 64
+#define BENCHMARK_ITERATIONS 1000000
+#define BENCHMARK_BULK_COPIES 10000
+
+template<typename Pointer> Pointer ReturnByValue(std::vector<Pointer> &Pointers, unsigned long Index)
+{
+	return Pointers[Index % Pointers.size()];
+};
+
+template<typename Pointer> void RunBenchmark(const char *Name)
+{
+	std::vector<Pointer> Live;
+	Live.push_back(Pointer(new Element()));
+
+	for(unsigned long i = 1; i < BENCHMARK_LIVE_COPIES; i++)
+	{
+		Live.push_back(Live[0]);
+	};
+
+	unsigned long Sum = 0;
+	sf::Clock Clock;
+
+	//Temporary copies, like GetElement returning by value
+	for(unsigned long i = 0; i < BENCHMARK_ITERATIONS; i++)
+	{
+		Pointer Copy = ReturnByValue(Live, i);
+
+		Sum += Copy.Get()->Value;
+	};
+
+	float CopyTime = Clock.restart().asSeconds();
+
+	//Many copies made and released in bulk, like rebuilding a draw order list
+	std::vector<Pointer> Bulk;
+	Bulk.reserve(BENCHMARK_BULK_COPIES);
+
+	for(unsigned long i = 0; i < BENCHMARK_BULK_COPIES; i++)
+	{
+		Bulk.push_back(Live[0]);
+	};
+
+	Bulk.clear();
+
+	float BulkTime = Clock.restart().asSeconds();
+
+	printf("%-24s %10.2f ns/copy %10.2f ms for %u bulk copies (checksum %lu)\n", Name, CopyTime * 1e9f / BENCHMARK_ITERATIONS,
+		BulkTime * 1000.0f, BENCHMARK_BULK_COPIES, Sum);
+};
+
+int main(int argc, char **argv)
+{
+	printf("%u live copies, %u temporary copies\n", BENCHMARK_LIVE_COPIES, BENCHMARK_ITERATIONS);
+
+	RunBenchmark<ObserverSmartPointer<Element> >("Observer list");
+	RunBenchmark<SuperSmartPointer<Element> >("SuperSmartPointer");
+
+	return 0;
+};
@@ -0,0 +1,135 @@
+#include <map>
+#include <vector>
+#include <sstream>
+#include <GL/glew.h>
+#include <SFML/Graphics.hpp>
+#include <math.h>
+#include "SuperSmartPointer.hpp"
+#include "StringID.hpp"
+#include "Math.hpp"
+#include "Sprite.hpp"
+#include "TextureAtlas.hpp"
+#include "DrawCommandList.hpp"
+#include "SpriteBatch.hpp"
+
+void DrawCommandList::AddGeometry(unsigned long Type, const sf::Texture *Texture, unsigned long Blending, const Vector2 *InVertices,
+	const Vector2 *InTexCoords, const Vector4 *InColors, unsigned long Count)
+{
+	if(Count == 0)
+		return;
+
+	if(Commands.size() == 0 || Commands.back().Type != Type || Commands.back().Texture != Texture ||
+		Commands.back().Blending != Blending)
+	{
+		DrawCommand Command;
+		Command.Type = Type;
+		Command.Texture = Texture;
+		Command.Blending = Blending;
+		Command.First = Vertices.size();
+
+		Commands.push_back(Command);
+	};
+
+	Commands.back().Count += Count;
+
+	Vertices.insert(Vertices.end(), InVertices, InVertices + Count);
+	TexCoords.insert(TexCoords.end(), InTexCoords, InTexCoords + Count);
+	Colors.insert(Colors.end(), InColors, InColors + Count);
+};
+
+void DrawCommandList::AddPushScissor(const Rect &Area, float TargetHeight)
+{
+	DrawCommand Command;
+	Command.Type = DrawCommandType::PushScissor;
+	Command.Area = Area;
+	Command.TargetHeight = TargetHeight;
+
+	Commands.push_back(Command);
+};
+
+void DrawCommandList::AddPopScissor()
+{
+	DrawCommand Command;
+	Command.Type = DrawCommandType::PopScissor;
+
+	Commands.push_back(Command);
+};
+
+void DrawCommandList::Replay() const
+{
+	for(unsigned long i = 0; i < Commands.size(); i++)
+	{
+		const DrawCommand &Command = Commands[i];
+
+		switch(Command.Type)
+		{
+		case DrawCommandType::PushScissor:
+			SpriteBatch::Instance.PushScissor(Command.Area, Command.TargetHeight);
+
+			break;
+		case DrawCommandType::PopScissor:
+			SpriteBatch::Instance.PopScissor();
+
+			break;
+		default:
+			SpriteBatch::Instance.AddGeometry(Command.Type, Command.Texture, Command.Blending, &Vertices[Command.First],
+				&TexCoords[Command.First], &Colors[Command.First], Command.Count);
+
+			break;
+		};
+	};
+};
+
+void DrawCommandList::Clear()
+{
+	Commands.clear();
+	Vertices.clear();
+	TexCoords.clear();
+	Colors.clear();
+};
+
+std::string DrawCommandList::Dump() const
+{
+	static const char *TypeNames[] = { "Geometry", "SolidRect", "Text", "PushScissor", "PopScissor" };
+
+	std::stringstream Out;
+
+	for(unsigned long i = 0; i < Commands.size(); i++)
+	{
+		const DrawCommand &Command = Commands[i];
+
+		Out << TypeNames[Command.Type];
+
+		if(Command.Type == DrawCommandType::PushScissor)
+		{
+			Out << " (" << Command.Area.Left << ", " << Command.Area.Top << ")-(" << Command.Area.Right << ", " << Command.Area.Bottom << ")";
+		}
+		else if(Command.Type != DrawCommandType::PopScissor)
+		{
+			Vector2 Min = Vertices[Command.First], Max = Min;
+
+			for(unsigned long j = Command.First + 1; j < Command.First + Command.Count; j++)
+			{
+				Min.x = Vertices[j].x < Min.x ? Vertices[j].x : Min.x;
+				Min.y = Vertices[j].y < Min.y ? Vertices[j].y : Min.y;
+				Max.x = Vertices[j].x > Max.x ? Vertices[j].x : Max.x;
+				Max.y = Vertices[j].y > Max.y ? Vertices[j].y : Max.y;
+			};
+
+			//Triangle lists, so every quad has 6 vertices
+			Out << " Texture=" << Command.Texture << " Blending=" << Command.Blending << " Quads=" << Command.Count / 6 <<
+				" Bounds=(" << Min.x << ", " << Min.y << ")-(" << Max.x << ", " << Max.y << ")";
+
+			if(Command.Type == DrawCommandType::SolidRect)
+			{
+				const Vector4 &Color = Colors[Command.First];
+
+				Out << " Color=(" << Color.x << ", " << Color.y << ", " << Color.z << ", " << Color.w << ")";
+			};
+		};
+
+		Out << "\n";
+	};
+
+	return Out.str();
+};
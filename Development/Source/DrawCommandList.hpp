@@ -0,0 +1,104 @@
+#pragma once
+
+namespace DrawCommandType
+{
+	enum
+	{
+		Geometry = 0,
+		SolidRect,
+		Text,
+		PushScissor,
+		PopScissor
+	};
+};
+
+/*!
+*	A single retained draw command
+*/
+class DrawCommand
+{
+public:
+	//!<One of DrawCommandType
+	unsigned long Type;
+	const sf::Texture *Texture;
+	unsigned long Blending;
+	//!<Range of the list's vertices used by this command
+	unsigned long First, Count;
+	//!<Area to scissor to (in pixels from the top left) and the height of the target, for PushScissor
+	Rect Area;
+	float TargetHeight;
+
+	DrawCommand() : Type(DrawCommandType::Geometry), Texture(NULL), Blending(0), First(0), Count(0), TargetHeight(0) {};
+};
+
+/*!
+*	Draw Command List
+*	Retains what was sent to the SpriteBatch so it can be sent again without regenerating it
+*	\note Geometry is stored before atlas remapping, so replaying follows the current atlas
+*	\sa SpriteBatch::SetRecorder
+*/
+class DrawCommandList
+{
+private:
+	std::vector<DrawCommand> Commands;
+	std::vector<Vector2> Vertices, TexCoords;
+	std::vector<Vector4> Colors;
+public:
+	/*!
+	*	Appends geometry, merging it with the last command if they'd be drawn the same way
+	*	\param Type one of DrawCommandType (Geometry, SolidRect, or Text)
+	*	\param Texture the texture to use (or NULL)
+	*	\param Blending the BlendingMode to use
+	*	\param InVertices the vertices (in triangle list order)
+	*	\param InTexCoords the texture coordinates of each vertex
+	*	\param InColors the color of each vertex
+	*	\param Count the amount of vertices
+	*/
+	void AddGeometry(unsigned long Type, const sf::Texture *Texture, unsigned long Blending, const Vector2 *InVertices,
+		const Vector2 *InTexCoords, const Vector4 *InColors, unsigned long Count);
+
+	/*!
+	*	Appends a scissor push
+	*	\param Area the area to scissor to, in pixels from the top left
+	*	\param TargetHeight the height of the render target
+	*/
+	void AddPushScissor(const Rect &Area, float TargetHeight);
+
+	/*!
+	*	Appends a scissor pop
+	*/
+	void AddPopScissor();
+
+	/*!
+	*	Sends every command to the SpriteBatch again
+	*/
+	void Replay() const;
+
+	/*!
+	*	Removes every command
+	*	\note Keeps the buffers' capacity, since lists are usually re-recorded with similar contents
+	*/
+	void Clear();
+
+	/*!
+	*	\return the amount of commands
+	*/
+	unsigned long GetCommandCount() const
+	{
+		return Commands.size();
+	};
+
+	/*!
+	*	\return the amount of vertices in all commands
+	*/
+	unsigned long GetVertexCount() const
+	{
+		return Vertices.size();
+	};
+
+	/*!
+	*	Describes every command, one per line
+	*	\return the description
+	*/
+	std::string Dump() const;
+};
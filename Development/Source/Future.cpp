@@ -1,5 +1,6 @@
 #include <map>
 #include <vector>
+#include <algorithm>
 #include <SFML/System.hpp>
 #include "StringID.hpp"
 #include "SuperSmartPointer.hpp"
@@ -10,48 +11,131 @@ using namespace Gallant;
 
 Future Future::Instance;
 
+Future::~Future()
+{
+	for(std::map<FutureHandle, FutureCallback *>::iterator it = Pending.begin(); it != Pending.end(); it++)
+	{
+		delete it->second;
+	};
+
+	for(unsigned long i = 0; i < Inbox.size(); i++)
+	{
+		delete Inbox[i];
+	};
+};
+
+unsigned long long Future::GetTime() const
+{
+	//sf::Clock is monotonic
+	return Clock.getElapsedTime().asMicroseconds() / 1000;
+};
+
+void Future::DiscardCancelled()
+{
+	while(Queue.size() && Pending.find(Queue.front().Handle) == Pending.end())
+	{
+		std::pop_heap(Queue.begin(), Queue.end());
+		Queue.pop_back();
+	};
+};
+
 void Future::Update()
 {
-	bool Found = true;
+	std::vector<FutureCallback *> Posted;
 
-	while(Found)
 	{
-		Found = false;
+		sf::Lock Lock(InboxLock);
 
-		for(long i = Futures.size() - 1; i >= 0; i--)
-		{
-			if(time(NULL) - Futures[i].StartTime >= Futures[i].Length)
-			{
-				Futures[i].Signal(Futures[i].Stream);
+		Posted.swap(Inbox);
+	};
+
+	for(unsigned long i = 0; i < Posted.size(); i++)
+	{
+		PostCallback(Posted[i]);
+	};
+
+	unsigned long long Now = GetTime();
+
+	while(Queue.size() && Queue.front().Due <= Now)
+	{
+		FutureHandle Handle = Queue.front().Handle;
+
+		std::pop_heap(Queue.begin(), Queue.end());
+		Queue.pop_back();
 
-				Futures.erase(Futures.begin() + i);
+		std::map<FutureHandle, FutureCallback *>::iterator it = Pending.find(Handle);
 
-				Found = true;
+		if(it == Pending.end())
+			continue;
 
-				break;
-			};
+		//Remove it first so the callback can't cancel itself
+		FutureCallback *Callback = it->second;
+		Pending.erase(it);
+
+		Callback->Call();
+
+		delete Callback;
+	};
+
+	DiscardCancelled();
+};
+
+bool Future::GetTimeUntilNext(unsigned long &Milliseconds) const
+{
+	{
+		sf::Lock Lock(InboxLock);
+
+		if(Inbox.size())
+		{
+			Milliseconds = 0;
+
+			return true;
 		};
 	};
+
+	if(Queue.size() == 0)
+		return false;
+
+	unsigned long long Now = GetTime(), Next = Queue.front().Due;
+
+	Milliseconds = Next > Now ? (unsigned long)(Next - Now) : 0;
+
+	return true;
+};
+
+FutureHandle Future::PostCallback(FutureCallback *Callback, unsigned long Delay)
+{
+	FutureInfo Info;
+	Info.Due = GetTime() + Delay;
+	Info.Handle = NextHandle++;
+
+	Pending[Info.Handle] = Callback;
+
+	Queue.push_back(Info);
+	std::push_heap(Queue.begin(), Queue.end());
+
+	return Info.Handle;
 };
 
-void Future::Post(FutureFn Ptr, const std::vector<unsigned char> &Stream)
+void Future::PostFromThread(FutureCallback *Callback)
 {
-	FutureInfo Future;
-	Future.StartTime = time(NULL);
-	Future.Length = 0;
-	Future.Stream = Stream;
-	Future.Signal.Connect(Ptr);
+	sf::Lock Lock(InboxLock);
 
-	Futures.push_back(Future);
+	Inbox.push_back(Callback);
 };
 
-void Future::PostDelayed(FutureFn Ptr, unsigned long Length, const std::vector<unsigned char> &Stream)
+bool Future::Cancel(FutureHandle Handle)
 {
-	FutureInfo Future;
-	Future.StartTime = time(NULL);
-	Future.Length = Length;
-	Future.Stream = Stream;
-	Future.Signal.Connect(Ptr);
+	std::map<FutureHandle, FutureCallback *>::iterator it = Pending.find(Handle);
+
+	if(it == Pending.end())
+		return false;
+
+	delete it->second;
+	Pending.erase(it);
+
+	//Its queue entry is skipped when it reaches the top
+	DiscardCancelled();
 
-	Futures.push_back(Future);
+	return true;
 };
@@ -1,48 +1,179 @@
 #pragma once
 
+/*!
+*	A callback owned by Future
+*	\note Not copyable; Future takes ownership of it when posted and deletes it after it runs or is cancelled
+*/
+class FutureCallback
+{
+private:
+	FutureCallback(const FutureCallback &);
+	FutureCallback &operator=(const FutureCallback &);
+public:
+	FutureCallback() {};
+	virtual ~FutureCallback() {};
+
+	virtual void Call() = 0;
+};
+
+template<class Function>
+class FutureFunctionCallback : public FutureCallback
+{
+	Function Ptr;
+public:
+	FutureFunctionCallback(Function Ptr) : Ptr(Ptr) {};
+
+	void Call()
+	{
+		Ptr();
+	};
+};
+
+template<class Function, class Argument>
+class FutureFunctionArgumentCallback : public FutureCallback
+{
+	Function Ptr;
+	Argument Value;
+public:
+	FutureFunctionArgumentCallback(Function Ptr, const Argument &Value) : Ptr(Ptr), Value(Value) {};
+
+	void Call()
+	{
+		Ptr(Value);
+	};
+};
+
+template<class Class>
+class FutureMemberCallback : public FutureCallback
+{
+	Class *Instance;
+	void (Class::*Function)();
+public:
+	FutureMemberCallback(Class *Instance, void (Class::*Function)()) : Instance(Instance), Function(Function) {};
+
+	void Call()
+	{
+		(Instance->*Function)();
+	};
+};
+
+template<class Class, class Argument>
+class FutureMemberArgumentCallback : public FutureCallback
+{
+	Class *Instance;
+	void (Class::*Function)(Argument);
+	Argument Value;
+public:
+	FutureMemberArgumentCallback(Class *Instance, void (Class::*Function)(Argument), const Argument &Value) : Instance(Instance),
+		Function(Function), Value(Value) {};
+
+	void Call()
+	{
+		(Instance->*Function)(Value);
+	};
+};
+
+//!<Identifies a posted callback so it can be cancelled. 0 is never used
+typedef unsigned long long FutureHandle;
+
+/*!
+*	Future
+*	Runs callbacks after a delay, in milliseconds
+*	\note Due callbacks are kept in a min-heap, so posting, firing, and cancelling are O(log n)
+*/
 class Future
 {
 	struct FutureInfo
 	{
-		unsigned long long StartTime;
-		unsigned long Length;
-		std::vector<unsigned char> Stream;
+		//!<When it's due, in milliseconds since the Future was created
+		unsigned long long Due;
+		//!<Also breaks ties, so callbacks due at the same time run in the order they were posted
+		FutureHandle Handle;
 
-		Signal1<std::vector<unsigned char> &> Signal;
+		//!<Orders the heap so the earliest callback is on top
+		bool operator<(const FutureInfo &o) const
+		{
+			return Due != o.Due ? Due > o.Due : Handle > o.Handle;
+		};
 	};
 
-	std::vector<FutureInfo> Futures;
-public:
-	typedef void (*FutureFn)(std::vector<unsigned char> &Arguments);
+	std::vector<FutureInfo> Queue;
+	//!<Callbacks that haven't run or been cancelled yet
+	std::map<FutureHandle, FutureCallback *> Pending;
+	FutureHandle NextHandle;
+	sf::Clock Clock;
+	//!<Callbacks posted from other threads, moved to the queue on Update
+	std::vector<FutureCallback *> Inbox;
+	mutable sf::Mutex InboxLock;
 
+	Future(const Future &);
+	Future &operator=(const Future &);
+
+	unsigned long long GetTime() const;
+
+	/*!
+	*	Removes cancelled callbacks from the top of the queue, so the top is always pending
+	*/
+	void DiscardCancelled();
+public:
 	static Future Instance;
 
+	Future() : NextHandle(1) {};
+	~Future();
+
+	/*!
+	*	Runs every callback that is due
+	*	\note Callbacks posted while running with no delay will run during this Update
+	*/
 	void Update();
 
-	void Post(FutureFn Ptr, const std::vector<unsigned char> &Stream = std::vector<unsigned char>());
+	/*!
+	*	Gets how long until the next Future is due
+	*	\param Milliseconds receives the time left, or 0 if a Future is already due
+	*	\return whether there are any Futures
+	*/
+	bool GetTimeUntilNext(unsigned long &Milliseconds) const;
+
+	/*!
+	*	Posts a callback
+	*	\param Callback the callback to run, which the Future now owns
+	*	\param Delay how long to wait before running it, in milliseconds
+	*	\return the handle to cancel it with
+	*/
+	FutureHandle PostCallback(FutureCallback *Callback, unsigned long Delay = 0);
+
+	/*!
+	*	Posts a callback from another thread, to run on the next Update
+	*	\param Callback the callback to run, which the Future now owns
+	*	\note This is the only method that can be called from other threads
+	*/
+	void PostFromThread(FutureCallback *Callback);
 
-	void PostDelayed(FutureFn Ptr, unsigned long Delay = 0, const std::vector<unsigned char> &Stream = std::vector<unsigned char>());
-	
-	template<class Class> void Post(Class *Instance, void (Class::*Function)(std::vector<unsigned char> &Arguments), const std::vector<unsigned char> &Stream = std::vector<unsigned char>())
+	/*!
+	*	Cancels a callback that didn't run yet
+	*	\param Handle the handle returned when it was posted
+	*	\return whether it was pending
+	*/
+	bool Cancel(FutureHandle Handle);
+
+	template<class Function> FutureHandle Post(Function Ptr, unsigned long Delay = 0)
 	{
-		FutureInfo Future;
-		Future.StartTime = time(NULL);
-		Future.Length = 0;
-		Future.Stream = Stream;
-		Future.Signal.Connect(Instance, Function);
+		return PostCallback(new FutureFunctionCallback<Function>(Ptr), Delay);
+	};
 
-		Futures.push_back(Future);
+	template<class Function, class Argument> FutureHandle PostWithArgument(Function Ptr, const Argument &Value, unsigned long Delay = 0)
+	{
+		return PostCallback(new FutureFunctionArgumentCallback<Function, Argument>(Ptr, Value), Delay);
 	};
 
-	template<class Class> void PostDelayed(Class *Instance, void (Class::*Function)(std::vector<unsigned char> &Arguments),
-		unsigned long Length, const std::vector<unsigned char> &Stream = std::vector<unsigned char>())
+	template<class Class> FutureHandle Post(Class *Instance, void (Class::*Function)(), unsigned long Delay = 0)
 	{
-		FutureInfo Future;
-		Future.StartTime = time(NULL);
-		Future.Length = Length;
-		Future.Stream = Stream;
-		Future.Signal.Connect(Instance, Function);
+		return PostCallback(new FutureMemberCallback<Class>(Instance, Function), Delay);
+	};
 
-		Futures.push_back(Future);
+	template<class Class, class Argument> FutureHandle Post(Class *Instance, void (Class::*Function)(Argument), const Argument &Value,
+		unsigned long Delay = 0)
+	{
+		return PostCallback(new FutureMemberArgumentCallback<Class, Argument>(Instance, Function, Value), Delay);
 	};
 };
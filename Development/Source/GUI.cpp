@@ -2,6 +2,9 @@
 #include <SFML/Graphics.hpp>
 #include <json/json.h>
 #include <sstream>
+#include <algorithm>
+#include <list>
+#include <deque>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -15,8 +18,15 @@ using namespace Gallant;
 #include "Math.hpp"
 #include "Input.hpp"
 #include "Sprite.hpp"
+#include "TextureAtlas.hpp"
+#include "TextureCache.hpp"
+#include "DrawCommandList.hpp"
+#include "SpriteBatch.hpp"
+#include "TextEngine.hpp"
 #include "Future.hpp"
+#include "ThreadPool.hpp"
 #include "StringUtils.hpp"
+#include "GapBuffer.hpp"
 #include "GUI.hpp"
 
 Rect MeasureTextSimple(const sf::String &Str, sf::Font *Font,
@@ -29,14 +39,7 @@ Rect MeasureTextSimple(const sf::String &Str, sf::Font *Font,
 	if(Str.getSize() == 0)
 		return Rect(0, 0, 0, (float)FontSize);
 
-	sf::Text Text;
-	Text.setFont(*Font);
-	Text.setCharacterSize(FontSize);
-	Text.setString(Str);
-
-	sf::FloatRect InRect = Text.getLocalBounds();
-
-	return Rect(InRect.left, InRect.width, InRect.top, InRect.height);
+	return TextEngine::Instance.Measure(Str, Font, FontSize);
 };
 
 void FitTextAroundLength(const sf::String &Str, sf::Font *Font,
@@ -55,235 +58,13 @@ void FitTextAroundLength(const sf::String &Str, sf::Font *Font,
 	};
 };
 
-/*!
-*	Formatting logic:
-*	#1: Split Words and Lines
-*	#2: For each word, keep adding it together until you exceed either size.x or size.y
-*	#3: Check if we can recover by verifying if the old sentence works.
-*	If it does, add a new line and continue if the size.y is less than the text height.
-*/
-std::vector<sf::String> FitTextOnRect(const sf::String &String, sf::Font *Font,
-													   long FontSize, const Vector2 &Size)
-{
-	std::vector<sf::String> Lines;
-
-	std::wstring str = String.toWideString();
-
-	std::vector<std::wstring> Fragments;
-
-	//Extract Fragments
-
-	unsigned long Offset = 0, PreviousOffset = 0;
-
-	for(;;)
-	{
-		PreviousOffset = Offset;
-
-		long MatchSpace = str.find(L' ', PreviousOffset), MatchNewLine = str.find(L'\n', PreviousOffset);
-		long Match = std::wstring::npos;
-
-		if(MatchSpace != -1)
-		{
-			Match = MatchSpace;
-		};
-
-		if(MatchNewLine != -1 && (MatchSpace == -1 || MatchNewLine < MatchSpace))
-		{
-			Match = MatchNewLine;
-		};
-
-		if(Match == std::wstring::npos)
-		{
-			if(Offset < str.length())
-			{
-				Fragments.push_back(str.substr(Offset));
-			};
-
-			break;
-		};
-
-		if(Match - PreviousOffset > 0)
-		{
-			Fragments.push_back(str.substr(PreviousOffset, Match - PreviousOffset));
-
-			if(Match == MatchNewLine)
-				Fragments.push_back(L"\n");
-		}
-		else if(Match == MatchNewLine) //Add empty newlines
-		{
-			Fragments.push_back(L"\n");
-		};
-
-		Offset = Match + 1;
-	};
-
-	Vector2 CurrentSize;
-
-	std::wstringstream stream, stream2;
-
-	bool First = true;
-
-	std::wstring CurrentText;
-	long NewLineIndex = -1;
-
-	while(CurrentSize.y < Size.y)
-	{
-		if(!First)
-			stream << " ";
-
-		if(First)
-			First = false;
-
-		if(Fragments.size() && Fragments[0].at(0) != L'\n')
-			stream << Fragments[0];
-
-		if(Fragments.size() && ((NewLineIndex = Fragments[0].find(L'\n')) == 0 || NewLineIndex == 1))
-		{
-			if(!First)
-				stream.str(stream.str().substr(0, stream.str().length() - 1));
-
-			Lines.push_back(stream.str());
-
-			CurrentText += stream.str() + L"\n";
-
-			stream.str(L"");
-			stream2.str(L"");
-
-			Fragments.erase(Fragments.begin());
-
-			First = true;
-
-			continue;
-		};
-
-		CurrentSize = MeasureTextSimple(CurrentText + stream.str(), Font, FontSize).ToFullSize();
-
-		//Early-out
-		if(CurrentSize.y > Size.y)
-		{
-			return Lines;
-		};
-
-		if(CurrentSize.x > Size.x)
-		{
-			//Recover old sentence
-			if(stream2.str().length() != 0)
-				stream.str(stream2.str());
-
-			CurrentSize = MeasureTextSimple(stream.str(), Font, FontSize).ToFullSize();
-
-			if(CurrentSize.x > Size.x) //So by default it would exceed size
-			{
-				return Lines;
-			};
-
-			//Verify the old text
-			CurrentSize = MeasureTextSimple(CurrentText + stream.str(), Font, FontSize).ToFullSize();
-
-			bool IgnoreNewLine = CurrentText.length() && CurrentText[CurrentText.length() - 1] == '\n';
-
-			if(!IgnoreNewLine)
-			{
-				//Remove extra space
-				if(!First)
-				{
-					CurrentText = CurrentText.substr(0, CurrentText.length() - 1);
-				};
-
-				CurrentText += L"\n";
-			};
-
-			//If we added text, add that line to our Lines and reset everything
-			if(stream.str().length())
-			{
-				Lines.push_back(stream.str());
-
-				stream.str(L"");
-				stream2.str(L"");
-			};
-
-			stream.str(L"");
-			stream2.str(L"");
-
-			First = true;
-
-			continue;
-		};
-
-		//Save the last working text here
-		if(Fragments.size())
-		{
-			stream2.str(stream.str());
-
-			Fragments.erase(Fragments.begin());
-		}
-		else //Final check here
-		{
-			CurrentSize = MeasureTextSimple(CurrentText + stream.str(), Font, FontSize).ToFullSize();
-
-			if(CurrentSize.x > Size.x || CurrentSize.y > Size.y)
-			{
-				return Lines;
-			};
-
-			Lines.push_back(stream.str());
-
-			return Lines;
-		};
-	};
-
-	if(stream.str().length())
-		Lines.push_back(stream.str());
-
-	return Lines;
-};
-
 void RenderText(sf::RenderWindow &GameWindow, const sf::String &String, sf::Font *Font, unsigned long FontSize, TextParams Params)
 {
-	if(!Font)
+	//Glyphs can't be loaded without a GL context
+	if(!Font || SpriteBatch::Instance.IsHeadless())
 		return;
 
-	Vector2 ActualPosition = Params.PositionValue;
-
-	GameWindow.pushGLStates();
-
-	const_cast<sf::Texture &>(Font->getTexture(FontSize)).setSmooth(false);
-
-	static sf::Text Text;
-
-	if(Text.getFont() != Font)
-		Text.setFont(*Font);
-
-	if(Text.getCharacterSize() != FontSize)
-		Text.setCharacterSize(FontSize);
-
-	sf::Color ActualTextColor((unsigned char)(Params.TextColorValue.x * 255),
-		(unsigned char)(Params.TextColorValue.y * 255),
-		(unsigned char)(Params.TextColorValue.z * 255),
-		(unsigned char)(Params.TextColorValue.w * 255));
-
-	Text.setPosition(ActualPosition.x, ActualPosition.y);
-	Text.setColor(ActualTextColor);
-
-	if(Text.getString() != String)
-		Text.setString(String);
-
-	GameWindow.draw(Text);
-
-	GameWindow.popGLStates();
-
-	//SFML 2 BUG
-	glMatrixMode(GL_MODELVIEW);
-};
-
-SuperSmartPointer<sf::Texture> LoadTexture(const std::string &FileName)
-{
-	SuperSmartPointer<sf::Texture> Out(new sf::Texture());
-
-	if(!Out->loadFromFile(FileName))
-		Out.Dispose();
-
-	return Out;
+	TextEngine::Instance.Draw(String, Font, FontSize, Params);
 };
 
 UILayout::~UILayout()
@@ -424,10 +205,18 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 		{
 			Panel.Reset(new UITextBox(this));
 		}
+		else if(Control == "TEXTEDITOR")
+		{
+			Panel.Reset(new UITextEditor(this));
+		}
 		else if(Control == "LIST")
 		{
 			Panel.Reset(new UIList(this));
 		}
+		else if(Control == "TREE")
+		{
+			Panel.Reset(new UITreeView(this));
+		}
 		else if(Control == "SCROLLABLEFRAME")
 		{
 			Panel.Reset(new UIScrollableFrame(this));
@@ -460,7 +249,8 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 			MouseInputEnabledValue = Data.get("MouseInput", Json::Value(true)),
 			AlphaValue = Data.get("Opacity", Json::Value(1.0)),
 			VisibleValue = Data.get("Visible", Json::Value(true)),
-			BlockingInputValue = Data.get("BlockingInput", Json::Value(false));
+			BlockingInputValue = Data.get("BlockingInput", Json::Value(false)),
+			CacheAsLayerValue = Data.get("CacheAsLayer", Json::Value(false));
 
 		if(EnabledValue.isBool())
 		{
@@ -516,6 +306,15 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 			CHECKJSONVALUE(BlockingInputValue, bool);
 		};
 
+		if(CacheAsLayerValue.isBool())
+		{
+			Panel->SetCacheAsLayer(CacheAsLayerValue.asBool());
+		}
+		else
+		{
+			CHECKJSONVALUE(CacheAsLayerValue, bool);
+		};
+
 		float x, y, w, h;
 
 		Vector2 ParentSize = Parent ? Parent->GetSize() : Vector2((float)GetOwner()->getSize().x, (float)GetOwner()->getSize().y);
@@ -581,6 +380,7 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 			if(Value.isString())
 			{
 				Button->Caption = Value.asString();
+				Button->InvalidateLayout();
 			}
 			else
 			{
@@ -620,6 +420,7 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 			if(Value.isString())
 			{
 				Panel.AsDerived<UICheckBox>()->Caption = Value.asString();
+				Panel->InvalidateLayout();
 			}
 			else
 			{
@@ -641,24 +442,8 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 				}
 				else
 				{
-					SuperSmartPointer<sf::Texture> SpriteTexture = LoadTexture(FileName);
-
-					if(!SpriteTexture.Get())
-					{
-						printf("Unable to load texture '%s' for UI Sprite '%s' on Layout '%s'", FileName.c_str(), ElementName.c_str(),
-							TheLayout->Name.c_str());
-					}
-					else
-					{
-						TheSprite->TheSprite.SpriteTexture = SpriteTexture;
-						TheSprite->TheSprite.Options.Scale(Panel->GetSize() != Vector2() ? Panel->GetSize() /
-							Vector2(SpriteTexture->getSize().x, SpriteTexture->getSize().y) : Vector2(1, 1));
-
-						if(TheSprite->GetSize() == Vector2())
-						{
-							TheSprite->SetSize(Vector2((float)SpriteTexture->getSize().x, (float)SpriteTexture->getSize().y));
-						};
-					};
+					//Decoded in the background, UISprite fits itself to it once it's uploaded
+					TheSprite->SetTexture(Textures.GetAsync(FileName));
 				};
 			}
 			else
@@ -678,9 +463,7 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 
 					sscanf(CropTiledString.c_str(), "%f, %f, %f, %f", &FrameSize.x, &FrameSize.y, &FrameID.x, &FrameID.y);
 
-					TheSprite->TheSprite.Options.Scale(FrameSize / Vector2(TheSprite->TheSprite.SpriteTexture->getSize().x,
-						TheSprite->TheSprite.SpriteTexture->getSize().y)).Crop(CropMode::CropTiled,
-						Rect(FrameSize.x, FrameID.x, FrameSize.y, FrameID.y));
+					TheSprite->TheSprite.Options.Crop(CropMode::CropTiled, Rect(FrameSize.x, FrameID.x, FrameSize.y, FrameID.y));
 				};
 			}
 			else
@@ -701,7 +484,7 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 					sscanf(NinePatchString.c_str(), "%f,%f,%f,%f", &NinePatchRect.Left, &NinePatchRect.Right, &NinePatchRect.Top,
 						&NinePatchRect.Bottom);
 
-					TheSprite->TheSprite.Options.NinePatch(true, NinePatchRect).Scale(Panel->GetSize());
+					TheSprite->TheSprite.Options.NinePatch(true, NinePatchRect);
 				};
 			}
 			else
@@ -903,6 +686,32 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 			TheTextBox->FontSize = FontSize;
 			TheTextBox->SetText(Text);
 		}
+		else if(Control == "TEXTEDITOR")
+		{
+			UITextEditor *TheTextEditor = Panel.AsDerived<UITextEditor>();
+
+			Value = Data.get("Text", Json::Value(""));
+
+			if(Value.isString())
+			{
+				TheTextEditor->SetText(Value.asString());
+			}
+			else
+			{
+				CHECKJSONVALUE(Value, string);
+			};
+
+			Value = Data.get("FontSize", Json::Value((Json::Value::Int)TheTextEditor->FontSize));
+
+			if(Value.isInt())
+			{
+				TheTextEditor->FontSize = Value.asInt();
+			}
+			else
+			{
+				CHECKJSONVALUE(Value, int);
+			};
+		}
 		else if(Control == "LIST")
 		{
 			UIList *TheList = Panel.AsDerived<UIList>();
@@ -936,6 +745,17 @@ void UIManager::CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json
 			};
 
 			TheList->FontSize = FontSize;
+
+			Value = Data.get("Virtualized", Json::Value(false));
+
+			if(Value.isBool())
+			{
+				TheList->SetVirtualized(Value.asBool());
+			}
+			else
+			{
+				CHECKJSONVALUE(Value, bool);
+			};
 		}
 		else if(Control == "LAYOUT")
 		{
@@ -1150,20 +970,6 @@ void UIManager::ClearLayouts()
 	};
 };
 
-void RemoveElementFuture(std::vector<unsigned char> &Stream)
-{
-	StringID ID = 0;
-	UIManager *Manager = NULL;
-	unsigned long ManagerAddr = 0;
-
-	memcpy(&Stream[0], &ID, sizeof(StringID));
-	memcpy(&Stream[sizeof(StringID)], &Manager, sizeof(UIManager *));
-
-	Manager = (UIManager *)ManagerAddr;
-
-	Manager->RemoveElement(ID);
-};
-
 void UIPanel::AddChildren(UIPanel *Child)
 {
 	if(Child->Manager != Manager)
@@ -1176,1970 +982,4260 @@ void UIPanel::AddChildren(UIPanel *Child)
 
 	Children.push_back(Child);
 	Child->ParentValue = GetManager()->GetElement(ID);
+
+	//Child is no longer a root element
+	Manager->DrawOrderCacheDirty = true;
+	InvalidateHitTest();
+
+	//Our parents may be clean even if the child isn't, so force the invalidation up the new chain
+	Child->LayoutDirty = false;
+	Child->InvalidateLayout();
+	Child->InvalidateTransform();
 };
 
-void UIPanel::Clear()
+void UIPanel::RemoveChild(UIPanel *Child)
 {
-	while(Children.size())
+	for(std::vector<UIPanel *>::iterator it = Children.begin(); it != Children.end(); it++)
 	{
-		unsigned long OldSize = Children.size();
+		if(*it == Child)
+		{
+			Child->ParentValue = SuperSmartPointer<UIPanel>();
+			Children.erase(it);
 
-		Manager->RemoveElement(Children[0]->GetID());
+			//Child is a root element now
+			Manager->DrawOrderCacheDirty = true;
+			InvalidateHitTest();
 
-		unsigned long NewSize = Children.size();
+			InvalidateLayout();
+			Child->InvalidateTransform();
 
-		if(NewSize == OldSize)
-			Children.erase(Children.begin());
+			return;
+		};
 	};
 };
 
-UIPanel::~UIPanel()
+void UIPanel::InvalidateHitTest()
 {
-	if(ParentValue)
-		ParentValue->RemoveChild(this);
+	Manager->HitTestIndexDirty = true;
+};
 
-	GetManager()->RemoveElement(ID);
+void UIPanel::InvalidateHitTestBounds()
+{
+	//The whole index is being rebuilt anyway
+	if(Manager->HitTestIndexDirty)
+		return;
 
-	Clear();
+	Manager->HitTestMovedElements.push_back(this);
 };
 
-void UIFrame::OnSkinChange()
+void UIPanel::Damage()
 {
-	std::string TexturePath = Skin->GetString("Frame", "BackgroundTexture");
+	//Our root's retained draw commands, and the layers of anything we're in, no longer match what we'd draw
+	UIPanel *Root = this;
 
-	BackgroundTexture = LoadTexture(TexturePath);
+	Root->LayerDirty = true;
 
-	std::string NinePatchRectValue = Skin->GetString("Frame", "TextureRect");
+	while(Root->GetParent())
+	{
+		Root = Root->GetParent();
+		Root->LayerDirty = true;
+	};
 
-	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
-		&TextureRect.Top, &TextureRect.Bottom);
+	Root->DrawCommandsDirty = true;
 
-	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
-};
+	if(!Manager->DamageTrackingValue)
+		return;
 
-void UIFrame::Update(const Vector2 &ParentPosition)
-{
-	for(unsigned long i = 0; i < Children.size(); i++)
-	{
-		Children[i]->Update(ParentPosition + PositionValue);
-	};
+	Manager->AddDamage(GetDrawArea());
 };
 
-void UIFrame::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+void UIPanel::SetCacheAsLayer(bool Value)
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue;
-
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
+	if(CacheAsLayerValue == Value)
 		return;
 
-	Sprite TheSprite;
-	TheSprite.SpriteTexture = BackgroundTexture;
-	TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(SizeValue);
+	CacheAsLayerValue = Value;
 
-	TheSprite.Draw(Renderer);
+	if(!Value)
+		Layer.Dispose();
 
-	for(unsigned long i = 0; i < Children.size(); i++)
-	{
-		if(Children[i]->IsVisible())
-			Children[i]->Draw(ActualPosition, Renderer);
-	};
+	Damage();
 };
 
-void UIButton::OnSkinChange()
+void UIPanel::DrawLayered(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
 {
-	std::string TexturePath = Skin->GetString("Button", "BackgroundTexture");
+	if(!CacheAsLayerValue || SpriteBatch::Instance.IsHeadless())
+	{
+		Draw(ParentPosition, Renderer);
 
-	NormalTexture = LoadTexture(TexturePath);
+		return;
+	};
 
-	TexturePath = Skin->GetString("Button", "FocusedTexture");
+	if(!IsVisible() || AlphaValue == 0)
+		return;
 
-	FocusedTexture = LoadTexture(TexturePath);
+	//Our draw area may start before our position (selection boxes, window borders, etc), so we're offset inside the layer
+	Rect Area = GetDrawArea();
+	Vector2 LayerPosition(floorf(Area.Left), floorf(Area.Top));
+	Vector2 Offset = GetAbsolutePosition() - LayerPosition;
+	unsigned long Width = (unsigned long)(ceilf(Area.Right) - LayerPosition.x), Height = (unsigned long)(ceilf(Area.Bottom) - LayerPosition.y);
 
-	std::string NinePatchRectValue = Skin->GetString("Button", "TextureRect");
+	Vector2 Position = ParentPosition + PositionValue - Offset, Size((float)Width, (float)Height);
 
-	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
-		&TextureRect.Top, &TextureRect.Bottom);
+	//Scissored away layers are left as they are until they're visible again
+	if(Width == 0 || Height == 0 || SpriteBatch::Instance.IsClipped(Rect(Position.x, Position.x + Size.x, Position.y, Position.y + Size.y)))
+		return;
 
-	std::string FontSizeValue = Skin->GetString("Button", "FontSize");
+	if(Layer.Get() == NULL || Layer->getSize().x != Width || Layer->getSize().y != Height)
+	{
+		Layer.Reset(new sf::RenderTexture());
 
-	sscanf(FontSizeValue.c_str(), "%u", &FontSize);
+		//Falls back to a separate context when framebuffer objects aren't supported
+		if(!Layer->create(Width, Height))
+		{
+			printf("Failed to create a %lux%lu layer for a widget, drawing it directly\n", Width, Height);
 
-	std::string FontColorValue = Skin->GetString("Button", "FontColor");
+			Layer.Dispose();
+			CacheAsLayerValue = false;
 
-	sscanf(FontColorValue.c_str(), "%f,%f,%f,%f", &FontColor.x, &FontColor.y, &FontColor.z, &FontColor.w);
+			Draw(ParentPosition, Renderer);
 
-	std::string LabelOffsetValue = Skin->GetString("Button", "LabelOffset");
+			return;
+		};
 
-	sscanf(LabelOffsetValue.c_str(), "%f,%f", &LabelOffset.x, &LabelOffset.y);
+		LayerDirty = true;
+	};
 
-	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
-};
+	if(LayerDirty)
+	{
+		LayerDirty = false;
 
-void UIButton::PerformLayout()
-{
-	Rect Size = MeasureTextSimple(Caption, Manager->GetDefaultFont(), FontSize);
+		float Alpha = AlphaValue;
+		AlphaValue = 1;
 
-	Vector2 ActualSize = Size.Position() + Size.Size();
+		SpriteBatch::Instance.BeginTarget(Layer, Renderer);
+		Draw(Offset - PositionValue, Renderer);
+		SpriteBatch::Instance.EndTarget();
 
-	if(ActualSize.x > SizeValue.x)
-	{
-		SizeValue.x = ActualSize.x + 10;
+		AlphaValue = Alpha;
 	};
 
-	if(ActualSize.y > SizeValue.y)
-	{
-		SizeValue.y = ActualSize.y + 10;
+	Vector2 Vertices[6] = {
+		Position,
+		Position + Vector2(0, Size.y),
+		Position + Size,
+		Position + Size,
+		Position + Vector2(Size.x, 0),
+		Position
+	};
+
+	//Render textures are stored bottom to top
+	Vector2 TexCoords[6] = {
+		Vector2(0, 1),
+		Vector2(0, 0),
+		Vector2(1, 0),
+		Vector2(1, 0),
+		Vector2(1, 1),
+		Vector2(0, 1)
 	};
+
+	Vector4 Color(AlphaValue, AlphaValue, AlphaValue, AlphaValue);
+
+	Vector4 Colors[6] = {
+		Color, Color, Color, Color, Color, Color
+	};
+
+	SpriteBatch::Instance.Add(&Layer->getTexture(), BlendingMode::Premultiplied, Vertices, TexCoords, Colors, 6);
 };
 
-void UIButton::Update(const Vector2 &ParentPosition)
+Rect UIPanel::GetDrawArea()
 {
-	PerformLayout();
+	Vector2 Min = GetAbsolutePosition() - SelectBoxExtraSize / 2, Max = Min + SizeValue + SelectBoxExtraSize;
+
+	return Rect(Min.x, Max.x, Min.y, Max.y);
 };
 
-void UIButton::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+bool UIPanel::IsCulled(const Vector2 &ActualPosition, sf::RenderWindow *Renderer)
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+	//Our draw area is where we are on screen, but we may be drawn elsewhere (such as inside a layer)
+	Rect Area = GetDrawArea();
+	Vector2 Offset = ActualPosition - GetAbsolutePosition();
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x || ActualPosition.y + SizeValue.y < 0 ||
-		ActualPosition.y > Renderer->getSize().y))
-		return;
+	Area.Left += Offset.x;
+	Area.Right += Offset.x;
+	Area.Top += Offset.y;
+	Area.Bottom += Offset.y;
 
-	Rect Size = MeasureTextSimple(Caption, Manager->GetDefaultFont(), FontSize);
+	return Area.Right < 0 || Area.Left > Renderer->getSize().x || Area.Bottom < 0 || Area.Top > Renderer->getSize().y ||
+		SpriteBatch::Instance.IsClipped(Area);
+};
 
-	Vector2 ActualSize = Size.ToFullSize();
+void UIPanel::InvalidateTransform()
+{
+	InvalidateHitTestBounds();
 
-	Sprite TheSprite;
-	TheSprite.SpriteTexture = ClickPressed ? FocusedTexture : NormalTexture;
-	TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(SizeValue);
+	//Our children compare against this to know they're out of date
+	TransformVersion++;
 
-	TheSprite.Draw(Renderer);
+	for(UIPanel *p = this; p != NULL && !p->TransformPending; p = p->GetParent())
+	{
+		p->TransformPending = true;
+	};
 
-	//Not /2'ing the Y axis because it works better this way for some reason
-	Vector2 Offset = Vector2((SizeValue.x - ActualSize.x) / 2 + LabelOffset.x, LabelOffset.y);
+	if(TransformDirty)
+		return;
 
-	RenderText(*Renderer, Caption, Manager->GetDefaultFont(), FontSize,
-		TextParams().Color(FontColor).Position(ActualPosition + Offset));
+	//Wherever we were drawn must be cleared
+	Damage();
 
-	glColor4f(1, 1, 1, 1);
+	TransformDirty = true;
 };
 
-UITextBox::UITextBox(UIManager *Manager) : UIPanel(Manager), FontSize(12), CursorPosition(0),
-	TextOffset(0)
+void UIPanel::InvalidateChildTransforms()
 {
-	OnMouseJustPressed.Connect(this, &UITextBox::OnMouseJustPressedTextBox);
-	OnKeyJustPressed.Connect(this, &UITextBox::OnKeyJustPressedTextBox);
-	OnCharacterEntered.Connect(this, &UITextBox::OnCharacterEnteredTextBox);
+	InvalidateHitTestBounds();
+
+	TransformVersion++;
+
+	//Where our children were and will be drawn is inside our area
+	Damage();
 };
 
-void UITextBox::OnMouseJustPressedTextBox(UIPanel *This, const InputCenter::MouseButtonInfo &o)
+void UIPanel::RefreshTransform()
 {
-	if(this == Manager->GetFocusedElement() && Text.getSize() > 0 && o.Name == sf::Mouse::Left)
+	UIPanel *Parent = GetParent();
+
+	if(Parent == NULL)
 	{
-		//Since we're already pressed, we must be inside it, so we just need to care about the X axis
+		if(!TransformDirty)
+			return;
+
+		AbsolutePositionValue = PositionValue;
+
+		//Unbounded
+		ClipRectValue = Rect(-999999999.f, 999999999.f, -999999999.f, 999999999.f);
+		ParentTransformVersion = 0;
+	}
+	else
+	{
+		Parent->RefreshTransform();
 
-		Vector2 ActualPosition = PositionValue + Vector2((float)Padding, 0) + GetParentPosition();
+		if(!TransformDirty && ParentTransformVersion == Parent->TransformVersion)
+			return;
 
-		std::wstring WideString = Text.toWideString();
+		Vector2 PreviousPosition = AbsolutePositionValue;
+		Rect PreviousClipRect = ClipRectValue;
 
-		if(IsPasswordValue)
-		{
-			std::wstringstream str;
+		AbsolutePositionValue = GetParentPosition() + PositionValue;
+		ClipRectValue = Parent->GetClipRect();
 
-			for(unsigned long i = 0; i < WideString.size(); i++)
-				str << "*";
+		Rect ContentRect;
 
-			WideString = str.str();
+		if(Parent->IsTranslatedChild(this) && Parent->GetContentClipRect(ContentRect))
+		{
+			ClipRectValue.Left = ClipRectValue.Left > ContentRect.Left ? ClipRectValue.Left : ContentRect.Left;
+			ClipRectValue.Right = ClipRectValue.Right < ContentRect.Right ? ClipRectValue.Right : ContentRect.Right;
+			ClipRectValue.Top = ClipRectValue.Top > ContentRect.Top ? ClipRectValue.Top : ContentRect.Top;
+			ClipRectValue.Bottom = ClipRectValue.Bottom < ContentRect.Bottom ? ClipRectValue.Bottom : ContentRect.Bottom;
 		};
 
-		unsigned long X = 0;
+		ParentTransformVersion = Parent->TransformVersion;
 
-		Rect TextSize = MeasureTextSimple(WideString.substr(TextOffset), Manager->GetDefaultFont(), FontSize);
+		//Our own children only need to catch up if we really changed
+		if(AbsolutePositionValue != PreviousPosition || ClipRectValue.Left != PreviousClipRect.Left ||
+			ClipRectValue.Right != PreviousClipRect.Right || ClipRectValue.Top != PreviousClipRect.Top ||
+			ClipRectValue.Bottom != PreviousClipRect.Bottom)
+			TransformVersion++;
+	};
 
-		for(unsigned long i = 0; i < WideString.length() - TextOffset; i++)
-		{
-			Vector2 Size = MeasureTextSimple(WideString.substr(TextOffset, i + 1),
-				Manager->GetDefaultFont(), FontSize).ToFullSize();
+	TransformDirty = false;
+};
 
-			if(ActualPosition.x + Size.x + TextSize.Left > Manager->GetInput()->MousePosition.x)
-				break;
+void UIPanel::RefreshMovedTransform()
+{
+	TransformPending = false;
 
-			X++;
-		};
+	//Where we were drawn, unless something already resolved us after we moved
+	Vector2 Min = AbsolutePositionValue - SelectBoxExtraSize / 2, Max = Min + SizeValue + SelectBoxExtraSize;
+
+	Manager->AddDamage(Rect(Min.x, Max.x, Min.y, Max.y));
 
-		CursorPosition = X;
+	RefreshTransform();
+
+	LayerDirty = true;
+
+	Manager->AddDamage(GetDrawArea());
+
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->RefreshMovedTransform();
 	};
 };
 
-void UITextBox::OnKeyJustPressedTextBox(UIPanel *This, const InputCenter::KeyInfo &o)
+void UIPanel::UpdateTransform()
 {
-	if(this == Manager->GetFocusedElement())
-	{
-		if(o.Name == sf::Keyboard::Left)
-		{
-			if(CursorPosition == 0 && TextOffset > 0)
-			{
-				TextOffset--;
-			}
-			else if(CursorPosition == 0 && TextOffset == 0)
-			{
-				return;
-			}
-			else
-			{
-				CursorPosition--;
-			};
-		}
-		else if(o.Name == sf::Keyboard::Right)
-		{
-			if(CursorPosition + TextOffset + 1 > Text.getSize())
-				return;
+	if(!TransformPending)
+		return;
 
-			std::wstring ActualText = Text.toWideString();
+	TransformPending = false;
 
-			std::wstring str = ActualText.substr(TextOffset, CursorPosition + 1);
+	if(TransformDirty)
+	{
+		//Our root was already marked dirty when we moved
+		RefreshMovedTransform();
 
-			Vector2 TextSize = MeasureTextSimple(str, Manager->GetDefaultFont(), FontSize).ToFullSize();
+		return;
+	};
 
-			if(TextSize.x >= SizeValue.x)
-			{
-				TextOffset++;
-			}
-			else
-			{
-				CursorPosition++;
-			};
-		};
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->UpdateTransform();
 	};
 };
 
-void UITextBox::OnCharacterEnteredTextBox(UIPanel *This)
+void UIPanel::UpdateLayout()
 {
-	if(this == Manager->GetFocusedElement())
-	{
-		std::wstring ActualText = Text.toWideString();
+	if(!LayoutDirty)
+		return;
 
-		if(Manager->GetInput()->Character == 8) //Hardcoded Backspace
-		{
-			if(ActualText.length() == 0)
-				return;
+	Manager->LayoutCount++;
 
-			ActualText.erase(TextOffset + CursorPosition - 1);
+	//Our size may have changed without going through SetSize
+	InvalidateHitTestBounds();
 
-			if(TextOffset > 0)
-			{
-				TextOffset--;
-			}
-			else if(CursorPosition > 0)
-			{
-				CursorPosition--;
-			};
-		}
-		else
-		{
-			ActualText = ActualText.substr(0, TextOffset + CursorPosition) + Manager->GetInput()->Character +
-				ActualText.substr(TextOffset + CursorPosition);
+	PerformLayout();
 
-			CursorPosition++;
+	//Our size may have changed
+	Damage();
 
-			Vector2 TextSize = MeasureTextSimple(ActualText.substr(TextOffset),
-				Manager->GetDefaultFont(), FontSize).ToFullSize();
+	//Cleared afterwards so changes PerformLayout makes to us don't re-dirty our parents
+	LayoutDirty = false;
 
-			while(TextSize.x >= SizeValue.x)
-			{
-				CursorPosition--;
-				TextOffset++;
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->UpdateLayout();
+	};
+};
 
-				TextSize = MeasureTextSimple(ActualText.substr(TextOffset),
-					Manager->GetDefaultFont(), FontSize).ToFullSize();
-			};
-		};
+void UIPanel::Clear()
+{
+	while(Children.size())
+	{
+		unsigned long OldSize = Children.size();
+
+		Manager->RemoveElement(Children[0]->GetID());
+
+		unsigned long NewSize = Children.size();
 
-		Text = ActualText;
+		if(NewSize == OldSize)
+			Children.erase(Children.begin());
 	};
 };
 
-void UITextBox::OnSkinChange()
+UIPanel::~UIPanel()
 {
-	std::string TexturePath = Skin->GetString("TextBox", "BackgroundTexture");
+	GetManager()->StopAnimations(this);
 
-	BackgroundTexture = LoadTexture(TexturePath);
+	//The index may still refer to us until it's rebuilt
+	InvalidateHitTest();
 
-	std::string NinePatchRectValue = Skin->GetString("TextBox", "TextureRect");
+	if(ParentValue)
+		ParentValue->RemoveChild(this);
 
-	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
-		&TextureRect.Top, &TextureRect.Bottom);
+	GetManager()->RemoveElement(ID);
 
-	FontSize = Manager->GetDefaultFontSize();
+	Clear();
+};
 
-	std::string PaddingValue = Skin->GetString("TextBox", "Padding");
+void UIFrame::OnSkinChange()
+{
+	std::string TexturePath = Skin->GetString("Frame", "BackgroundTexture");
 
-	sscanf(PaddingValue.c_str(), "%u", &Padding);
+	BackgroundTexture = Manager->GetSkinTexture(TexturePath);
+
+	std::string NinePatchRectValue = Skin->GetString("Frame", "TextureRect");
+
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
+		&TextureRect.Top, &TextureRect.Bottom);
 
 	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
 };
 
-void UITextBox::PerformLayout()
+void UIFrame::Update(const Vector2 &ParentPosition)
 {
-	if(SizeValue.y < FontSize + 10)
+	for(unsigned long i = 0; i < Children.size(); i++)
 	{
-		SizeValue.y = (float)FontSize + 10;
+		Children[i]->Update(ParentPosition + PositionValue);
 	};
 };
 
-void UITextBox::Update(const Vector2 &ParentPosition)
-{
-	PerformLayout();
-};
-
-#define TEXTBOX_BORDER_SIZE 1
-
-void UITextBox::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+void UIFrame::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
 {
 	Vector2 ActualPosition = ParentPosition + PositionValue;
-	Vector2 ActualSize = SizeValue + Vector2(Padding * 2.0f, 0);
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
 		return;
 
 	Sprite TheSprite;
 	TheSprite.SpriteTexture = BackgroundTexture;
-	TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(ActualSize);
+	TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(SizeValue);
 
 	TheSprite.Draw(Renderer);
 
-	std::wstring WideString = Text.toWideString();
-
-	if(IsPasswordValue)
+	for(unsigned long i = 0; i < Children.size(); i++)
 	{
-		std::wstringstream str;
+		if(Children[i]->IsVisible())
+			Children[i]->DrawLayered(ActualPosition, Renderer);
+	};
+};
 
-		for(unsigned long i = 0; i < WideString.size(); i++)
-			str << "*";
+void UIButton::OnSkinChange()
+{
+	std::string TexturePath = Skin->GetString("Button", "BackgroundTexture");
 
-		WideString = str.str();
-	};
+	NormalTexture = Manager->GetSkinTexture(TexturePath);
 
-	Rect TextSize = MeasureTextSimple(WideString.substr(TextOffset), Manager->GetDefaultFont(), FontSize);
+	TexturePath = Skin->GetString("Button", "FocusedTexture");
 
-	Vector2 ActualTextSize = TextSize.Position() + TextSize.Size();
+	FocusedTexture = Manager->GetSkinTexture(TexturePath);
 
-	//Not centering, and using SizeValue otherwise text pops
-	Vector2 Offset = Vector2(-TextSize.Left + Padding, (SizeValue.y * 0.25f));
+	std::string NinePatchRectValue = Skin->GetString("Button", "TextureRect");
 
-	unsigned long Count = 0;
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
+		&TextureRect.Top, &TextureRect.Bottom);
 
-	{
-		for(unsigned long i = 0; i < WideString.size() - TextOffset; i++, Count++)
-		{
-			Vector2 Size = MeasureTextSimple(WideString.substr(TextOffset, i + 1),
-				Manager->GetDefaultFont(), FontSize).ToFullSize();
+	std::string FontSizeValue = Skin->GetString("Button", "FontSize");
 
-			if(Size.x >= SizeValue.x)
-				break;
-		};
-	};
+	sscanf(FontSizeValue.c_str(), "%u", &FontSize);
 
-	RenderText(*Renderer, WideString.substr(TextOffset, Count),
-		Manager->GetDefaultFont(), FontSize, TextParams().Color(Vector4(0, 0, 0, 1)).Position(ActualPosition + Offset));
+	std::string FontColorValue = Skin->GetString("Button", "FontColor");
 
-	if(this == Manager->GetFocusedElement())
-	{
-		//Draw cursor
-		float X = 0;
+	sscanf(FontColorValue.c_str(), "%f,%f,%f,%f", &FontColor.x, &FontColor.y, &FontColor.z, &FontColor.w);
 
-		for(unsigned long i = 0; i < CursorPosition; i++)
-		{
-			Vector2 Size = MeasureTextSimple(WideString.substr(TextOffset, i + 1), Manager->GetDefaultFont(),
-				FontSize).ToFullSize();
+	std::string LabelOffsetValue = Skin->GetString("Button", "LabelOffset");
 
-			if(Size.x >= SizeValue.x + Offset.x)
-				break;
+	sscanf(LabelOffsetValue.c_str(), "%f,%f", &LabelOffset.x, &LabelOffset.y);
 
-			X = Size.x;
-		};
+	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
+};
 
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+void UIButton::PerformLayout()
+{
+	Rect Size = MeasureTextSimple(Caption, Manager->GetDefaultFont(), FontSize);
 
-		glColor4f(0, 0, 0, AlphaValue);
+	Vector2 ActualSize = Size.Position() + Size.Size();
 
-		Vector2 BasePosition = ActualPosition + Vector2(X + Padding, 0);
+	if(ActualSize.x > SizeValue.x)
+	{
+		SizeValue.x = ActualSize.x + 10;
+	};
 
-		Vector2 LineVertices[2] = {
-			BasePosition + Vector2(0, SizeValue.y * 0.05f),
-			BasePosition + Vector2(0, SizeValue.y * 0.95f)
-		};
+	if(ActualSize.y > SizeValue.y)
+	{
+		SizeValue.y = ActualSize.y + 10;
+	};
+};
+
+void UIButton::Update(const Vector2 &ParentPosition)
+{
+};
+
+void UIButton::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
 
-		glVertexPointer(2, GL_FLOAT, 0, LineVertices);
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
 
-		glLineWidth(TEXTBOX_BORDER_SIZE);
+	Rect Size = MeasureTextSimple(Caption, Manager->GetDefaultFont(), FontSize);
 
-		glDrawArrays(GL_LINES, 0, 2);
+	Vector2 ActualSize = Size.ToFullSize();
 
-		glLineWidth(1);
-	};
+	Sprite TheSprite;
+	TheSprite.SpriteTexture = ClickPressed ? FocusedTexture : NormalTexture;
+	TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(SizeValue);
+
+	TheSprite.Draw(Renderer);
+
+	//Not /2'ing the Y axis because it works better this way for some reason
+	Vector2 Offset = Vector2((SizeValue.x - ActualSize.x) / 2 + LabelOffset.x, LabelOffset.y);
+
+	RenderText(*Renderer, Caption, Manager->GetDefaultFont(), FontSize,
+		TextParams().Color(FontColor).Position(ActualPosition + Offset));
 
 	glColor4f(1, 1, 1, 1);
 };
 
-void UIScrollableFrame::OnSkinChange()
+UITextBox::UITextBox(UIManager *Manager) : UIPanel(Manager), FontSize(12), CursorPosition(0),
+	TextOffset(0), PrefixAdvancesFontSize(0), CursorVisible(true), IsPasswordValue(false)
 {
+	OnMouseJustPressed.Connect(this, &UITextBox::OnMouseJustPressedTextBox);
+	OnKeyJustPressed.Connect(this, &UITextBox::OnKeyJustPressedTextBox);
+	OnCharacterEntered.Connect(this, &UITextBox::OnCharacterEnteredTextBox);
 };
 
-void UIScrollableFrame::MakeScrolls()
+void UITextBox::ResetCursorBlink()
 {
-	VerticalScroll.Dispose();
-	HorizontalScroll.Dispose();
+	CursorBlinkClock.restart();
+	CursorVisible = true;
 
-	VerticalScroll.Reset(new UIScrollbar(GetManager(), true));
-	HorizontalScroll.Reset(new UIScrollbar(GetManager(), false));
-
-	GetManager()->AddElement(MakeStringID(StringUtils::MakeIntString((unsigned long)this, true) + "_VERTICALSCROLL"), VerticalScroll);
-	GetManager()->AddElement(MakeStringID(StringUtils::MakeIntString((unsigned long)this, true) + "_HORIZONTALSCROLL"), HorizontalScroll);
+	Damage();
 };
 
-void UIScrollableFrame::Update(const Vector2 &ParentPosition)
+Rect UITextBox::GetDrawArea()
 {
-	if(VerticalScroll.Get() == NULL || HorizontalScroll.Get() == NULL)
-		MakeScrolls();
+	Rect Out = UIPanel::GetDrawArea();
 
-	if((VerticalScroll->GetParent() == NULL || HorizontalScroll->GetParent() == NULL) &&
-		GetManager()->GetElement(ID) != SuperSmartPointer<UIPanel>())
+	//Our background is padded on the right
+	Out.Right += Padding * 2.0f;
+
+	return Out;
+};
+
+void UITextBox::RefreshDisplayText()
+{
+	if(IsPasswordValue)
 	{
-		AddChildren(VerticalScroll);
-		AddChildren(HorizontalScroll);
+		DisplayText.assign(Text.getSize(), L'*');
+	}
+	else
+	{
+		DisplayText = Text.toWideString();
 	};
 
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+	UpdatePrefixAdvances(0);
+};
+
+void UITextBox::UpdatePrefixAdvances(unsigned long From)
+{
+	sf::Font *Font = Manager->GetDefaultFont();
 
-	Vector2 ChildrenSize = GetChildrenSize();
+	PrefixAdvancesFontSize = FontSize;
+	PrefixAdvances.resize(DisplayText.length());
 
-	if(ChildrenSize.y > SizeValue.y)
-	{
-		VerticalScroll->SetSize(Vector2(SCROLLBAR_DRAGGABLE_SIZE, SizeValue.y) - VerticalScroll->GetExtraSize());
-		VerticalScroll->SetPosition(Vector2(SizeValue.x - VerticalScroll->GetSize().x, 0) +
-			Vector2(-VerticalScroll->GetExtraSize().x / 2.f, VerticalScroll->GetExtraSize().y / 2.f));
-		TranslationValue.y = (VerticalScroll->Value() / (float)VerticalScroll->MaxValue) * (ChildrenSize.y - SizeValue.y);
-	};
+	if(From > DisplayText.length())
+		From = DisplayText.length();
 
-	VerticalScroll->SetVisible(ChildrenSize.y > SizeValue.y);
+	//Kerning depends on the previous character, so resume from the character before the edit
+	float x = From > 0 ? PrefixAdvances[From - 1] : 0;
 
-	if(ChildrenSize.x > SizeValue.x)
+	for(unsigned long i = From; i < DisplayText.length(); i++)
 	{
-		HorizontalScroll->SetSize(Vector2(SizeValue.x, SCROLLBAR_DRAGGABLE_SIZE) - HorizontalScroll->GetExtraSize());
-		HorizontalScroll->SetPosition(Vector2(0, SizeValue.y - HorizontalScroll->GetSize().y) +
-			Vector2(HorizontalScroll->GetExtraSize().x / 2.f, -HorizontalScroll->GetExtraSize().y / 2.f));
-		TranslationValue.x = (HorizontalScroll->Value() / (float)HorizontalScroll->MaxValue) * (ChildrenSize.x - SizeValue.x);
+		x += TextEngine::Instance.GetKerning(Font, FontSize, i > 0 ? DisplayText[i - 1] : 0, DisplayText[i]) +
+			TextEngine::Instance.GetAdvance(Font, FontSize, DisplayText[i]);
+
+		PrefixAdvances[i] = x;
 	};
+};
+
+float UITextBox::GetTextWidth(unsigned long Start, unsigned long Count) const
+{
+	if(Count == 0 || Start + Count > PrefixAdvances.size())
+		return 0;
+
+	return PrefixAdvances[Start + Count - 1] - (Start > 0 ? PrefixAdvances[Start - 1] : 0);
+};
+
+float UITextBox::GetVisibleTextLeft() const
+{
+	if(TextOffset >= DisplayText.length())
+		return 0;
+
+	//Only the first glyph can start left of the pen
+	return MeasureTextSimple(DisplayText.substr(TextOffset, 1), Manager->GetDefaultFont(), FontSize).Left;
+};
+
+unsigned long UITextBox::FitCharacters(unsigned long Start, float Width) const
+{
+	if(Start >= PrefixAdvances.size())
+		return 0;
+
+	float Base = Start > 0 ? PrefixAdvances[Start - 1] : 0;
 
-	HorizontalScroll->SetVisible(ChildrenSize.x > SizeValue.x);
+	return std::lower_bound(PrefixAdvances.begin() + Start, PrefixAdvances.end(), Base + Width) - (PrefixAdvances.begin() + Start);
+};
 
-	if(VerticalScroll->IsVisible() && HorizontalScroll->IsVisible())
+void UITextBox::OnMouseJustPressedTextBox(UIPanel *This, const InputCenter::MouseButtonInfo &o)
+{
+	if(this == Manager->GetFocusedElement() && Text.getSize() > 0 && o.Name == sf::Mouse::Left)
 	{
-		VerticalScroll->SetSize(VerticalScroll->GetSize() - Vector2(0, HorizontalScroll->GetExtraSize().y + HorizontalScroll->GetSize().y));
-		HorizontalScroll->SetSize(HorizontalScroll->GetSize() - Vector2(VerticalScroll->GetExtraSize().x + VerticalScroll->GetSize().x, 0));
+		//Since we're already pressed, we must be inside it, so we just need to care about the X axis
+
+		Vector2 ActualPosition = GetAbsolutePosition() + Vector2((float)Padding, 0);
+
+		if(PrefixAdvancesFontSize != FontSize)
+			UpdatePrefixAdvances(0);
+
+		float Base = TextOffset > 0 ? PrefixAdvances[TextOffset - 1] : 0;
+
+		//Every character that ends before the mouse
+		CursorPosition = std::upper_bound(PrefixAdvances.begin() + TextOffset, PrefixAdvances.end(),
+			Base + Manager->GetInput()->MousePosition.x - ActualPosition.x - GetVisibleTextLeft()) - (PrefixAdvances.begin() + TextOffset);
+
+		ResetCursorBlink();
 	};
+};
 
-	if(VerticalScroll->IsVisible() && GetManager()->GetMouseOverElement().Get() == this)
+void UITextBox::OnKeyJustPressedTextBox(UIPanel *This, const InputCenter::KeyInfo &o)
+{
+	if(this == Manager->GetFocusedElement())
 	{
-		long Step = Manager->GetInput()->MouseWheel < 0 ? 1 : Manager->GetInput()->MouseWheel > 0 ? -1 : 0;
-		unsigned long MaxSteps = (VerticalScroll->MaxValue - VerticalScroll->MinValue) / VerticalScroll->ValueStep;
-		unsigned long StepPower = (unsigned long)(MaxSteps * 0.05f);
-
-		if(Step < 0)
+		if(o.Name == sf::Keyboard::Left)
 		{
-			if(VerticalScroll->CurrentStep > StepPower)
+			if(CursorPosition == 0 && TextOffset > 0)
 			{
-				VerticalScroll->CurrentStep -= StepPower;
+				TextOffset--;
 			}
-			else if(VerticalScroll->CurrentStep > 0)
+			else if(CursorPosition == 0 && TextOffset == 0)
 			{
-				VerticalScroll->CurrentStep = 0;
+				return;
+			}
+			else
+			{
+				CursorPosition--;
 			};
 		}
-		else if(Step > 0)
+		else if(o.Name == sf::Keyboard::Right)
 		{
-			if(VerticalScroll->CurrentStep + StepPower < MaxSteps)
+			if(CursorPosition + TextOffset + 1 > Text.getSize())
+				return;
+
+			if(PrefixAdvancesFontSize != FontSize)
+				UpdatePrefixAdvances(0);
+
+			if(GetTextWidth(TextOffset, CursorPosition + 1) >= SizeValue.x)
 			{
-				VerticalScroll->CurrentStep += StepPower;
+				TextOffset++;
 			}
-			else if(VerticalScroll->CurrentStep < MaxSteps)
+			else
 			{
-				VerticalScroll->CurrentStep = MaxSteps;
+				CursorPosition++;
 			};
+		}
+		else
+		{
+			return;
 		};
-	};
 
-	for(unsigned long i = 0; i < Children.size(); i++)
-	{
-		Children[i]->Update(ActualPosition);
+		ResetCursorBlink();
 	};
 };
 
-void UIScrollableFrame::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+void UITextBox::OnCharacterEnteredTextBox(UIPanel *This)
 {
-	if(VerticalScroll.Get() == NULL || HorizontalScroll.Get() == NULL)
-		MakeScrolls();
+	if(this == Manager->GetFocusedElement())
+	{
+		//Edit Text and DisplayText in place rather than copying the whole text on every key
+		unsigned long Position = TextOffset + CursorPosition;
 
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+		if(Manager->GetInput()->Character == 8) //Hardcoded Backspace
+		{
+			if(Text.getSize() == 0 || Position == 0)
+				return;
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
-		return;
+			Text.erase(Position - 1, 1);
+			DisplayText.erase(Position - 1, 1);
 
-	Vector2 Vertices[6] = {
-		ActualPosition + Vector2(-TEXTBOX_BORDER_SIZE, -TEXTBOX_BORDER_SIZE),
-		ActualPosition + Vector2(-TEXTBOX_BORDER_SIZE, SizeValue.y + TEXTBOX_BORDER_SIZE),
-		ActualPosition + SizeValue + Vector2(TEXTBOX_BORDER_SIZE, TEXTBOX_BORDER_SIZE),
-		ActualPosition + SizeValue + Vector2(TEXTBOX_BORDER_SIZE, TEXTBOX_BORDER_SIZE),
-		ActualPosition + Vector2(SizeValue.x + TEXTBOX_BORDER_SIZE, -TEXTBOX_BORDER_SIZE),
-		ActualPosition + Vector2(-TEXTBOX_BORDER_SIZE, -TEXTBOX_BORDER_SIZE),
-	};
+			UpdatePrefixAdvances(Position - 1);
 
-	glColor4f(0, 0, 0, AlphaValue);
+			if(TextOffset > 0)
+			{
+				TextOffset--;
+			}
+			else if(CursorPosition > 0)
+			{
+				CursorPosition--;
+			};
+		}
+		else
+		{
+			wchar_t Character = Manager->GetInput()->Character;
 
-	glBindTexture(GL_TEXTURE_2D, NULL);
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisableClientState(GL_NORMAL_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
+			Text.insert(Position, sf::String(Character));
+			DisplayText.insert(Position, 1, IsPasswordValue ? L'*' : Character);
 
-	glVertexPointer(2, GL_FLOAT, 0, Vertices);
+			UpdatePrefixAdvances(Position);
 
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+			CursorPosition++;
 
-	Vertices[0] -= Vector2(-TEXTBOX_BORDER_SIZE, -TEXTBOX_BORDER_SIZE);
-	Vertices[1] -= Vector2(-TEXTBOX_BORDER_SIZE, TEXTBOX_BORDER_SIZE);
-	Vertices[2] -= Vector2(TEXTBOX_BORDER_SIZE, TEXTBOX_BORDER_SIZE);
-	Vertices[3] -= Vector2(TEXTBOX_BORDER_SIZE, TEXTBOX_BORDER_SIZE);
-	Vertices[4] -= Vector2(TEXTBOX_BORDER_SIZE, -TEXTBOX_BORDER_SIZE);
-	Vertices[5] -= Vector2(-TEXTBOX_BORDER_SIZE, -TEXTBOX_BORDER_SIZE);
+			while(GetTextWidth(TextOffset, DisplayText.length() - TextOffset) >= SizeValue.x)
+			{
+				CursorPosition--;
+				TextOffset++;
+			};
+		};
 
-	glColor4f(0.3f, 0.3f, 0.3f, AlphaValue);
+		ResetCursorBlink();
+	};
+};
 
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+void UITextBox::OnSkinChange()
+{
+	std::string TexturePath = Skin->GetString("TextBox", "BackgroundTexture");
 
-	glColor4f(1, 1, 1, 1);
+	BackgroundTexture = Manager->GetSkinTexture(TexturePath);
 
-	Vector2 ChildrenSize = GetChildrenSize();
+	std::string NinePatchRectValue = Skin->GetString("TextBox", "TextureRect");
 
-	bool EnabledScissor = glIsEnabled(GL_SCISSOR_TEST);
-	glEnable(GL_SCISSOR_TEST);
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
+		&TextureRect.Top, &TextureRect.Bottom);
 
-	Vector4 PreviousScissor;
-	glGetFloatv(GL_SCISSOR_BOX, (GLfloat *)&PreviousScissor);
+	FontSize = Manager->GetDefaultFontSize();
 
-	glScissor((GLsizei)ActualPosition.x, (GLsizei)(Renderer->getSize().y - ActualPosition.y - SizeValue.y),
-		(GLsizei)(SizeValue.x - (ChildrenSize.y > SizeValue.y ? VerticalScroll->GetSize().x : 0)), (GLsizei)(SizeValue.y -
-		(ChildrenSize.x > SizeValue.x ? HorizontalScroll->GetSize().y : 0)));
+	UpdatePrefixAdvances(0);
 
-	for(unsigned long i = 0; i < Children.size(); i++)
-	{
-		if(Children[i] == VerticalScroll || Children[i] == HorizontalScroll)
-			continue;
+	std::string PaddingValue = Skin->GetString("TextBox", "Padding");
 
-		Children[i]->Draw(ActualPosition - TranslationValue, Renderer);
-	};
+	sscanf(PaddingValue.c_str(), "%u", &Padding);
 
-	if(!EnabledScissor)
-	{
-		glDisable(GL_SCISSOR_TEST);
-	}
-	else
+	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
+};
+
+void UITextBox::PerformLayout()
+{
+	if(SizeValue.y < FontSize + 10)
 	{
-		glScissor((GLsizei)PreviousScissor.x, (GLsizei)PreviousScissor.y, (GLsizei)PreviousScissor.z, (GLsizei)PreviousScissor.w);
+		SizeValue.y = (float)FontSize + 10;
 	};
-
-	VerticalScroll->Draw(ActualPosition, Renderer);
-	HorizontalScroll->Draw(ActualPosition, Renderer);
 };
 
-void UIList::OnSkinChange()
+#define TEXTBOX_CURSOR_BLINK_TIME 500
+
+void UITextBox::Update(const Vector2 &ParentPosition)
 {
-	FontSize = GetManager()->GetDefaultFontSize();
+	bool Visible = this == Manager->GetFocusedElement() &&
+		(CursorBlinkClock.getElapsedTime().asMilliseconds() / TEXTBOX_CURSOR_BLINK_TIME) % 2 == 0;
 
-	std::string TexturePath = Skin->GetString("Menu", "SelectorBackgroundTexture");
+	if(Visible != CursorVisible)
+	{
+		CursorVisible = Visible;
 
-	SelectorBackgroundTexture = LoadTexture(TexturePath);
+		Damage();
+	};
 };
 
-void UIList::PerformLayout()
+unsigned long UITextBox::GetTimeUntilUpdate()
 {
-	float Height = 0;
+	if(this != Manager->GetFocusedElement())
+		return InputCenter::WaitForever;
 
-	for(unsigned long i = 0; i < Items.size(); i++)
-	{
-		Vector2 Size = MeasureTextSimple(Items[i], Manager->GetDefaultFont(), FontSize).ToFullSize();
+	//Until the cursor blinks
+	return TEXTBOX_CURSOR_BLINK_TIME - CursorBlinkClock.getElapsedTime().asMilliseconds() % TEXTBOX_CURSOR_BLINK_TIME;
+};
 
-		float SizeY = (Size.y < FontSize * 1.15f ? FontSize * 1.15f : Size.y);
+#define TEXTBOX_BORDER_SIZE 1
 
-		Height += SizeY + 2;
-	};
+void UITextBox::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+	Vector2 ActualSize = SizeValue + Vector2(Padding * 2.0f, 0);
 
-	if(SizeValue.y < Height)
-		SizeValue.y = Height;
-};
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
 
-void UIList::OnItemClickCheck(UIPanel *Self)
-{
-	Vector2 ActualPosition = GetParentPosition() + PositionValue;
-	AxisAlignedBoundingBox AABB;
-	float Height = 0;
-	UIScrollableFrame *Parent = ParentValue.AsDerived<UIScrollableFrame>();
+	Sprite TheSprite;
+	TheSprite.SpriteTexture = BackgroundTexture;
+	TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(ActualSize);
+
+	TheSprite.Draw(Renderer);
 
-	AABB.min = ActualPosition;
+	if(PrefixAdvancesFontSize != FontSize)
+		UpdatePrefixAdvances(0);
 
-	for(unsigned long i = 0; i < Items.size(); i++)
-	{
-		Vector2 Size = MeasureTextSimple(Items[i], Manager->GetDefaultFont(), FontSize).ToFullSize();
+	//Not centering, and using SizeValue otherwise text pops
+	Vector2 Offset = Vector2(-GetVisibleTextLeft() + Padding, (SizeValue.y * 0.25f));
 
-		float SizeY = (Size.y < FontSize * 1.15f ? FontSize * 1.15f : Size.y);
+	unsigned long Count = FitCharacters(TextOffset, SizeValue.x);
 
-		AABB.min.y = ActualPosition.y + Height;
-		AABB.max = ActualPosition + Vector2(ParentValue->GetSize().x - (Parent->VerticalScroll->IsVisible() ? SCROLLBAR_DRAGGABLE_SIZE : 0), Height + SizeY);
+	RenderText(*Renderer, DisplayText.substr(TextOffset, Count),
+		Manager->GetDefaultFont(), FontSize, TextParams().Color(Vector4(0, 0, 0, 1)).Position(ActualPosition + Offset));
 
-		Height += SizeY + 2;
+	if(CursorVisible && this == Manager->GetFocusedElement())
+	{
+		//Draw cursor, stopping at the last character that fits
+		unsigned long CursorCharacters = FitCharacters(TextOffset, SizeValue.x + Offset.x);
 
-		if(AABB.IsInside(Manager->GetInput()->MousePosition))
-		{
-			OnItemClick(this, i);
+		float X = GetTextWidth(TextOffset, CursorPosition < CursorCharacters ? CursorPosition : CursorCharacters);
 
-			return;
-		};
+		Vector2 BasePosition = ActualPosition + Vector2(X + Padding, 0);
+
+		SpriteBatch::Instance.AddRect(BasePosition + Vector2(0, SizeValue.y * 0.05f), Vector2(TEXTBOX_BORDER_SIZE, SizeValue.y * 0.9f),
+			Vector4(0, 0, 0, AlphaValue));
 	};
 };
 
-void UIList::Update(const Vector2 &ParentPosition)
-{
-	Vector2 ActualPosition = ParentPosition + PositionValue;
-	AxisAlignedBoundingBox AABB;
-	float Height = 0;
-	UIScrollableFrame *Parent = ParentValue.AsDerived<UIScrollableFrame>();
+#define UITEXTEDITOR_MINIMUM_LINE_GAP 16
 
-	AABB.min = ActualPosition;
+UITextEditor::UITextEditor(UIManager *Manager) : UIPanel(Manager), Padding(5), LineSpacing(14), LineGapStart(1), LineGapEnd(1),
+	TotalRows(0), WrapWidth(0), WrapFontSize(0), CursorPosition(0), CursorVisible(true), FontSize(12)
+{
+	OnConstructed();
 
-	for(unsigned long i = 0; i < Items.size(); i++)
-	{
-		Vector2 Size = MeasureTextSimple(Items[i], Manager->GetDefaultFont(), FontSize).ToFullSize();
+	OnMouseJustPressed.Connect(this, &UITextEditor::OnMouseJustPressedTextEditor);
+	OnKeyJustPressed.Connect(this, &UITextEditor::OnKeyJustPressedTextEditor);
+	OnCharacterEntered.Connect(this, &UITextEditor::OnCharacterEnteredTextEditor);
 
-		float SizeY = (Size.y < FontSize * 1.15f ? FontSize * 1.15f : Size.y);
+	Lines.push_back(Line());
 
-		AABB.min.y = ActualPosition.y + Height;
-		AABB.max = ActualPosition + Vector2(SizeValue.x, Height + SizeY);
+	RebuildRowTree();
+};
 
-		Height += SizeY + 2;
+void UITextEditor::ResetCursorBlink()
+{
+	CursorBlinkClock.restart();
+	CursorVisible = true;
 
-		if(AABB.IsInside(Manager->GetInput()->MousePosition))
-		{
-			OnItemMouseOver(this, i);
+	Damage();
+};
 
-			return;
-		};
-	};
+unsigned long UITextEditor::GetLineStart(unsigned long Index) const
+{
+	return Index < LineGapStart ? Lines[Index].Start : Text.GetSize() - Lines[GetLineSlot(Index)].Start;
 };
 
-void UIList::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+unsigned long UITextEditor::GetLineLength(unsigned long Index) const
 {
-	if(!ParentValue)
-		return;
+	unsigned long End = Index + 1 < GetLineCount() ? GetLineStart(Index + 1) - 1 : Text.GetSize();
 
-	static AxisAlignedBoundingBox AABB;
-	UIScrollableFrame *Parent = ParentValue.AsDerived<UIScrollableFrame>();
+	return End - GetLineStart(Index);
+};
 
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+unsigned long UITextEditor::FindLine(unsigned long Position) const
+{
+	unsigned long Low = 0, High = GetLineCount();
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
-		return;
+	//The last line starting at or before Position
+	while(High - Low > 1)
+	{
+		unsigned long Middle = (Low + High) / 2;
 
-	float Height = 0;
+		if(GetLineStart(Middle) <= Position)
+		{
+			Low = Middle;
+		}
+		else
+		{
+			High = Middle;
+		};
+	};
 
-	AABB.min = ActualPosition;
+	return Low;
+};
 
-	for(unsigned long i = 0; i < Items.size(); i++)
-	{
-		Vector2 Size = MeasureTextSimple(Items[i], Manager->GetDefaultFont(), FontSize).ToFullSize();
+void UITextEditor::MoveLineSlot(unsigned long From, unsigned long To)
+{
+	Line &Source = Lines[From], &Target = Lines[To];
 
-		float SizeY = (Size.y < FontSize * 1.15f ? FontSize * 1.15f : Size.y);
+	Target.Start = Source.Start;
+	Target.RowCount = Source.RowCount;
+	Target.WrapDirty = Source.WrapDirty;
+	//Swapped rather than copied, since only the gap is left behind
+	Target.Wraps.swap(Source.Wraps);
 
-		AABB.min.y = ActualPosition.y + Height;
-		AABB.max = ActualPosition + Vector2(SizeValue.x, Height + SizeY);
+	AddRowsToSlot(From, -(long)Source.RowCount);
+	AddRowsToSlot(To, Source.RowCount);
+};
 
-		Height += SizeY + 2;
+void UITextEditor::MoveLineGap(unsigned long Index)
+{
+	unsigned long TextSize = Text.GetSize();
 
-		if(AABB.IsInside(Manager->GetInput()->MousePosition))
-		{
-			Sprite TheSprite;
-			TheSprite.SpriteTexture = SelectorBackgroundTexture;
-			TheSprite.Options.Position(AABB.min.ToVector2()).Scale(Vector2(SizeValue.x, AABB.max.y - AABB.min.y) /
-				Vector2(SelectorBackgroundTexture->getSize().x, SelectorBackgroundTexture->getSize().y));
+	//Lines crossing the gap switch between counting Start from the start and from the end of the text
+	while(LineGapStart > Index)
+	{
+		LineGapStart--;
+		LineGapEnd--;
 
-			TheSprite.Draw(Renderer);
-		};
+		MoveLineSlot(LineGapStart, LineGapEnd);
 
-		RenderText(*Renderer, Items[i], Manager->GetDefaultFont(), FontSize,
-			TextParams().Color(GetManager()->GetDefaultFontColor()).Position(Vector2(AABB.min.x, AABB.min.y)));
+		Lines[LineGapEnd].Start = TextSize - Lines[LineGapEnd].Start;
 	};
 
-	glColor4f(1, 1, 1, 1);
+	while(LineGapStart < Index)
+	{
+		MoveLineSlot(LineGapEnd, LineGapStart);
 
-	Vector3 Final = AABB.max - ActualPosition;
+		Lines[LineGapStart].Start = TextSize - Lines[LineGapStart].Start;
 
-	SizeValue = Vector2(Final.x, Final.y);
+		LineGapStart++;
+		LineGapEnd++;
+	};
 };
 
-void UIDropdown::OnSkinChange()
+void UITextEditor::ReserveLineGap(unsigned long Count)
 {
-	FontSize = GetManager()->GetDefaultFontSize();
+	if(LineGapEnd - LineGapStart >= Count)
+		return;
 
-	std::string TexturePath = Skin->GetString("Dropdown", "BackgroundTexture");
+	//Grow geometrically, so typing many newlines stays cheap
+	unsigned long LineCount = GetLineCount(), GapSize = LineCount > Count ? LineCount : Count;
 
-	BackgroundTexture = LoadTexture(TexturePath);
+	if(GapSize < UITEXTEDITOR_MINIMUM_LINE_GAP)
+		GapSize = UITEXTEDITOR_MINIMUM_LINE_GAP;
 
-	TexturePath = Skin->GetString("Dropdown", "DropdownTexture");
+	std::vector<Line> NewLines(LineCount + GapSize);
 
-	DropdownTexture = LoadTexture(TexturePath);
+	for(unsigned long i = 0; i < LineCount; i++)
+	{
+		Line &Source = Lines[GetLineSlot(i)], &Target = NewLines[i < LineGapStart ? i : i + GapSize];
 
-	std::string NinePatchRectValue = Skin->GetString("Dropdown", "TextureRect");
+		Target.Start = Source.Start;
+		Target.RowCount = Source.RowCount;
+		Target.WrapDirty = Source.WrapDirty;
+		Target.Wraps.swap(Source.Wraps);
+	};
 
-	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
-		&TextureRect.Top, &TextureRect.Bottom);
+	Lines.swap(NewLines);
+	LineGapEnd = LineGapStart + GapSize;
 
-	FontSize = GetManager()->GetDefaultFontSize();
-
-	std::string DropdownHeightString = Skin->GetString("Dropdown", "Height");
-
-	sscanf(DropdownHeightString.c_str(), "%f", &DropdownHeight);
-
-	std::string DropdownOffsetString = Skin->GetString("Dropdown", "Offset");
+	RebuildRowTree();
+};
 
-	sscanf(DropdownOffsetString.c_str(), "%f,%f", &DropdownOffset.x, &DropdownOffset.y);
+void UITextEditor::InsertLine(unsigned long Start)
+{
+	ReserveLineGap(1);
 
-	std::string TextOffsetString = Skin->GetString("Dropdown", "TextOffset");
+	Line &NewLine = Lines[LineGapStart];
+	NewLine.Start = Start;
+	NewLine.Wraps.clear();
+	NewLine.WrapDirty = true;
+	NewLine.RowCount = 1;
 
-	sscanf(TextOffsetString.c_str(), "%f,%f", &TextOffset.x, &TextOffset.y);
-};
+	AddRowsToSlot(LineGapStart, 1);
 
-void UIDropdown::PerformLayout()
-{
-	SizeValue.y = DropdownHeight;
+	LineGapStart++;
 };
 
-void UIDropdown::SetSelectedItem(UIMenu::Item *Item)
+void UITextEditor::WrapLine(unsigned long Index)
 {
-	SelectedIndex = Item->Index;
-	OnItemClick(this);
-};
+	Line &TheLine = Lines[GetLineSlot(Index)];
+	sf::Font *Font = Manager->GetDefaultFont();
+	unsigned long Start = GetLineStart(Index), Length = GetLineLength(Index), RowStart = 0, LastSpace = 0;
+	float x = 0;
 
-void UIDropdown::OnItemClickCheck(UIPanel *Self)
-{
-	UIMenu *Menu = Self->GetManager()->CreateMenu(GetParentPosition() + PositionValue + Vector2(0, DropdownHeight));
+	TheLine.Wraps.clear();
+	TheLine.WrapDirty = false;
 
-	for(unsigned long i = 0; i < Items.size(); i++)
+	for(unsigned long i = 0; i < Length && WrapWidth > 0; i++)
 	{
-		Menu->AddItem(Items[i]);
-	};
-
-	Menu->SetSize(Vector2(SizeValue.x, Menu->GetSize().y));
-	Menu->OnItemSelected.Connect(this, &UIDropdown::SetSelectedItem);
-};
+		wchar_t Character = Text[Start + i];
+		float Advance = TextEngine::Instance.GetKerning(Font, FontSize, i > RowStart ? Text[Start + i - 1] : 0, Character) +
+			TextEngine::Instance.GetAdvance(Font, FontSize, Character);
 
-void UIDropdown::Update(const Vector2 &ParentPosition)
-{
-};
+		if(x + Advance > WrapWidth && i > RowStart)
+		{
+			//Prefer breaking after the last space in this row, otherwise break in the middle of the word
+			RowStart = LastSpace > RowStart ? LastSpace : i;
 
-void UIDropdown::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
-{
-	static AxisAlignedBoundingBox AABB;
+			TheLine.Wraps.push_back(RowStart);
 
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+			x = GetTextWidth(Start + RowStart, i - RowStart);
+			Advance = TextEngine::Instance.GetKerning(Font, FontSize, i > RowStart ? Text[Start + i - 1] : 0, Character) +
+				TextEngine::Instance.GetAdvance(Font, FontSize, Character);
+		};
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
-		return;
+		x += Advance;
 
-	Sprite TheSprite;
-	TheSprite.SpriteTexture = BackgroundTexture;
-	TheSprite.Options.NinePatch(true, TextureRect).Position(ActualPosition).Scale(Vector2(SizeValue.x, DropdownHeight));
+		if(Character == L' ' || Character == L'\t')
+			LastSpace = i + 1;
+	};
 
-	TheSprite.Draw(Renderer);
+	SetLineRowCount(Index, TheLine.Wraps.size() + 1);
+};
 
-	std::string ItemName;
+void UITextEditor::RebuildRowTree()
+{
+	RowTree.assign(Lines.size() + 1, 0);
+	TotalRows = 0;
 
-	if(SelectedIndex == -1 || SelectedIndex >= (long)Items.size())
-	{
-		ItemName = "(None)";
-	}
-	else
+	for(unsigned long i = 1; i < RowTree.size(); i++)
 	{
-		ItemName = Items[SelectedIndex];
-	};
-
-	RenderText(*Renderer, ItemName, GetManager()->GetDefaultFont(), FontSize, TextParams().Position(ActualPosition + TextOffset)
-		.Color(GetManager()->GetDefaultFontColor()));
+		//Slots inside the line gap have no rows
+		if(i - 1 < LineGapStart || i - 1 >= LineGapEnd)
+		{
+			RowTree[i] += Lines[i - 1].RowCount;
+			TotalRows += Lines[i - 1].RowCount;
+		};
 
-	TheSprite.SpriteTexture = DropdownTexture;
-	TheSprite.Options.NinePatch(false, TextureRect).Position(ActualPosition + Vector2(SizeValue.x - DropdownOffset.x - DropdownTexture->getSize().x,
-		DropdownOffset.y)).Scale(Vector2(1, 1));
+		unsigned long Parent = i + (i & (~i + 1));
 
-	TheSprite.Draw(Renderer);
+		if(Parent < RowTree.size())
+			RowTree[Parent] += RowTree[i];
+	};
 };
 
-void UIText::OnSkinChange()
+void UITextEditor::AddRowsToSlot(unsigned long Slot, long Delta)
 {
-	FontSize = Manager->GetDefaultFontSize();
-	Params.Color(Manager->GetDefaultFontColor()).SecondaryColor(Manager->GetDefaultSecondaryFontColor());
-};
+	if(Delta == 0)
+		return;
 
-void UIText::SetText(const sf::String &String, bool AutoExpandHeight)
-{
-	Text = String;
-	Strings = FitTextOnRect(Text, Manager->GetDefaultFont(), FontSize,
-		AutoExpandHeight ? Vector2(SizeValue.x, 9999999) : SizeValue);
+	TotalRows += Delta;
 
-	if(AutoExpandHeight)
+	for(unsigned long i = Slot + 1; i < RowTree.size(); i += i & (~i + 1))
 	{
-		SizeValue.y = SizeValue.y > Strings.size() * (FontSize + 4) ? SizeValue.y : Strings.size() * (FontSize + 4);
+		RowTree[i] += Delta;
 	};
 };
 
-const sf::String &UIText::GetText()
+void UITextEditor::SetLineRowCount(unsigned long Index, unsigned long Count)
 {
-	return Text;
+	unsigned long Slot = GetLineSlot(Index);
+	long Delta = (long)Count - (long)Lines[Slot].RowCount;
+
+	Lines[Slot].RowCount = Count;
+
+	AddRowsToSlot(Slot, Delta);
 };
 
-Vector2 UIText::GetTextSize()
+unsigned long UITextEditor::GetRowsBefore(unsigned long Index) const
 {
-	Vector2 Size;
+	long Out = 0;
 
-	for(unsigned long i = 0; i < Strings.size(); i++)
+	for(unsigned long i = GetLineSlot(Index); i > 0; i -= i & (~i + 1))
 	{
-		Vector2 TextSize = MeasureTextSimple(Strings[i], Manager->GetDefaultFont(), FontSize).ToFullSize();
-		Size.y += TextSize.y;
-
-		if(Size.x < TextSize.x)
-			Size.x = TextSize.x;
+		Out += RowTree[i];
 	};
 
-	return Size;
-};
-
-void UIText::Update(const Vector2 &ParentPosition)
-{
-	//Do nothing
+	return Out;
 };
 
-void UIText::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+unsigned long UITextEditor::FindLineAtRow(unsigned long Row, unsigned long &RowInLine) const
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+	unsigned long Position = 0, Step = 1;
+	long Remaining = Row;
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
-		return;
-
-	unsigned long YOffset = 0;
-
-	if(TextAlignment & UITextAlignment::VCenter)
+	while(Step * 2 < RowTree.size())
 	{
-		YOffset = (unsigned long)(SizeValue.y - (Strings.size() * (FontSize + 4))) / 2;
+		Step *= 2;
 	};
 
-	for(unsigned long i = 0, TextYOffset = YOffset; i < Strings.size(); i++, TextYOffset += FontSize + 4)
+	//Find the most slots whose rows all come before Row, which skips the line gap since it has no rows
+	for(; Step > 0; Step /= 2)
 	{
-		if(TextAlignment & UITextAlignment::Center)
-		{
-			RenderText(*Renderer, Strings[i], Manager->GetDefaultFont(), FontSize,
-				Params.Position(ActualPosition + Vector2((SizeValue.x -
-				MeasureTextSimple(Strings[i], Manager->GetDefaultFont(),
-				FontSize).ToFullSize().x) / 2, (float)TextYOffset)));
-		}
-		else if(TextAlignment & UITextAlignment::Right)
-		{
-			RenderText(*Renderer, Strings[i], Manager->GetDefaultFont(), FontSize, 
-				Params.Position(ActualPosition + Vector2(SizeValue.x -
-				MeasureTextSimple(Strings[i], Manager->GetDefaultFont(),
-				FontSize).ToFullSize().x, (float)TextYOffset)));
-		}
-		else
+		if(Position + Step < RowTree.size() && RowTree[Position + Step] <= Remaining)
 		{
-			RenderText(*Renderer, Strings[i], Manager->GetDefaultFont(), FontSize,
-				Params.Position(ActualPosition + Vector2(0, (float)TextYOffset)));
+			Position += Step;
+			Remaining -= RowTree[Position];
 		};
 	};
-};
-
-void UISprite::PerformLayout()
-{
-};
 
-void UISprite::Update(const Vector2 &ParentPosition)
-{
-	PerformLayout();
+	if(Position >= Lines.size() || (Position >= LineGapStart && Position < LineGapEnd))
+	{
+		unsigned long Last = GetLineCount() - 1;
 
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+		RowInLine = Lines[GetLineSlot(Last)].RowCount - 1;
 
-	for(unsigned long i = 0; i < Children.size(); i++)
-	{
-		Children[i]->Update(ActualPosition);
+		return Last;
 	};
+
+	RowInLine = Remaining;
+
+	return Position < LineGapStart ? Position : Position - (LineGapEnd - LineGapStart);
 };
 
-void UISprite::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+void UITextEditor::GetRowRange(unsigned long Index, unsigned long Row, unsigned long &Start, unsigned long &Count) const
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+	const Line &TheLine = Lines[GetLineSlot(Index)];
+	unsigned long Length = GetLineLength(Index);
+
+	//Lines that weren't wrapped yet are shown whole on their first row
+	if(TheLine.WrapDirty)
+	{
+		Start = GetLineStart(Index);
+		Count = Row == 0 ? Length : 0;
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
 		return;
+	};
 
-	TheSprite.Options = TheSprite.Options.Position(ActualPosition);
-	TheSprite.Draw(Renderer);
+	unsigned long RowStart = Row == 0 ? 0 : TheLine.Wraps[Row - 1];
+	unsigned long RowEnd = Row < TheLine.Wraps.size() ? TheLine.Wraps[Row] : Length;
 
-	for(unsigned long i = 0; i < Children.size(); i++)
+	Start = GetLineStart(Index) + RowStart;
+	Count = RowEnd - RowStart;
+};
+
+float UITextEditor::GetTextWidth(unsigned long Start, unsigned long Count) const
+{
+	sf::Font *Font = Manager->GetDefaultFont();
+	float Out = 0;
+
+	for(unsigned long i = Start; i < Start + Count; i++)
 	{
-		Children[i]->Draw(ActualPosition, Renderer);
+		Out += TextEngine::Instance.GetKerning(Font, FontSize, i > Start ? Text[i - 1] : 0, Text[i]) +
+			TextEngine::Instance.GetAdvance(Font, FontSize, Text[i]);
 	};
+
+	return Out;
 };
 
-void UIScrollbar::OnSkinChange()
+unsigned long UITextEditor::GetPositionAt(unsigned long Start, unsigned long Count, float x) const
 {
-	std::string TexturePath = Skin->GetString("Scrollbar", "BackgroundTexture");
+	sf::Font *Font = Manager->GetDefaultFont();
+	float Position = 0;
 
-	BackgroundTexture = LoadTexture(TexturePath);
+	for(unsigned long i = Start; i < Start + Count; i++)
+	{
+		float Advance = TextEngine::Instance.GetKerning(Font, FontSize, i > Start ? Text[i - 1] : 0, Text[i]) +
+			TextEngine::Instance.GetAdvance(Font, FontSize, Text[i]);
 
-	std::string NinePatchRectValue = Skin->GetString("Scrollbar", "BackgroundTextureRect");
+		//Closer to this character's left edge than its right one
+		if(x < Position + Advance / 2)
+			return i;
 
-	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &BackgroundTextureRect.Left, &BackgroundTextureRect.Right,
-		&BackgroundTextureRect.Top, &BackgroundTextureRect.Bottom);
+		Position += Advance;
+	};
 
-	TexturePath = Skin->GetString("Scrollbar", "HandleTexture");
+	return Start + Count;
+};
 
-	HandleTexture = LoadTexture(TexturePath);
+void UITextEditor::GetCursorRow(unsigned long &Index, unsigned long &Row)
+{
+	Index = FindLine(CursorPosition);
 
-	NinePatchRectValue = Skin->GetString("Scrollbar", "HandleTextureRect");
+	const Line &TheLine = Lines[GetLineSlot(Index)];
 
-	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &HandleTextureRect.Left, &HandleTextureRect.Right,
-		&HandleTextureRect.Top, &HandleTextureRect.Bottom);
+	//A cursor right at a wrap is shown at the start of the next row
+	Row = TheLine.WrapDirty ? 0 : std::upper_bound(TheLine.Wraps.begin(), TheLine.Wraps.end(), CursorPosition - GetLineStart(Index)) -
+		TheLine.Wraps.begin();
+};
 
-	std::string PaddingValue = Skin->GetString("Scrollbar", "Padding");
+bool UITextEditor::GetVisibleRows(unsigned long &First, unsigned long &Last)
+{
+	const Rect &Clip = GetClipRect();
+	float AbsoluteTop = GetAbsolutePosition().y + Padding;
+	float WindowHeight = (float)Manager->GetOwner()->getSize().y;
+	float VisibleTop = (Clip.Top > 0 ? Clip.Top : 0) - AbsoluteTop;
+	float VisibleBottom = (Clip.Bottom < WindowHeight ? Clip.Bottom : WindowHeight) - AbsoluteTop;
 
-	sscanf(PaddingValue.c_str(), "%u", &Padding);
+	if(VisibleBottom < 0 || VisibleBottom < VisibleTop)
+		return false;
 
-	std::string MinSizeValue = Skin->GetString("Scrollbar", "MinSize");
+	First = VisibleTop > 0 ? (unsigned long)(VisibleTop / LineSpacing) : 0;
+	Last = (unsigned long)(VisibleBottom / LineSpacing);
 
-	sscanf(MinSizeValue.c_str(), "%u", &MinSize);
+	if(First >= TotalRows)
+		return false;
 
-	SelectBoxExtraSize = Vector2(BackgroundTextureRect.Left + BackgroundTextureRect.Right, BackgroundTextureRect.Top + BackgroundTextureRect.Bottom);
-};
+	if(Last >= TotalRows)
+		Last = TotalRows - 1;
 
-void UIScrollbar::PerformLayout()
-{
+	return true;
 };
 
-void UIScrollbar::Update(const Vector2 &ParentPosition)
+void UITextEditor::Insert(unsigned long Position, const std::wstring &String)
 {
-	if(this == Manager->GetFocusedElement().Get() && Manager->GetInput()->MouseButtons[sf::Mouse::Left].Pressed)
-	{
-		Vector2 ActualPosition = ParentPosition + PositionValue;
+	if(String.length() == 0)
+		return;
 
-		unsigned long Steps = (MaxValue - MinValue) / ValueStep;
+	if(Position > Text.GetSize())
+		Position = Text.GetSize();
 
-		AxisAlignedBoundingBox AABB;
+	unsigned long Index = FindLine(Position);
 
-		for(unsigned long i = 0; i <= Steps; i++)
-		{
-			float StepOffset = (Vertical ? (SizeValue.y + SelectBoxExtraSize.y) / Steps * i : (SizeValue.x + SelectBoxExtraSize.x) / Steps * i);
+	//Lines after ours count their Start from the end of the text, so inserting before them doesn't change it
+	MoveLineGap(Index + 1);
 
-			AABB.min = ActualPosition + (Vertical ? Vector2((float)Padding, StepOffset + Padding - SelectBoxExtraSize.y / 2) : 
-				Vector2(StepOffset + Padding - SelectBoxExtraSize.x / 2, (float)Padding)) - SelectBoxExtraSize / 2;
-			AABB.max = ActualPosition + (Vertical ? Vector2(SizeValue.x - Padding * 2 + BackgroundTextureRect.Left + BackgroundTextureRect.Right,
-				StepOffset + Padding - SelectBoxExtraSize.y / 2 + (float)MinSize) :
-				Vector2(StepOffset + Padding - SelectBoxExtraSize.x / 2 + (float)MinSize,
-				SizeValue.y - Padding * 2 + BackgroundTextureRect.Top + BackgroundTextureRect.Bottom)) + SelectBoxExtraSize / 2;
+	Text.Insert(Position, String.c_str(), String.length());
 
-			if(AABB.IsInside(Manager->GetInput()->MousePosition))
-			{
-				bool NeedsChange = CurrentStep != i;
+	//Every newline starts a new line after ours, added in order at the gap
+	for(unsigned long i = 0; i < String.length(); i++)
+	{
+		if(String[i] == L'\n')
+			InsertLine(Position + i + 1);
+	};
 
-				CurrentStep = i;
+	Lines[Index].WrapDirty = true;
+	SetLineRowCount(Index, 1);
 
-				if(NeedsChange)
-					OnChange(this);
+	if(CursorPosition >= Position)
+		CursorPosition += String.length();
 
-				return;
-			};
-		};
-	};
+	InvalidateLayout();
 };
 
-void UIScrollbar::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+void UITextEditor::Erase(unsigned long Position, unsigned long Count)
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+	if(Position >= Text.GetSize())
+		return;
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
+	if(Position + Count > Text.GetSize())
+		Count = Text.GetSize() - Position;
+
+	if(Count == 0)
 		return;
 
-	unsigned long Steps = (MaxValue - MinValue) / ValueStep;
-	float StepOffset = Vertical ? (SizeValue.y + SelectBoxExtraSize.y) / Steps * CurrentStep : (SizeValue.x + SelectBoxExtraSize.x) / Steps * CurrentStep;
+	unsigned long First = FindLine(Position), Last = FindLine(Position + Count);
 
-	Sprite TheSprite;
-	TheSprite.SpriteTexture = BackgroundTexture;
-	TheSprite.Options.Position(ActualPosition).NinePatch(true, BackgroundTextureRect).Scale(SizeValue);
-	TheSprite.Draw(Renderer);
+	//Lines after the erased ones count their Start from the end of the text, so erasing before them doesn't change it
+	MoveLineGap(Last + 1);
 
-	TheSprite.SpriteTexture = HandleTexture;
+	//Lines whose newline is erased are merged into the first one, and are right before the gap
+	while(LineGapStart > First + 1)
+	{
+		LineGapStart--;
 
-	TheSprite.Options.Position(ActualPosition + (Vertical ? Vector2((float)Padding, StepOffset + Padding) - BackgroundTextureRect.Position() :
-		Vector2(StepOffset + Padding, (float)Padding) - BackgroundTextureRect.Position())).NinePatch(true, HandleTextureRect)
-		.Scale(Vertical ? Vector2(SizeValue.x - Padding * 2 + BackgroundTextureRect.Left + BackgroundTextureRect.Right, (float)MinSize) :
-		Vector2((float)MinSize, SizeValue.y - Padding * 2 + BackgroundTextureRect.Top + BackgroundTextureRect.Bottom));
+		AddRowsToSlot(LineGapStart, -(long)Lines[LineGapStart].RowCount);
+	};
 
-	TheSprite.Draw(Renderer);
-};
+	Text.Erase(Position, Count);
 
-void UITooltip::PerformLayout()
-{
-	sf::String Text = (Source ? Source->GetTooltipText() : OverrideText);
+	Lines[First].WrapDirty = true;
+	SetLineRowCount(First, 1);
 
-	Vector2 ActualFontSize = MeasureTextSimple(Text, Manager->GetDefaultFont(), FontSize).ToFullSize();
+	if(CursorPosition > Position + Count)
+	{
+		CursorPosition -= Count;
+	}
+	else if(CursorPosition > Position)
+	{
+		CursorPosition = Position;
+	};
 
-	SizeValue = Vector2(ActualFontSize.x + 10, ActualFontSize.y + 10);
+	InvalidateLayout();
 };
 
-void UITooltip::Update(const Vector2 &ParentPosition)
+sf::String UITextEditor::GetText() const
 {
-	PerformLayout();
+	std::wstring Out;
+
+	Text.Get(0, Text.GetSize(), Out);
+
+	return Out;
 };
 
-void UITooltip::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+void UITextEditor::SetText(const sf::String &String)
 {
-	SuperSmartPointer<UIPanel> MouseOverElement = Manager->GetMouseOverElement();
+	std::wstring WideString = String.toWideString();
 
-	if((Source.Get() == NULL || MouseOverElement != Source) && OverrideText.getSize() == 0)
-		return;
+	WideString.erase(std::remove(WideString.begin(), WideString.end(), L'\r'), WideString.end());
 
-	if(OverrideText.getSize() && Source.Get() == NULL && MouseOverElement.Get())
-		return;
+	Text.SetText(WideString);
 
-	sf::String Text = (Source ? Source->GetTooltipText() : OverrideText);
+	Lines.clear();
+	Lines.push_back(Line());
 
-	Vector2 ActualFontSize = MeasureTextSimple(Text, Manager->GetDefaultFont(), FontSize).ToFullSize();
+	for(unsigned long i = 0; i < WideString.length(); i++)
+	{
+		if(WideString[i] == L'\n')
+		{
+			Line NewLine;
+			NewLine.Start = i + 1;
 
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+			Lines.push_back(NewLine);
+		};
+	};
 
-	ActualPosition.y -= SizeValue.y;
+	//The line gap starts out empty, at the end
+	LineGapStart = LineGapEnd = Lines.size();
 
-	if(ActualPosition.x > Renderer->getSize().x / 2)
-		ActualPosition.x -= SizeValue.x;
+	RebuildRowTree();
 
-	if(AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x ||
-		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
-		return;
+	CursorPosition = 0;
 
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
-	glDisableClientState(GL_NORMAL_ARRAY);
-	glBindTexture(GL_TEXTURE_2D, NULL);
+	InvalidateLayout();
+};
 
-	Vector2 Vertices[6] = {
-		ActualPosition,
-		ActualPosition + Vector2(0, SizeValue.y),
-		ActualPosition + SizeValue,
-		ActualPosition + SizeValue,
-		ActualPosition + Vector2(SizeValue.x, 0),
-		ActualPosition,
-	};
+void UITextEditor::OnMouseJustPressedTextEditor(UIPanel *This, const InputCenter::MouseButtonInfo &o)
+{
+	if(this != Manager->GetFocusedElement() || o.Name != sf::Mouse::Left)
+		return;
 
-	glColor4f(0.98f, 0.96f, 0.815f, 1);
+	Vector2 Local = Manager->GetInput()->MousePosition - GetAbsolutePosition() - Vector2((float)Padding, (float)Padding);
+	unsigned long RowInLine, Start, Count;
+	unsigned long Index = FindLineAtRow(Local.y > 0 ? (unsigned long)(Local.y / LineSpacing) : 0, RowInLine);
 
-	glVertexPointer(2, GL_FLOAT, 0, Vertices);
+	GetRowRange(Index, RowInLine, Start, Count);
 
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	CursorPosition = GetPositionAt(Start, Count, Local.x);
 
-	glColor4f(1, 1, 1, 1);
+	ResetCursorBlink();
+};
 
-	RenderText(*Renderer, Text, Manager->GetDefaultFont(), FontSize,
-		TextParams().Color(Vector4(0, 0, 0, 1)).Position(ActualPosition + (SizeValue - ActualFontSize) / 2));
+void UITextEditor::OnKeyJustPressedTextEditor(UIPanel *This, const InputCenter::KeyInfo &o)
+{
+	if(this != Manager->GetFocusedElement())
+		return;
+
+	unsigned long Index, Row, Start, Count;
+
+	GetCursorRow(Index, Row);
+	GetRowRange(Index, Row, Start, Count);
+
+	if(o.Name == sf::Keyboard::Left)
+	{
+		if(CursorPosition == 0)
+			return;
+
+		CursorPosition--;
+	}
+	else if(o.Name == sf::Keyboard::Right)
+	{
+		if(CursorPosition >= Text.GetSize())
+			return;
+
+		CursorPosition++;
+	}
+	else if(o.Name == sf::Keyboard::Up || o.Name == sf::Keyboard::Down)
+	{
+		unsigned long GlobalRow = GetRowsBefore(Index) + Row;
+
+		if((o.Name == sf::Keyboard::Up && GlobalRow == 0) || (o.Name == sf::Keyboard::Down && GlobalRow + 1 >= TotalRows))
+			return;
+
+		//Keep the same distance from the left edge
+		float x = GetTextWidth(Start, CursorPosition - Start);
+
+		Index = FindLineAtRow(o.Name == sf::Keyboard::Up ? GlobalRow - 1 : GlobalRow + 1, Row);
+
+		GetRowRange(Index, Row, Start, Count);
+
+		CursorPosition = GetPositionAt(Start, Count, x);
+	}
+	else if(o.Name == sf::Keyboard::Home)
+	{
+		CursorPosition = Start;
+	}
+	else if(o.Name == sf::Keyboard::End)
+	{
+		CursorPosition = Start + Count;
+	}
+	else if(o.Name == sf::Keyboard::Delete)
+	{
+		Erase(CursorPosition, 1);
+	}
+	else
+	{
+		return;
+	};
+
+	ResetCursorBlink();
 };
 
-void UIWindow::CheckClosePressed(UIPanel *This)
+void UITextEditor::OnCharacterEnteredTextEditor(UIPanel *This)
 {
-	Vector2 ActualPosition = PositionValue - Vector2((float)Padding, 0) + GetParentPosition();
+	if(this != Manager->GetFocusedElement())
+		return;
 
-	Vector2 ActualSize = SizeValue + Vector2((float)Padding * 2, TextureRect.Top);
+	wchar_t Character = Manager->GetInput()->Character;
 
-	AxisAlignedBoundingBox AABB;
-	AABB.min = ActualPosition + Vector2(ActualSize.x - CloseButtonTexture->getSize().x - CloseButtonPosition.x,
-		CloseButtonPosition.y);
-	AABB.max = AABB.min + Vector2(CloseButtonTexture->getSize().x, CloseButtonTexture->getSize().y);
+	if(Character == 8) //Hardcoded Backspace
+	{
+		if(CursorPosition == 0)
+			return;
 
-	if(AABB.IsInside(Manager->GetInput()->MousePosition))
+		Erase(CursorPosition - 1, 1);
+	}
+	else if(Character == L'\r' || Character == L'\n')
 	{
-		Closed = true;
-		SetVisible(false);
+		Insert(CursorPosition, L"\n");
+	}
+	else if(Character >= 32 || Character == L'\t')
+	{
+		Insert(CursorPosition, std::wstring(1, Character));
+	}
+	else
+	{
+		return;
 	};
+
+	ResetCursorBlink();
 };
 
-void UIWindow::OnSkinChange()
+void UITextEditor::OnSkinChange()
 {
-	std::string TexturePath = Skin->GetString("Window", "BackgroundTexture");
+	std::string TexturePath = Skin->GetString("TextBox", "BackgroundTextureMultiline");
 
-	BackgroundTexture = LoadTexture(TexturePath);
+	BackgroundTexture = Manager->GetSkinTexture(TexturePath);
 
-	std::string NinePatchRectValue = Skin->GetString("Window", "TextureRect");
+	std::string NinePatchRectValue = Skin->GetString("TextBox", "TextureRect");
 
 	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
 		&TextureRect.Top, &TextureRect.Bottom);
 
-	std::string PaddingValue = Skin->GetString("Window", "Padding");
+	FontSize = Manager->GetDefaultFontSize();
+
+	std::string PaddingValue = Skin->GetString("TextBox", "Padding");
 
 	sscanf(PaddingValue.c_str(), "%u", &Padding);
 
-	std::string TitleBarHeightValue = Skin->GetString("Window", "TitleBarHeight");
+	std::string LineSpacingValue = Skin->GetString("TextBox", "EditLineSpacing");
 
-	sscanf(TitleBarHeightValue.c_str(), "%u", &TitleHeight);
+	if(sscanf(LineSpacingValue.c_str(), "%f", &LineSpacing) != 1 || LineSpacing <= 0)
+	{
+		LineSpacing = FontSize * 1.15f;
+	};
 
-	std::string TitleBarOffsetValue = Skin->GetString("Window", "TitleBarOffset");
+	InvalidateLayout();
+};
 
-	sscanf(TitleBarOffsetValue.c_str(), "%u", &TitleOffset);
+void UITextEditor::PerformLayout()
+{
+	SizeValue.y = TotalRows * LineSpacing + Padding * 2.0f;
+};
 
-	std::string TitlePositionValue = Skin->GetString("Window", "TitlePosition");
+void UITextEditor::Update(const Vector2 &ParentPosition)
+{
+	bool Visible = this == Manager->GetFocusedElement() &&
+		(CursorBlinkClock.getElapsedTime().asMilliseconds() / TEXTBOX_CURSOR_BLINK_TIME) % 2 == 0;
 
-	sscanf(TitlePositionValue.c_str(), "%f,%f", &TitlePosition.x, &TitlePosition.y);
+	if(Visible != CursorVisible)
+	{
+		CursorVisible = Visible;
 
-	std::string TitleFontSizeValue = Skin->GetString("Window", "TitleFontSize");
+		Damage();
+	};
 
-	sscanf(TitleFontSizeValue.c_str(), "%u", &TitleFontSize);
+	float Width = SizeValue.x - Padding * 2.0f;
 
-	std::string TitleFontColorValue = Skin->GetString("Window", "TitleFontColor");
+	if(Width != WrapWidth || FontSize != WrapFontSize)
+	{
+		WrapWidth = Width;
+		WrapFontSize = FontSize;
 
-	sscanf(TitleFontColorValue.c_str(), "%f,%f,%f,%f", &TitleFontColor.x, &TitleFontColor.y, &TitleFontColor.z, &TitleFontColor.w);
+		//Unwrapped lines count as a single row until they're visible
+		for(unsigned long i = 0; i < Lines.size(); i++)
+		{
+			Lines[i].WrapDirty = true;
+			Lines[i].RowCount = 1;
+		};
 
-	std::string CloseButtonPositionValue = Skin->GetString("Window", "CloseButtonPosition");
+		RebuildRowTree();
 
-	sscanf(CloseButtonPositionValue.c_str(), "%f,%f", &CloseButtonPosition.x, &CloseButtonPosition.y);
+		Damage();
+	};
 
-	TexturePath = Skin->GetString("Window", "CloseButtonTexture");
+	//Lines are only wrapped once they're visible (or have the cursor), so edits never lay out the whole text
+	unsigned long First, Last, RowInLine, PreviousRows = TotalRows;
 
-	CloseButtonTexture = LoadTexture(TexturePath);
+	if(GetVisibleRows(First, Last))
+	{
+		unsigned long LastIndex = FindLineAtRow(Last, RowInLine);
 
-	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
+		for(unsigned long i = FindLineAtRow(First, RowInLine); i <= LastIndex; i++)
+		{
+			if(Lines[GetLineSlot(i)].WrapDirty)
+				WrapLine(i);
+		};
+	};
+
+	unsigned long CursorLine = FindLine(CursorPosition);
+
+	if(Lines[GetLineSlot(CursorLine)].WrapDirty)
+		WrapLine(CursorLine);
+
+	if(TotalRows != PreviousRows)
+		InvalidateLayout();
 };
 
-void UIWindow::PerformLayout()
+unsigned long UITextEditor::GetTimeUntilUpdate()
 {
-	for(unsigned long i = 0; i < Children.size(); i++)
-	{
-		Children[i]->PerformLayout();
-	};
+	if(this != Manager->GetFocusedElement())
+		return InputCenter::WaitForever;
+
+	//Until the cursor blinks
+	return TEXTBOX_CURSOR_BLINK_TIME - CursorBlinkClock.getElapsedTime().asMilliseconds() % TEXTBOX_CURSOR_BLINK_TIME;
 };
 
-void UIWindow::Update(const Vector2 &ParentPosition)
+void UITextEditor::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
 {
-	if(Closed)
-		return;
-
 	Vector2 ActualPosition = ParentPosition + PositionValue;
 
-	if(!Manager->GetInput()->MouseButtons[sf::Mouse::Left].Pressed)
-	{
-		Dragging = false;
-	}
-	else if(Manager->GetInput()->MouseButtons[sf::Mouse::Left].JustPressed &&
-		Manager->GetFocusedElement().Get() == this)
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	if(BackgroundTexture.Get())
 	{
-		Vector2 ActualSize = SizeValue + Vector2((float)Padding * 2, TextureRect.Top);
+		Sprite TheSprite;
+		TheSprite.SpriteTexture = BackgroundTexture;
+		TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(SizeValue);
 
-		AxisAlignedBoundingBox AABB;
-		AABB.min = ActualPosition + Vector2(0, (float)TitleOffset);
-		AABB.max = AABB.min + Vector2(ActualSize.x, (float)TitleHeight);
+		TheSprite.Draw(Renderer);
+	};
 
-		if(AABB.IsInside(Manager->GetInput()->MousePosition))
-		{
-			Dragging = true;
-			LastMousePosition = Manager->GetInput()->MousePosition;
-		};
-	}
-	else if(Dragging)
-	{
-		Vector2 Difference = Manager->GetInput()->MousePosition - LastMousePosition;
+	unsigned long First, Last, RowInLine, Start, Count;
 
-		ActualPosition += Difference;
-		PositionValue += Difference;
+	if(!GetVisibleRows(First, Last))
+		return;
 
-		if(Manager->GetCurrentMenuBar() && GetParentPosition().y + PositionValue.y < 30)
-		{
-			PositionValue.y = ActualPosition.y = 30;
-		};
+	unsigned long Index = FindLineAtRow(First, RowInLine);
 
-		float X = GetParentPosition().x + PositionValue.x;
+	for(unsigned long Row = First; Row <= Last && Index < GetLineCount(); Row++)
+	{
+		GetRowRange(Index, RowInLine, Start, Count);
 
-		if(X < 0)
+		if(Count)
 		{
-			PositionValue.x = ActualPosition.x = -X;
+			Text.Get(Start, Count, TextCache);
+
+			RenderText(*Renderer, TextCache, Manager->GetDefaultFont(), FontSize, TextParams().Color(Vector4(0, 0, 0, AlphaValue))
+				.Position(ActualPosition + Vector2((float)Padding, Padding + Row * LineSpacing)));
 		};
 
-		LastMousePosition = Manager->GetInput()->MousePosition;
+		if(++RowInLine >= Lines[GetLineSlot(Index)].RowCount)
+		{
+			Index++;
+			RowInLine = 0;
+		};
 	};
 
-	for(unsigned long i = 0; i < Children.size(); i++)
+	if(CursorVisible && this == Manager->GetFocusedElement())
 	{
-		Children[i]->Update(ActualPosition);
+		unsigned long Row;
+
+		GetCursorRow(Index, Row);
+		GetRowRange(Index, Row, Start, Count);
+
+		float x = GetTextWidth(Start, CursorPosition - Start);
+
+		SpriteBatch::Instance.AddRect(ActualPosition + Vector2(Padding + x, Padding + (GetRowsBefore(Index) + Row) * LineSpacing),
+			Vector2(TEXTBOX_BORDER_SIZE, LineSpacing), Vector4(0, 0, 0, AlphaValue));
 	};
 };
 
-void UIWindow::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+void UIScrollableFrame::OnSkinChange()
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue;
-	Vector2 ActualSize = SizeValue + Vector2((float)Padding * 2, TextureRect.Top);
+};
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x || ActualPosition.y + SizeValue.y < 0 ||
-		ActualPosition.y > Renderer->getSize().y))
-		return;
+void UIScrollableFrame::MakeScrolls()
+{
+	VerticalScroll.Dispose();
+	HorizontalScroll.Dispose();
 
-	Sprite TheSprite;
-	TheSprite.SpriteTexture = BackgroundTexture;
-	TheSprite.Options.Position(ActualPosition - Vector2((float)Padding, 0)).NinePatch(true, TextureRect).Scale(ActualSize);
+	VerticalScroll.Reset(new UIScrollbar(GetManager(), true));
+	HorizontalScroll.Reset(new UIScrollbar(GetManager(), false));
 
-	TheSprite.Draw(Renderer);
+	GetManager()->AddElement(MakeStringID(StringUtils::MakeIntString((unsigned long)this, true) + "_VERTICALSCROLL"), VerticalScroll);
+	GetManager()->AddElement(MakeStringID(StringUtils::MakeIntString((unsigned long)this, true) + "_HORIZONTALSCROLL"), HorizontalScroll);
+};
 
-	RenderText(*Renderer, Title, Manager->GetDefaultFont(), TitleFontSize,
-		TextParams().Color(TitleFontColor).Position(Vector2(ActualPosition + TitlePosition - Vector2((float)Padding, 0))));
+bool UIScrollableFrame::IsTranslatedChild(const UIPanel *Child) const
+{
+	//Our scrollbars stay in place
+	return Child != VerticalScroll.Get() && Child != HorizontalScroll.Get();
+};
 
-	Sprite CloseButtonSprite;
-	CloseButtonSprite.SpriteTexture = CloseButtonTexture;
-	CloseButtonSprite.Options.Position(ActualPosition - Vector2((float)Padding, 0) + Vector2(ActualSize.x - CloseButtonTexture->getSize().x - CloseButtonPosition.x,
-		CloseButtonPosition.y));
-	CloseButtonSprite.Draw(Renderer);
+bool UIScrollableFrame::GetContentClipRect(Rect &Out)
+{
+	const Vector2 &Position = GetAbsolutePosition();
+	Vector2 Size = SizeValue - Vector2(VerticalScroll.Get() && VerticalScroll->IsVisible() ? VerticalScroll->GetSize().x : 0,
+		HorizontalScroll.Get() && HorizontalScroll->IsVisible() ? HorizontalScroll->GetSize().y : 0);
+
+	Out = Rect(Position.x, Position.x + Size.x, Position.y, Position.y + Size.y);
+
+	return true;
+};
+
+void UIScrollableFrame::PerformLayout()
+{
+	UIPanel::PerformLayout();
+
+	ChildrenSizeValue = GetChildrenSize();
+
+	ChildOrder.clear();
+	ChildMaxHeight = 0;
 
 	for(unsigned long i = 0; i < Children.size(); i++)
 	{
-		Children[i]->Draw(ActualPosition, Renderer);
+		if(!IsTranslatedChild(Children[i]))
+			continue;
+
+		float Height = Children[i]->GetSize().y + Children[i]->GetExtraSize().y;
+
+		ChildOrder.push_back(std::pair<float, unsigned long>(Children[i]->GetPosition().y - Children[i]->GetExtraSize().y / 2, i));
+
+		if(ChildMaxHeight < Height)
+			ChildMaxHeight = Height;
 	};
+
+	std::sort(ChildOrder.begin(), ChildOrder.end());
 };
 
-bool UIWindow::IsClosed()
+void UIScrollableFrame::GetVisibleChildren(const Vector2 &Translation, std::vector<unsigned long> &Out)
 {
-	return Closed;
+	Out.clear();
+
+	//Children may have been added, removed or moved since ChildOrder was sorted
+	if(LayoutDirty)
+	{
+		for(unsigned long i = 0; i < Children.size(); i++)
+		{
+			if(IsTranslatedChild(Children[i]))
+				Out.push_back(i);
+		};
+
+		return;
+	};
+
+	//Only the vertical range is searched, children outside horizontally are culled when drawn
+	float Top = Translation.y, Bottom = Translation.y + SizeValue.y;
+
+	std::vector<std::pair<float, unsigned long> >::iterator it = std::lower_bound(ChildOrder.begin(), ChildOrder.end(),
+		std::pair<float, unsigned long>(Top - ChildMaxHeight, 0));
+
+	for(; it != ChildOrder.end() && it->first <= Bottom; it++)
+	{
+		Out.push_back(it->second);
+	};
+
+	//Overlapping children must still be drawn in order
+	std::sort(Out.begin(), Out.end());
 };
 
-void UIWindow::SetClosed(bool Value)
+void UIScrollableFrame::ScrollChildren(const Vector2 &PreviousTranslation)
 {
-	Closed = Value;
-	SetVisible(!Closed);
+	TransformVersion++;
+
+	//Where our children were and will be drawn is inside our area
+	Damage();
+
+	//Children that were hidden before and after still have no cells, their entries are updated when they scroll into view
+	std::vector<unsigned long> Moved, PreviouslyVisible;
+
+	GetVisibleChildren(TranslationValue, Moved);
+	GetVisibleChildren(PreviousTranslation, PreviouslyVisible);
+
+	Moved.insert(Moved.end(), PreviouslyVisible.begin(), PreviouslyVisible.end());
+	std::sort(Moved.begin(), Moved.end());
+	Moved.erase(std::unique(Moved.begin(), Moved.end()), Moved.end());
+
+	for(unsigned long i = 0; i < Moved.size(); i++)
+	{
+		Children[Moved[i]]->InvalidateHitTestBounds();
+	};
 };
 
-void UICheckBox::OnSkinChange()
+void UIScrollableFrame::Update(const Vector2 &ParentPosition)
 {
-	std::string TexturePath = Skin->GetString("CheckBox", "CheckTexture");
+	if(VerticalScroll.Get() == NULL || HorizontalScroll.Get() == NULL)
+		MakeScrolls();
 
-	CheckTexture = LoadTexture(TexturePath);
+	if((VerticalScroll->GetParent() == NULL || HorizontalScroll->GetParent() == NULL) &&
+		GetManager()->GetElement(ID) != SuperSmartPointer<UIPanel>())
+	{
+		AddChildren(VerticalScroll);
+		AddChildren(HorizontalScroll);
+	};
 
-	TexturePath = Skin->GetString("CheckBox", "UnCheckTexture");
+	Vector2 ActualPosition = ParentPosition + PositionValue;
 
-	UnCheckTexture = LoadTexture(TexturePath);
+	const Vector2 &ChildrenSize = ChildrenSizeValue;
+	Vector2 PreviousTranslation = TranslationValue;
+	bool PreviousVertical = VerticalScroll->IsVisible(), PreviousHorizontal = HorizontalScroll->IsVisible();
 
-	FontSize = Manager->GetDefaultFontSize();
-	FontColor = Manager->GetDefaultFontColor();
+	bool ShowVertical = ChildrenSize.y > SizeValue.y, ShowHorizontal = ChildrenSize.x > SizeValue.x;
 
-	std::string LabelOffsetValue = Skin->GetString("CheckBox", "LabelOffset");
+	//Calculate the final scrollbar sizes up front so their layout is only invalidated when they really change
+	Vector2 VerticalSize = Vector2(SCROLLBAR_DRAGGABLE_SIZE, SizeValue.y) - VerticalScroll->GetExtraSize();
+	Vector2 HorizontalSize = Vector2(SizeValue.x, SCROLLBAR_DRAGGABLE_SIZE) - HorizontalScroll->GetExtraSize();
 
-	sscanf(LabelOffsetValue.c_str(), "%f,%f", &LabelOffset.x, &LabelOffset.y);
-};
+	if(ShowVertical)
+	{
+		VerticalScroll->SetPosition(Vector2(SizeValue.x - VerticalSize.x, 0) +
+			Vector2(-VerticalScroll->GetExtraSize().x / 2.f, VerticalScroll->GetExtraSize().y / 2.f));
+		VerticalScroll->SetSize(ShowHorizontal ? VerticalSize - Vector2(0, HorizontalScroll->GetExtraSize().y + HorizontalSize.y) :
+			VerticalSize);
+		TranslationValue.y = (VerticalScroll->Value() / (float)VerticalScroll->MaxValue) * (ChildrenSize.y - SizeValue.y);
+	};
 
-void UICheckBox::CheckMouseClick(UIPanel *Self)
-{
-	Checked = !Checked;
-};
+	VerticalScroll->SetVisible(ShowVertical);
 
-void UICheckBox::PerformLayout()
-{
-	SizeValue = Vector2((CheckTexture.Get() ? (float)CheckTexture->getSize().x : 0.f) + MeasureTextSimple(Caption,
-		Manager->GetDefaultFont(), FontSize).ToFullSize().x + LabelOffset.x, CheckTexture.Get() ? (float)CheckTexture->getSize().y : 0.f);
-};
+	if(ShowHorizontal)
+	{
+		HorizontalScroll->SetPosition(Vector2(0, SizeValue.y - HorizontalSize.y) +
+			Vector2(HorizontalScroll->GetExtraSize().x / 2.f, -HorizontalScroll->GetExtraSize().y / 2.f));
+		HorizontalScroll->SetSize(ShowVertical ? HorizontalSize - Vector2(VerticalScroll->GetExtraSize().x + VerticalSize.x, 0) :
+			HorizontalSize);
+		TranslationValue.x = (HorizontalScroll->Value() / (float)HorizontalScroll->MaxValue) * (ChildrenSize.x - SizeValue.x);
+	};
+
+	HorizontalScroll->SetVisible(ShowHorizontal);
+
+	//Our children's positions and clipping depend on these, but scrolling only moves the children in view
+	if(ShowVertical != PreviousVertical || ShowHorizontal != PreviousHorizontal)
+	{
+		InvalidateChildTransforms();
+	}
+	else if(TranslationValue != PreviousTranslation)
+	{
+		ScrollChildren(PreviousTranslation);
+	};
+
+	if(VerticalScroll->IsVisible() && GetManager()->GetMouseOverElement().Get() == this)
+	{
+		long Step = Manager->GetInput()->MouseWheel < 0 ? 1 : Manager->GetInput()->MouseWheel > 0 ? -1 : 0;
+		unsigned long MaxSteps = (VerticalScroll->MaxValue - VerticalScroll->MinValue) / VerticalScroll->ValueStep;
+		unsigned long StepPower = (unsigned long)(MaxSteps * 0.05f);
+
+		if(Step < 0)
+		{
+			if(VerticalScroll->CurrentStep > StepPower)
+			{
+				VerticalScroll->CurrentStep -= StepPower;
+			}
+			else if(VerticalScroll->CurrentStep > 0)
+			{
+				VerticalScroll->CurrentStep = 0;
+			};
+		}
+		else if(Step > 0)
+		{
+			if(VerticalScroll->CurrentStep + StepPower < MaxSteps)
+			{
+				VerticalScroll->CurrentStep += StepPower;
+			}
+			else if(VerticalScroll->CurrentStep < MaxSteps)
+			{
+				VerticalScroll->CurrentStep = MaxSteps;
+			};
+		};
+	};
+
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->Update(ActualPosition);
+	};
+};
+
+void UIScrollableFrame::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	if(VerticalScroll.Get() == NULL || HorizontalScroll.Get() == NULL)
+		MakeScrolls();
+
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	SpriteBatch::Instance.AddRect(ActualPosition - Vector2(TEXTBOX_BORDER_SIZE, TEXTBOX_BORDER_SIZE),
+		SizeValue + Vector2(TEXTBOX_BORDER_SIZE * 2, TEXTBOX_BORDER_SIZE * 2), Vector4(0, 0, 0, AlphaValue));
+	SpriteBatch::Instance.AddRect(ActualPosition, SizeValue, Vector4(0.3f, 0.3f, 0.3f, AlphaValue));
+
+	const Vector2 &ChildrenSize = ChildrenSizeValue;
+
+	SpriteBatch::Instance.PushScissor(Rect((float)(long)ActualPosition.x,
+		(float)(long)(ActualPosition.x + SizeValue.x - (ChildrenSize.y > SizeValue.y ? VerticalScroll->GetSize().x : 0)),
+		(float)(long)ActualPosition.y, (float)(long)(ActualPosition.y + SizeValue.y - (ChildrenSize.x > SizeValue.x ? HorizontalScroll->GetSize().y : 0))),
+		(float)Renderer->getSize().y);
+
+	std::vector<unsigned long> Visible;
+
+	GetVisibleChildren(TranslationValue, Visible);
+
+	for(unsigned long i = 0; i < Visible.size(); i++)
+	{
+		Children[Visible[i]]->DrawLayered(ActualPosition - TranslationValue, Renderer);
+	};
+
+	SpriteBatch::Instance.PopScissor();
+
+	VerticalScroll->Draw(ActualPosition, Renderer);
+	HorizontalScroll->Draw(ActualPosition, Renderer);
+};
+
+void UIList::OnSkinChange()
+{
+	FontSize = GetManager()->GetDefaultFontSize();
+
+	std::string TexturePath = Skin->GetString("Menu", "SelectorBackgroundTexture");
+
+	SelectorBackgroundTexture = Manager->GetSkinTexture(TexturePath);
+};
+
+#define LIST_ROW_SPACING 2
+
+void UIList::PerformLayout()
+{
+	RowOffsets.clear();
+
+	unsigned long Count = GetItemCount();
+	float Height = 0;
+
+	if(VirtualizedValue)
+	{
+		Height = Count * (FontSize * 1.15f + LIST_ROW_SPACING);
+	}
+	else
+	{
+		RowOffsets.reserve(Count + 1);
+
+		for(unsigned long i = 0; i < Count; i++)
+		{
+			RowOffsets.push_back(Height);
+
+			Vector2 Size = MeasureTextSimple(GetItem(i), Manager->GetDefaultFont(), FontSize).ToFullSize();
+
+			float SizeY = (Size.y < FontSize * 1.15f ? FontSize * 1.15f : Size.y);
+
+			Height += SizeY + LIST_ROW_SPACING;
+		};
+
+		RowOffsets.push_back(Height);
+	};
+
+	//There's no space after the last row
+	SizeValue.y = Count ? Height - LIST_ROW_SPACING : 0;
+};
+
+unsigned long UIList::GetRowCount()
+{
+	if(VirtualizedValue)
+		return GetItemCount();
+
+	return RowOffsets.size() ? RowOffsets.size() - 1 : 0;
+};
+
+unsigned long UIList::FindRow(float y)
+{
+	unsigned long Count = GetRowCount(), Index;
+
+	if(y < 0)
+		return 0;
+
+	if(VirtualizedValue)
+	{
+		Index = (unsigned long)(y / (FontSize * 1.15f + LIST_ROW_SPACING));
+	}
+	else
+	{
+		Index = std::upper_bound(RowOffsets.begin(), RowOffsets.end(), y) - RowOffsets.begin() - 1;
+	};
+
+	return Index < Count ? Index : Count - 1;
+};
+
+long UIList::GetItemAt(float y)
+{
+	if(y < 0 || GetRowCount() == 0)
+		return -1;
+
+	unsigned long Index = FindRow(y);
+	float Top, Height;
+
+	GetRowArea(Index, Top, Height);
+
+	//Between rows, or past the last one
+	if(y > Top + Height)
+		return -1;
+
+	return Index;
+};
+
+void UIList::GetRowArea(unsigned long Index, float &Top, float &Height)
+{
+	if(VirtualizedValue)
+	{
+		Height = FontSize * 1.15f;
+		Top = Index * (Height + LIST_ROW_SPACING);
+
+		return;
+	};
+
+	Top = RowOffsets[Index];
+	Height = RowOffsets[Index + 1] - Top - LIST_ROW_SPACING;
+};
+
+void UIList::OnItemClickCheck(UIPanel *Self)
+{
+	const Vector2 &ActualPosition = GetAbsolutePosition();
+	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+	UIScrollableFrame *Parent = ParentValue.AsDerived<UIScrollableFrame>();
+	float Width = ParentValue->GetSize().x - (Parent->VerticalScroll->IsVisible() ? SCROLLBAR_DRAGGABLE_SIZE : 0);
+
+	if(MousePosition.x < ActualPosition.x || MousePosition.x > ActualPosition.x + Width)
+		return;
+
+	long Index = GetItemAt(MousePosition.y - ActualPosition.y);
+
+	if(Index != -1)
+	{
+		OnItemClick(this, Index);
+	};
+};
+
+void UIList::Update(const Vector2 &ParentPosition)
+{
+	long PreviousHoveredItem = HoveredItem;
+
+	HoveredItem = -1;
+
+	//Only look for the item under the mouse while the Manager tells us the mouse is over us
+	if(IsMouseOver())
+	{
+		Vector2 ActualPosition = ParentPosition + PositionValue;
+		const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+
+		if(MousePosition.x >= ActualPosition.x && MousePosition.x <= ActualPosition.x + SizeValue.x)
+		{
+			HoveredItem = GetItemAt(MousePosition.y - ActualPosition.y);
+		};
+	};
+
+	if(HoveredItem == PreviousHoveredItem)
+		return;
+
+	//The selector moved
+	Damage();
+
+	if(HoveredItem != -1)
+	{
+		OnItemMouseOver(this, HoveredItem);
+	};
+};
+
+void UIList::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	if(!ParentValue)
+		return;
+
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer) || GetRowCount() == 0)
+		return;
+
+	//Only rows inside the area we're visible in (and inside the window) are drawn
+	const Rect &Clip = GetClipRect();
+	float AbsoluteTop = GetAbsolutePosition().y;
+	float VisibleTop = (Clip.Top > 0 ? Clip.Top : 0) - AbsoluteTop;
+	float VisibleBottom = (Clip.Bottom < Renderer->getSize().y ? Clip.Bottom : Renderer->getSize().y) - AbsoluteTop;
+
+	if(VisibleBottom < VisibleTop)
+		return;
+
+	unsigned long First = FindRow(VisibleTop), Last = FindRow(VisibleBottom);
+
+	for(unsigned long i = First; i <= Last; i++)
+	{
+		float Top, Height;
+
+		GetRowArea(i, Top, Height);
+
+		Vector2 RowPosition = ActualPosition + Vector2(0, Top);
+
+		if((long)i == HoveredItem)
+		{
+			Sprite TheSprite;
+			TheSprite.SpriteTexture = SelectorBackgroundTexture;
+			TheSprite.Options.Position(RowPosition).Scale(Vector2(SizeValue.x, Height) /
+				Vector2(SelectorBackgroundTexture->getSize().x, SelectorBackgroundTexture->getSize().y));
+
+			TheSprite.Draw(Renderer);
+		};
+
+		RenderText(*Renderer, GetItem(i), Manager->GetDefaultFont(), FontSize,
+			TextParams().Color(GetManager()->GetDefaultFontColor()).Position(RowPosition));
+	};
+
+	glColor4f(1, 1, 1, 1);
+};
+
+const unsigned long UITreeView::RootNode;
+
+UITreeView::UITreeView(UIManager *Manager) : UIPanel(Manager), RowHeight(23), Indent(16), VisibleRowsDirty(false), HoveredRow(-1),
+	SelectedNode(-1), FontSize(16)
+{
+	OnConstructed();
+	OnClick.Connect(this, &UITreeView::OnRowClick);
+
+	ClearNodes();
+};
+
+void UITreeView::OnSkinChange()
+{
+	FontSize = GetManager()->GetDefaultFontSize();
+
+	std::string TexturePath = Skin->GetString("Tree", "BackgroundTexture");
+
+	BackgroundTexture = Manager->GetSkinTexture(TexturePath);
+
+	std::string NinePatchRectValue = Skin->GetString("Tree", "TextureRect");
+
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
+		&TextureRect.Top, &TextureRect.Bottom);
+
+	TexturePath = Skin->GetString("Tree", "CellTexture");
+
+	CellTexture = Manager->GetSkinTexture(TexturePath);
+
+	TexturePath = Skin->GetString("Tree", "ArrowTexture");
+
+	ArrowTexture = Manager->GetSkinTexture(TexturePath);
+
+	TexturePath = Skin->GetString("Tree", "FolderTexture");
+
+	FolderTexture = Manager->GetSkinTexture(TexturePath);
+
+	TexturePath = Skin->GetString("Tree", "FileTexture");
+
+	FileTexture = Manager->GetSkinTexture(TexturePath);
+
+	std::string RowHeightValue = Skin->GetString("Tree", "RowHeight");
+
+	sscanf(RowHeightValue.c_str(), "%f", &RowHeight);
+
+	std::string IndentValue = Skin->GetString("Tree", "Indent");
+
+	sscanf(IndentValue.c_str(), "%f", &Indent);
+
+	std::string TextOffsetValue = Skin->GetString("Tree", "TextOffset");
+
+	sscanf(TextOffsetValue.c_str(), "%f,%f", &TextOffset.x, &TextOffset.y);
+
+	//Rows are laid out with the row height
+	InvalidateLayout();
+};
+
+unsigned long UITreeView::AddNode(unsigned long Parent, const std::string &Caption, bool HasChildren, void *UserData)
+{
+	Node Out;
+	Out.Caption = Caption;
+	Out.UserData = UserData;
+	Out.Parent = Parent;
+	Out.Depth = Parent == RootNode ? 0 : Nodes[Parent].Depth + 1;
+	Out.HasChildren = HasChildren;
+
+	unsigned long Index = Nodes.size();
+
+	Nodes.push_back(Out);
+
+	Node &ParentNode = Nodes[Parent];
+	long PreviousLastChild = ParentNode.LastChild;
+
+	if(PreviousLastChild == -1)
+	{
+		ParentNode.FirstChild = Index;
+	}
+	else
+	{
+		Nodes[PreviousLastChild].NextSibling = Index;
+	};
+
+	ParentNode.LastChild = Index;
+	ParentNode.HasChildren = true;
+
+	//Children added while a node is being expanded are picked up once it is
+	for(long Ancestor = Parent; Ancestor != -1; Ancestor = Nodes[Ancestor].Parent)
+	{
+		if(!Nodes[Ancestor].Expanded)
+			return Index;
+	};
+
+	if(VisibleRowsDirty)
+		return Index;
+
+	//Top level nodes always go last, otherwise the rows are rebuilt once before they're next used, however many nodes are added
+	if(Parent == RootNode)
+	{
+		VisibleRows.push_back(Index);
+	}
+	else
+	{
+		VisibleRowsDirty = true;
+	};
+
+	InvalidateLayout();
+
+	return Index;
+};
+
+void UITreeView::RefreshVisibleRows()
+{
+	if(!VisibleRowsDirty)
+		return;
+
+	VisibleRowsDirty = false;
+
+	VisibleRows.clear();
+
+	AppendVisibleRows(RootNode, VisibleRows);
+};
+
+void UITreeView::ClearNodes()
+{
+	Nodes.clear();
+	VisibleRows.clear();
+	VisibleRowsDirty = false;
+
+	Node Root;
+	Root.Expanded = Root.ChildrenRequested = true;
+
+	Nodes.push_back(Root);
+
+	HoveredRow = SelectedNode = -1;
+
+	InvalidateLayout();
+};
+
+long UITreeView::FindRow(unsigned long Index)
+{
+	RefreshVisibleRows();
+
+	std::vector<unsigned long>::iterator it = std::find(VisibleRows.begin(), VisibleRows.end(), Index);
+
+	return it == VisibleRows.end() ? -1 : it - VisibleRows.begin();
+};
+
+void UITreeView::AppendVisibleRows(unsigned long Index, std::vector<unsigned long> &Out)
+{
+	for(long Child = Nodes[Index].FirstChild; Child != -1; Child = Nodes[Child].NextSibling)
+	{
+		Out.push_back(Child);
+
+		if(Nodes[Child].Expanded)
+			AppendVisibleRows(Child, Out);
+	};
+};
+
+void UITreeView::SetExpanded(unsigned long Index, long Row, bool Value)
+{
+	if(Index == RootNode || Nodes[Index].Expanded == Value || (Value && !Nodes[Index].HasChildren))
+		return;
+
+	if(Value && !Nodes[Index].ChildrenRequested)
+	{
+		Nodes[Index].ChildrenRequested = true;
+
+		OnRequestChildren(this, Index);
+
+		//The handler may have found out there's nothing inside
+		if(Nodes[Index].FirstChild == -1)
+		{
+			Nodes[Index].HasChildren = false;
+
+			Damage();
+
+			return;
+		};
+
+		//Or added nodes elsewhere, moving our row
+		if(Row != -1)
+			Row = FindRow(Index);
+	};
+
+	Nodes[Index].Expanded = Value;
+
+	//Only our rows change, so the rest are left where they are
+	if(Row != -1)
+	{
+		if(Value)
+		{
+			std::vector<unsigned long> Rows;
+
+			AppendVisibleRows(Index, Rows);
+
+			VisibleRows.insert(VisibleRows.begin() + Row + 1, Rows.begin(), Rows.end());
+		}
+		else
+		{
+			unsigned long End = Row + 1;
+
+			while(End < VisibleRows.size() && Nodes[VisibleRows[End]].Depth > Nodes[Index].Depth)
+			{
+				End++;
+			};
+
+			VisibleRows.erase(VisibleRows.begin() + Row + 1, VisibleRows.begin() + End);
+		};
+
+		HoveredRow = -1;
+
+		InvalidateLayout();
+	};
+
+	if(Value)
+	{
+		OnNodeExpanded(this, Index);
+	}
+	else
+	{
+		OnNodeCollapsed(this, Index);
+	};
+};
+
+void UITreeView::PerformLayout()
+{
+	RefreshVisibleRows();
+
+	SizeValue.y = VisibleRows.size() * RowHeight;
+};
+
+long UITreeView::GetRowAt(float y)
+{
+	RefreshVisibleRows();
+
+	if(y < 0)
+		return -1;
+
+	unsigned long Row = (unsigned long)(y / RowHeight);
+
+	return Row < VisibleRows.size() ? (long)Row : -1;
+};
+
+void UITreeView::OnRowClick(UIPanel *Self)
+{
+	const Vector2 &ActualPosition = GetAbsolutePosition();
+	long Row = GetRowAt(Manager->GetInput()->MousePosition.y - ActualPosition.y);
+
+	if(Row == -1)
+		return;
+
+	unsigned long Index = VisibleRows[Row];
+
+	SelectedNode = Index;
+
+	Damage();
+
+	if(Nodes[Index].HasChildren)
+	{
+		SetExpanded(Index, Row, !Nodes[Index].Expanded);
+	};
+
+	OnNodeClick(this, Index);
+};
+
+void UITreeView::Update(const Vector2 &ParentPosition)
+{
+	long PreviousHoveredRow = HoveredRow;
+
+	HoveredRow = -1;
+
+	if(IsMouseOver())
+	{
+		Vector2 ActualPosition = ParentPosition + PositionValue;
+
+		HoveredRow = GetRowAt(Manager->GetInput()->MousePosition.y - ActualPosition.y);
+	};
+
+	if(HoveredRow != PreviousHoveredRow)
+	{
+		Damage();
+	};
+};
+
+void UITreeView::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	RefreshVisibleRows();
+
+	//Only rows inside the area we're visible in (and inside the window) are drawn
+	const Rect &Clip = GetClipRect();
+	float AbsoluteTop = GetAbsolutePosition().y;
+	float VisibleTop = (Clip.Top > 0 ? Clip.Top : 0) - AbsoluteTop;
+	float VisibleBottom = (Clip.Bottom < Renderer->getSize().y ? Clip.Bottom : Renderer->getSize().y) - AbsoluteTop;
+
+	VisibleTop = VisibleTop > 0 ? VisibleTop : 0;
+	VisibleBottom = VisibleBottom < SizeValue.y ? VisibleBottom : SizeValue.y;
+
+	if(VisibleBottom <= VisibleTop)
+		return;
+
+	Sprite TheSprite;
+
+	//The background only covers what's visible, since we may be millions of pixels tall
+	if(BackgroundTexture.Get())
+	{
+		TheSprite.SpriteTexture = BackgroundTexture;
+		TheSprite.Options.NinePatch(true, TextureRect).Position(ActualPosition + Vector2(0, VisibleTop))
+			.Scale(Vector2(SizeValue.x, VisibleBottom - VisibleTop)).Color(Vector4(1, 1, 1, AlphaValue));
+
+		TheSprite.Draw(Renderer);
+
+		TheSprite.Options.NinePatch(false, TextureRect);
+	};
+
+	unsigned long First = (unsigned long)(VisibleTop / RowHeight), Last = (unsigned long)(VisibleBottom / RowHeight);
+
+	if(Last >= VisibleRows.size())
+		Last = VisibleRows.size() - 1;
+
+	for(unsigned long i = First; i <= Last; i++)
+	{
+		const Node &TheNode = Nodes[VisibleRows[i]];
+		Vector2 RowPosition = ActualPosition + Vector2(0, i * RowHeight);
+
+		if(CellTexture.Get() && ((long)VisibleRows[i] == SelectedNode || (long)i == HoveredRow))
+		{
+			TheSprite.SpriteTexture = CellTexture;
+			TheSprite.Options.Position(RowPosition).Rotation(0).Scale(Vector2(SizeValue.x, RowHeight) /
+				Vector2(CellTexture->getSize().x, CellTexture->getSize().y))
+				.Color(Vector4(1, 1, 1, ((long)VisibleRows[i] == SelectedNode ? 1 : 0.5f) * AlphaValue));
+
+			TheSprite.Draw(Renderer);
+		};
+
+		Vector2 Position = RowPosition + Vector2(TheNode.Depth * Indent, 0);
+
+		if(TheNode.HasChildren && ArrowTexture.Get())
+		{
+			Vector2 ArrowSize((float)ArrowTexture->getSize().x, (float)ArrowTexture->getSize().y);
+
+			Vector2 ArrowCenter = Position + Vector2(Indent, RowHeight) / 2;
+
+			//Rotated sprites are positioned by their center rather than their top left
+			TheSprite.SpriteTexture = ArrowTexture;
+			TheSprite.Options.Position(TheNode.Expanded ? ArrowCenter : ArrowCenter - ArrowSize / 2).Scale(Vector2(1, 1))
+				.Rotation(TheNode.Expanded ? (float)MathUtils::Pi / 2 : 0).Color(Vector4(1, 1, 1, AlphaValue));
+
+			TheSprite.Draw(Renderer);
+		};
+
+		Position.x += Indent;
+
+		SuperSmartPointer<sf::Texture> Icon = TheNode.HasChildren ? FolderTexture : FileTexture;
+
+		if(Icon.Get())
+		{
+			TheSprite.SpriteTexture = Icon;
+			TheSprite.Options.Position(Position + Vector2(0, (RowHeight - Icon->getSize().y) / 2)).Scale(Vector2(1, 1))
+				.Rotation(0).Color(Vector4(1, 1, 1, AlphaValue));
+
+			TheSprite.Draw(Renderer);
+
+			Position.x += Icon->getSize().x;
+		};
+
+		RenderText(*Renderer, TheNode.Caption, Manager->GetDefaultFont(), FontSize,
+			TextParams().Color(GetManager()->GetDefaultFontColor()).Position(Position + TextOffset));
+	};
+};
+
+void UIDropdown::OnSkinChange()
+{
+	FontSize = GetManager()->GetDefaultFontSize();
+
+	std::string TexturePath = Skin->GetString("Dropdown", "BackgroundTexture");
+
+	BackgroundTexture = Manager->GetSkinTexture(TexturePath);
+
+	TexturePath = Skin->GetString("Dropdown", "DropdownTexture");
+
+	DropdownTexture = Manager->GetSkinTexture(TexturePath);
+
+	std::string NinePatchRectValue = Skin->GetString("Dropdown", "TextureRect");
+
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
+		&TextureRect.Top, &TextureRect.Bottom);
+
+	FontSize = GetManager()->GetDefaultFontSize();
+
+	std::string DropdownHeightString = Skin->GetString("Dropdown", "Height");
+
+	sscanf(DropdownHeightString.c_str(), "%f", &DropdownHeight);
+
+	std::string DropdownOffsetString = Skin->GetString("Dropdown", "Offset");
+
+	sscanf(DropdownOffsetString.c_str(), "%f,%f", &DropdownOffset.x, &DropdownOffset.y);
+
+	std::string TextOffsetString = Skin->GetString("Dropdown", "TextOffset");
+
+	sscanf(TextOffsetString.c_str(), "%f,%f", &TextOffset.x, &TextOffset.y);
+};
+
+void UIDropdown::PerformLayout()
+{
+	SizeValue.y = DropdownHeight;
+};
+
+void UIDropdown::SetSelectedItem(UIMenu::Item *Item)
+{
+	SelectedIndex = Item->Index;
+
+	//The menu is another root, so redrawing it doesn't redraw us
+	Damage();
+
+	OnItemClick(this);
+};
+
+void UIDropdown::OnItemClickCheck(UIPanel *Self)
+{
+	UIMenu *Menu = Self->GetManager()->CreateMenu(GetAbsolutePosition() + Vector2(0, DropdownHeight));
+
+	for(unsigned long i = 0; i < Items.size(); i++)
+	{
+		Menu->AddItem(Items[i]);
+	};
+
+	Menu->SetSize(Vector2(SizeValue.x, Menu->GetSize().y));
+	Menu->OnItemSelected.Connect(this, &UIDropdown::SetSelectedItem);
+};
+
+void UIDropdown::Update(const Vector2 &ParentPosition)
+{
+};
+
+void UIDropdown::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	static AxisAlignedBoundingBox AABB;
+
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	Sprite TheSprite;
+	TheSprite.SpriteTexture = BackgroundTexture;
+	TheSprite.Options.NinePatch(true, TextureRect).Position(ActualPosition).Scale(Vector2(SizeValue.x, DropdownHeight));
+
+	TheSprite.Draw(Renderer);
+
+	std::string ItemName;
+
+	if(SelectedIndex == -1 || SelectedIndex >= (long)Items.size())
+	{
+		ItemName = "(None)";
+	}
+	else
+	{
+		ItemName = Items[SelectedIndex];
+	};
+
+	RenderText(*Renderer, ItemName, GetManager()->GetDefaultFont(), FontSize, TextParams().Position(ActualPosition + TextOffset)
+		.Color(GetManager()->GetDefaultFontColor()));
+
+	TheSprite.SpriteTexture = DropdownTexture;
+	TheSprite.Options.NinePatch(false, TextureRect).Position(ActualPosition + Vector2(SizeValue.x - DropdownOffset.x - DropdownTexture->getSize().x,
+		DropdownOffset.y)).Scale(Vector2(1, 1));
+
+	TheSprite.Draw(Renderer);
+};
+
+void UIText::OnSkinChange()
+{
+	FontSize = Manager->GetDefaultFontSize();
+	Params.Color(Manager->GetDefaultFontColor()).SecondaryColor(Manager->GetDefaultSecondaryFontColor());
+};
+
+void UIText::SetText(const sf::String &String, bool AutoExpandHeight)
+{
+	Text = String;
+
+	TextEngine::Instance.BreakLines(Text, Manager->GetDefaultFont(), FontSize,
+		AutoExpandHeight ? Vector2(SizeValue.x, 9999999) : SizeValue, Lines);
+
+	Strings.resize(Lines.size());
+
+	//Line offsets count characters of Text, which don't match wchar_t units where wchar_t is 16 bits
+	for(unsigned long i = 0; i < Lines.size(); i++)
+	{
+		Strings[i] = Text.substring(Lines[i].Offset, Lines[i].Length);
+	};
+
+	InvalidateLayout();
+
+	if(AutoExpandHeight)
+	{
+		SetSize(Vector2(SizeValue.x, SizeValue.y > Strings.size() * (FontSize + 4) ? SizeValue.y : Strings.size() * (FontSize + 4)));
+	};
+};
+
+const sf::String &UIText::GetText()
+{
+	return Text;
+};
+
+Vector2 UIText::GetTextSize()
+{
+	Vector2 Size;
+
+	for(unsigned long i = 0; i < Strings.size(); i++)
+	{
+		Vector2 TextSize = MeasureTextSimple(Strings[i], Manager->GetDefaultFont(), FontSize).ToFullSize();
+		Size.y += TextSize.y;
+
+		if(Size.x < TextSize.x)
+			Size.x = TextSize.x;
+	};
+
+	return Size;
+};
+
+void UIText::Update(const Vector2 &ParentPosition)
+{
+	//Do nothing
+};
+
+void UIText::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	unsigned long YOffset = 0;
+
+	if(TextAlignment & UITextAlignment::VCenter)
+	{
+		YOffset = (unsigned long)(SizeValue.y - (Strings.size() * (FontSize + 4))) / 2;
+	};
+
+	for(unsigned long i = 0, TextYOffset = YOffset; i < Strings.size(); i++, TextYOffset += FontSize + 4)
+	{
+		if(TextAlignment & UITextAlignment::Center)
+		{
+			RenderText(*Renderer, Strings[i], Manager->GetDefaultFont(), FontSize,
+				Params.Position(ActualPosition + Vector2((SizeValue.x - Lines[i].Width) / 2, (float)TextYOffset)));
+		}
+		else if(TextAlignment & UITextAlignment::Right)
+		{
+			RenderText(*Renderer, Strings[i], Manager->GetDefaultFont(), FontSize, 
+				Params.Position(ActualPosition + Vector2(SizeValue.x - Lines[i].Width, (float)TextYOffset)));
+		}
+		else
+		{
+			RenderText(*Renderer, Strings[i], Manager->GetDefaultFont(), FontSize,
+				Params.Position(ActualPosition + Vector2(0, (float)TextYOffset)));
+		};
+	};
+};
+
+void UISprite::SetTexture(SuperSmartPointer<sf::Texture> Texture)
+{
+	//Fit on the next Update, since it depends on the crop and nine-patch options too
+	TheSprite.SpriteTexture = Texture;
+	FitPending = Texture.Get() != NULL;
+
+	Damage();
+};
+
+void UISprite::FitTexture()
+{
+	FitPending = false;
+
+	Vector2 TextureSize((float)TheSprite.SpriteTexture->getSize().x, (float)TheSprite.SpriteTexture->getSize().y);
+
+	if(GetSize() == Vector2())
+		SetSize(TextureSize);
+
+	if(TheSprite.Options.CropModeValue == CropMode::CropTiled)
+	{
+		//Scale a single frame to the frame size
+		TheSprite.Options.Scale(Vector2(TheSprite.Options.CropRectValue.Left, TheSprite.Options.CropRectValue.Top) / TextureSize);
+	}
+	else if(TheSprite.Options.NinePatchValue)
+	{
+		TheSprite.Options.Scale(GetSize());
+	}
+	else
+	{
+		TheSprite.Options.Scale(GetSize() / TextureSize);
+	};
+
+	Damage();
+};
+
+void UISprite::PerformLayout()
+{
+};
+
+void UISprite::Update(const Vector2 &ParentPosition)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(FitPending && TheSprite.SpriteTexture.Get() && TheSprite.SpriteTexture->getSize().x != 0)
+		FitTexture();
+
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->Update(ActualPosition);
+	};
+};
+
+void UISprite::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	//Draw nothing until the texture is uploaded
+	if(TheSprite.SpriteTexture.Get() && TheSprite.SpriteTexture->getSize().x != 0)
+	{
+		TheSprite.Options = TheSprite.Options.Position(ActualPosition);
+		TheSprite.Draw(Renderer);
+	};
+
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->DrawLayered(ActualPosition, Renderer);
+	};
+};
+
+void UIScrollbar::OnSkinChange()
+{
+	std::string TexturePath = Skin->GetString("Scrollbar", "BackgroundTexture");
+
+	BackgroundTexture = Manager->GetSkinTexture(TexturePath);
+
+	std::string NinePatchRectValue = Skin->GetString("Scrollbar", "BackgroundTextureRect");
+
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &BackgroundTextureRect.Left, &BackgroundTextureRect.Right,
+		&BackgroundTextureRect.Top, &BackgroundTextureRect.Bottom);
+
+	TexturePath = Skin->GetString("Scrollbar", "HandleTexture");
+
+	HandleTexture = Manager->GetSkinTexture(TexturePath);
+
+	NinePatchRectValue = Skin->GetString("Scrollbar", "HandleTextureRect");
+
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &HandleTextureRect.Left, &HandleTextureRect.Right,
+		&HandleTextureRect.Top, &HandleTextureRect.Bottom);
+
+	std::string PaddingValue = Skin->GetString("Scrollbar", "Padding");
+
+	sscanf(PaddingValue.c_str(), "%u", &Padding);
+
+	std::string MinSizeValue = Skin->GetString("Scrollbar", "MinSize");
+
+	sscanf(MinSizeValue.c_str(), "%u", &MinSize);
+
+	SelectBoxExtraSize = Vector2(BackgroundTextureRect.Left + BackgroundTextureRect.Right, BackgroundTextureRect.Top + BackgroundTextureRect.Bottom);
+};
+
+void UIScrollbar::PerformLayout()
+{
+};
+
+void UIScrollbar::Update(const Vector2 &ParentPosition)
+{
+	if(this == Manager->GetFocusedElement().Get() && Manager->GetInput()->MouseButtons[sf::Mouse::Left].Pressed)
+	{
+		Vector2 ActualPosition = ParentPosition + PositionValue;
+
+		unsigned long Steps = (MaxValue - MinValue) / ValueStep;
+
+		AxisAlignedBoundingBox AABB;
+
+		for(unsigned long i = 0; i <= Steps; i++)
+		{
+			float StepOffset = (Vertical ? (SizeValue.y + SelectBoxExtraSize.y) / Steps * i : (SizeValue.x + SelectBoxExtraSize.x) / Steps * i);
+
+			AABB.min = ActualPosition + (Vertical ? Vector2((float)Padding, StepOffset + Padding - SelectBoxExtraSize.y / 2) : 
+				Vector2(StepOffset + Padding - SelectBoxExtraSize.x / 2, (float)Padding)) - SelectBoxExtraSize / 2;
+			AABB.max = ActualPosition + (Vertical ? Vector2(SizeValue.x - Padding * 2 + BackgroundTextureRect.Left + BackgroundTextureRect.Right,
+				StepOffset + Padding - SelectBoxExtraSize.y / 2 + (float)MinSize) :
+				Vector2(StepOffset + Padding - SelectBoxExtraSize.x / 2 + (float)MinSize,
+				SizeValue.y - Padding * 2 + BackgroundTextureRect.Top + BackgroundTextureRect.Bottom)) + SelectBoxExtraSize / 2;
+
+			if(AABB.IsInside(Manager->GetInput()->MousePosition))
+			{
+				bool NeedsChange = CurrentStep != i;
+
+				CurrentStep = i;
+
+				if(NeedsChange)
+					OnChange(this);
+
+				return;
+			};
+		};
+	};
+};
+
+void UIScrollbar::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	unsigned long Steps = (MaxValue - MinValue) / ValueStep;
+	float StepOffset = Vertical ? (SizeValue.y + SelectBoxExtraSize.y) / Steps * CurrentStep : (SizeValue.x + SelectBoxExtraSize.x) / Steps * CurrentStep;
+
+	Sprite TheSprite;
+	TheSprite.SpriteTexture = BackgroundTexture;
+	TheSprite.Options.Position(ActualPosition).NinePatch(true, BackgroundTextureRect).Scale(SizeValue);
+	TheSprite.Draw(Renderer);
+
+	TheSprite.SpriteTexture = HandleTexture;
+
+	TheSprite.Options.Position(ActualPosition + (Vertical ? Vector2((float)Padding, StepOffset + Padding) - BackgroundTextureRect.Position() :
+		Vector2(StepOffset + Padding, (float)Padding) - BackgroundTextureRect.Position())).NinePatch(true, HandleTextureRect)
+		.Scale(Vertical ? Vector2(SizeValue.x - Padding * 2 + BackgroundTextureRect.Left + BackgroundTextureRect.Right, (float)MinSize) :
+		Vector2((float)MinSize, SizeValue.y - Padding * 2 + BackgroundTextureRect.Top + BackgroundTextureRect.Bottom));
+
+	TheSprite.Draw(Renderer);
+};
+
+void UITooltip::PerformLayout()
+{
+	LayoutText = (Source ? Source->GetTooltipText() : OverrideText);
+
+	Vector2 ActualFontSize = MeasureTextSimple(LayoutText, Manager->GetDefaultFont(), FontSize).ToFullSize();
+
+	SizeValue = Vector2(ActualFontSize.x + 10, ActualFontSize.y + 10);
+};
+
+void UITooltip::Update(const Vector2 &ParentPosition)
+{
+	//Our text comes from whatever we're hovering, so check it ourselves
+	if((Source ? Source->GetTooltipText() : OverrideText) != LayoutText)
+		InvalidateLayout();
+
+	UpdateLayout();
+};
+
+bool UITooltip::GetTooltipArea(const Vector2 &Position, sf::RenderWindow *Renderer, Rect &Out)
+{
+	SuperSmartPointer<UIPanel> MouseOverElement = Manager->GetMouseOverElement();
+
+	if((Source.Get() == NULL || MouseOverElement != Source) && OverrideText.getSize() == 0)
+		return false;
+
+	if(OverrideText.getSize() && Source.Get() == NULL && MouseOverElement.Get())
+		return false;
+
+	Vector2 ActualPosition = Position + PositionValue;
+
+	ActualPosition.y -= SizeValue.y;
+
+	if(ActualPosition.x > Renderer->getSize().x / 2)
+		ActualPosition.x -= SizeValue.x;
+
+	if(AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
+		ActualPosition.x > Renderer->getSize().x ||
+		ActualPosition.y + SizeValue.y < 0 || ActualPosition.y > Renderer->getSize().y))
+		return false;
+
+	Out = Rect(ActualPosition.x, ActualPosition.x + SizeValue.x, ActualPosition.y, ActualPosition.y + SizeValue.y);
+
+	return true;
+};
+
+void UITooltip::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Rect Area;
+
+	if(!GetTooltipArea(ParentPosition, Renderer, Area))
+		return;
+
+	sf::String Text = (Source ? Source->GetTooltipText() : OverrideText);
+
+	Vector2 ActualFontSize = MeasureTextSimple(Text, Manager->GetDefaultFont(), FontSize).ToFullSize();
+
+	Vector2 ActualPosition = Area.Position();
+
+	SpriteBatch::Instance.AddRect(ActualPosition, SizeValue, Vector4(0.98f, 0.96f, 0.815f, 1));
+
+	RenderText(*Renderer, Text, Manager->GetDefaultFont(), FontSize,
+		TextParams().Color(Vector4(0, 0, 0, 1)).Position(ActualPosition + (SizeValue - ActualFontSize) / 2));
+};
+
+void UIWindow::CheckClosePressed(UIPanel *This)
+{
+	Vector2 ActualPosition = GetAbsolutePosition() - Vector2((float)Padding, 0);
+
+	Vector2 ActualSize = SizeValue + Vector2((float)Padding * 2, TextureRect.Top);
+
+	AxisAlignedBoundingBox AABB;
+	AABB.min = ActualPosition + Vector2(ActualSize.x - CloseButtonTexture->getSize().x - CloseButtonPosition.x,
+		CloseButtonPosition.y);
+	AABB.max = AABB.min + Vector2(CloseButtonTexture->getSize().x, CloseButtonTexture->getSize().y);
+
+	if(AABB.IsInside(Manager->GetInput()->MousePosition))
+	{
+		Closed = true;
+		SetVisible(false);
+	};
+};
+
+void UIWindow::OnSkinChange()
+{
+	std::string TexturePath = Skin->GetString("Window", "BackgroundTexture");
+
+	BackgroundTexture = Manager->GetSkinTexture(TexturePath);
+
+	std::string NinePatchRectValue = Skin->GetString("Window", "TextureRect");
+
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
+		&TextureRect.Top, &TextureRect.Bottom);
+
+	std::string PaddingValue = Skin->GetString("Window", "Padding");
+
+	sscanf(PaddingValue.c_str(), "%u", &Padding);
+
+	std::string TitleBarHeightValue = Skin->GetString("Window", "TitleBarHeight");
+
+	sscanf(TitleBarHeightValue.c_str(), "%u", &TitleHeight);
+
+	std::string TitleBarOffsetValue = Skin->GetString("Window", "TitleBarOffset");
+
+	sscanf(TitleBarOffsetValue.c_str(), "%u", &TitleOffset);
+
+	std::string TitlePositionValue = Skin->GetString("Window", "TitlePosition");
+
+	sscanf(TitlePositionValue.c_str(), "%f,%f", &TitlePosition.x, &TitlePosition.y);
+
+	std::string TitleFontSizeValue = Skin->GetString("Window", "TitleFontSize");
+
+	sscanf(TitleFontSizeValue.c_str(), "%u", &TitleFontSize);
+
+	std::string TitleFontColorValue = Skin->GetString("Window", "TitleFontColor");
+
+	sscanf(TitleFontColorValue.c_str(), "%f,%f,%f,%f", &TitleFontColor.x, &TitleFontColor.y, &TitleFontColor.z, &TitleFontColor.w);
+
+	std::string CloseButtonPositionValue = Skin->GetString("Window", "CloseButtonPosition");
+
+	sscanf(CloseButtonPositionValue.c_str(), "%f,%f", &CloseButtonPosition.x, &CloseButtonPosition.y);
+
+	TexturePath = Skin->GetString("Window", "CloseButtonTexture");
+
+	CloseButtonTexture = Manager->GetSkinTexture(TexturePath);
+
+	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
+};
+
+void UIWindow::PerformLayout()
+{
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->UpdateLayout();
+	};
+};
+
+void UIWindow::Update(const Vector2 &ParentPosition)
+{
+	if(Closed)
+		return;
+
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!Manager->GetInput()->MouseButtons[sf::Mouse::Left].Pressed)
+	{
+		Dragging = false;
+	}
+	else if(Manager->GetInput()->MouseButtons[sf::Mouse::Left].JustPressed &&
+		Manager->GetFocusedElement().Get() == this)
+	{
+		Vector2 ActualSize = SizeValue + Vector2((float)Padding * 2, TextureRect.Top);
+
+		AxisAlignedBoundingBox AABB;
+		AABB.min = ActualPosition + Vector2(0, (float)TitleOffset);
+		AABB.max = AABB.min + Vector2(ActualSize.x, (float)TitleHeight);
+
+		if(AABB.IsInside(Manager->GetInput()->MousePosition))
+		{
+			Dragging = true;
+			LastMousePosition = Manager->GetInput()->MousePosition;
+		};
+	}
+	else if(Dragging)
+	{
+		Vector2 Difference = Manager->GetInput()->MousePosition - LastMousePosition;
+
+		ActualPosition += Difference;
+		PositionValue += Difference;
+
+		if(Manager->GetCurrentMenuBar() && GetParentPosition().y + PositionValue.y < 30)
+		{
+			PositionValue.y = ActualPosition.y = 30;
+		};
+
+		float X = GetParentPosition().x + PositionValue.x;
+
+		if(X < 0)
+		{
+			PositionValue.x = ActualPosition.x = -X;
+		};
+
+		InvalidateTransform();
+
+		LastMousePosition = Manager->GetInput()->MousePosition;
+	};
+
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->Update(ActualPosition);
+	};
+};
+
+Rect UIWindow::GetDrawArea()
+{
+	Rect Out = UIPanel::GetDrawArea();
+
+	//Our background is padded and includes the title bar
+	Out.Left -= Padding;
+	Out.Right += Padding;
+	Out.Bottom += TextureRect.Top;
+
+	return Out;
+};
+
+void UIWindow::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+	Vector2 ActualSize = SizeValue + Vector2((float)Padding * 2, TextureRect.Top);
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	Sprite TheSprite;
+	TheSprite.SpriteTexture = BackgroundTexture;
+	TheSprite.Options.Position(ActualPosition - Vector2((float)Padding, 0)).NinePatch(true, TextureRect).Scale(ActualSize);
+
+	TheSprite.Draw(Renderer);
+
+	RenderText(*Renderer, Title, Manager->GetDefaultFont(), TitleFontSize,
+		TextParams().Color(TitleFontColor).Position(Vector2(ActualPosition + TitlePosition - Vector2((float)Padding, 0))));
+
+	Sprite CloseButtonSprite;
+	CloseButtonSprite.SpriteTexture = CloseButtonTexture;
+	CloseButtonSprite.Options.Position(ActualPosition - Vector2((float)Padding, 0) + Vector2(ActualSize.x - CloseButtonTexture->getSize().x - CloseButtonPosition.x,
+		CloseButtonPosition.y));
+	CloseButtonSprite.Draw(Renderer);
+
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->DrawLayered(ActualPosition, Renderer);
+	};
+};
+
+bool UIWindow::IsClosed()
+{
+	return Closed;
+};
+
+void UIWindow::SetClosed(bool Value)
+{
+	Closed = Value;
+	SetVisible(!Closed);
+};
+
+void UICheckBox::OnSkinChange()
+{
+	std::string TexturePath = Skin->GetString("CheckBox", "CheckTexture");
+
+	CheckTexture = Manager->GetSkinTexture(TexturePath);
+
+	TexturePath = Skin->GetString("CheckBox", "UnCheckTexture");
+
+	UnCheckTexture = Manager->GetSkinTexture(TexturePath);
+
+	FontSize = Manager->GetDefaultFontSize();
+	FontColor = Manager->GetDefaultFontColor();
+
+	std::string LabelOffsetValue = Skin->GetString("CheckBox", "LabelOffset");
+
+	sscanf(LabelOffsetValue.c_str(), "%f,%f", &LabelOffset.x, &LabelOffset.y);
+};
+
+void UICheckBox::CheckMouseClick(UIPanel *Self)
+{
+	Checked = !Checked;
+
+	Damage();
+};
+
+void UICheckBox::PerformLayout()
+{
+	SizeValue = Vector2((CheckTexture.Get() ? (float)CheckTexture->getSize().x : 0.f) + MeasureTextSimple(Caption,
+		Manager->GetDefaultFont(), FontSize).ToFullSize().x + LabelOffset.x, CheckTexture.Get() ? (float)CheckTexture->getSize().y : 0.f);
+};
+
+void UICheckBox::Update(const Vector2 &ParentPosition)
+{
+};
+
+void UICheckBox::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	Sprite TheSprite;
+	TheSprite.SpriteTexture = Checked ? CheckTexture : UnCheckTexture;
+	TheSprite.Options = SpriteDrawOptions().Position(ActualPosition);
+	TheSprite.Draw(Renderer);
+
+	RenderText(*Renderer, Caption, Manager->GetDefaultFont(), FontSize, TextParams().Color(FontColor).Position(ActualPosition +
+		Vector2((float)TheSprite.SpriteTexture->getSize().x, 0) + LabelOffset));
+};
+
+void UIMenu::OnSkinChange()
+{
+	std::string TexturePath = Skin->GetString("Menu", "BackgroundTexture");
+
+	BackgroundTexture = Manager->GetSkinTexture(TexturePath);
+
+	TexturePath = Skin->GetString("Menu", "SelectorBackgroundTexture");
+
+	SelectorBackgroundTexture = Manager->GetSkinTexture(TexturePath);
+
+	std::string NinePatchRectValue = Skin->GetString("Menu", "TextureRect");
+
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
+		&TextureRect.Top, &TextureRect.Bottom);
+
+	std::string PaddingValue = Skin->GetString("Menu", "Padding");
+
+	sscanf(PaddingValue.c_str(), "%f,%f", &Padding.x, &Padding.y);
+
+	std::string SelectorPaddingValue = Skin->GetString("Menu", "SelectorPadding");
+
+	sscanf(SelectorPaddingValue.c_str(), "%u", &SelectorPadding);
+
+	std::string TextOffsetValue = Skin->GetString("Menu", "TextOffset");
+
+	sscanf(TextOffsetValue.c_str(), "%f,%f", &TextOffset.x, &TextOffset.y);
+
+	std::string ItemHeightValue = Skin->GetString("Menu", "ItemHeight");
+
+	sscanf(ItemHeightValue.c_str(), "%u", &ItemHeight);
+
+	FontSize = Manager->GetDefaultFontSize();
+	FontColor = Manager->GetDefaultFontColor();
+
+	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
+};
+
+void UIMenu::CloseSelf(UIPanel *Self)
+{
+	Future::Instance.Post(Manager, &UIManager::RemoveMenuFuture);
+};
+
+void UIMenu::PerformLayout()
+{
+	SizeValue.y = (float)Items.size() * ItemHeight + Padding.y * 2.f;
+
+	for(unsigned long i = 0; i < Items.size(); i++)
+	{
+		float SizeW = MeasureTextSimple(Items[i].Caption, Manager->GetDefaultFont(), FontSize).ToFullSize().x;
+
+		if(SizeW > SizeValue.x)
+			SizeValue.x = SizeW;
+	};
+};
+
+void UIMenu::OnItemClick(UIPanel *Self)
+{
+	Vector2 ActualPosition = GetAbsolutePosition();
+
+	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+
+	AxisAlignedBoundingBox AABB;
+
+	for(unsigned long i = 0, ypos = 0; i < Items.size(); i++, ypos += ItemHeight)
+	{
+		AABB.min = ActualPosition + Vector2(Padding.x, Padding.y + (float)ypos);
+		AABB.max = AABB.min + Vector2(SizeValue.x, (float)ItemHeight);
+
+		if(AABB.IsInside(MousePosition))
+		{
+			OnItemSelected(&Items[i]);
+
+			break;
+		};
+	};
+
+	CloseSelf(NULL);
+};
+
+void UIMenu::Update(const Vector2 &ParentPosition)
+{
+};
+
+void UIMenu::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue - Vector2(Padding.x, 0);
+	Vector2 ActualSize = SizeValue + Vector2(4 + Padding.x, Padding.y);
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	Sprite TheSprite;
+	TheSprite.SpriteTexture = BackgroundTexture;
+	TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(ActualSize);
+
+	TheSprite.Draw(Renderer);
+
+	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+
+	AxisAlignedBoundingBox AABB;
+	bool DrewSelector = false;
+
+	for(unsigned long i = 0, ypos = 0; i < Items.size(); i++, ypos += ItemHeight)
+	{
+		AABB.min = ActualPosition + Vector2(Padding.x, Padding.y + (float)ypos);
+		AABB.max = AABB.min + Vector2(SizeValue.x, (float)ItemHeight);
+
+		if(!DrewSelector && AABB.IsInside(MousePosition))
+		{
+			DrewSelector = true;
+
+			TheSprite.SpriteTexture = SelectorBackgroundTexture;
+			TheSprite.Options.Position(AABB.min.ToVector2()).NinePatch(true, Rect()).Scale(Vector2(SizeValue.x, (float)ItemHeight + SelectorPadding));
+
+			TheSprite.Draw(Renderer);
+		};
+
+		Vector2 TextSize = MeasureTextSimple(Items[i].Caption, Manager->GetDefaultFont(), FontSize).ToFullSize();
+
+		RenderText(*Renderer, Items[i].Caption, Manager->GetDefaultFont(), FontSize, TextParams().Color(FontColor)
+			.Position(AABB.min.ToVector2() + Vector2(0, (ItemHeight - TextSize.y) / 2.f)));
+	};
+};
+
+void UIMenuBar::OnSkinChange()
+{
+	std::string TexturePath = Skin->GetString("Menu", "SelectorBackgroundTexture");
+
+	SelectorBackgroundTexture = Manager->GetSkinTexture(TexturePath);
+
+	std::string NinePatchRectValue = Skin->GetString("Menu", "TextureRect");
+
+	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
+		&TextureRect.Top, &TextureRect.Bottom);
+
+	std::string PaddingValue = Skin->GetString("Menu", "Padding");
+
+	sscanf(PaddingValue.c_str(), "%f,%f", &Padding.x, &Padding.y);
+
+	std::string SelectorPaddingValue = Skin->GetString("Menu", "SelectorPadding");
+
+	sscanf(SelectorPaddingValue.c_str(), "%u", &SelectorPadding);
+
+	std::string TextOffsetValue = Skin->GetString("Menu", "TextOffset");
+
+	sscanf(TextOffsetValue.c_str(), "%f,%f", &TextOffset.x, &TextOffset.y);
+
+	FontSize = Manager->GetDefaultFontSize();
+	FontColor = Manager->GetDefaultFontColor();
+
+	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
+};
+
+void UIMenuBar::OnItemSelected(UIMenu::Item *Item)
+{
+	OnMenuItemSelected(Item->Caption);
+};
+
+void UIMenuBar::OnItemClick(UIPanel *Self)
+{
+	Vector2 ActualPosition = GetAbsolutePosition();
+	Vector2 CurrentPosition;
+	AxisAlignedBoundingBox AABB;
+	bool DrewSelector = false;
+	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+
+	for(unsigned long i = 0; i < Items.size(); i++)
+	{
+		Vector2 TextSize = MeasureTextSimple(Items[i].Caption, Manager->GetDefaultFont(), FontSize).ToFullSize();
+
+		AABB.min = ActualPosition + CurrentPosition + Vector2(Padding.x, 0);
+		AABB.max = AABB.min + Vector2(TextSize.x, 22);
+
+		if(AABB.IsInside(MousePosition) && Items[i].SubItems.size())
+		{
+			UIMenu *Menu = Manager->CreateMenu(Vector2(AABB.min.x, AABB.max.y));
+
+			for(unsigned long j = 0; j < Items[i].SubItems.size(); j++)
+			{
+				Menu->AddItem(Items[i].SubItems[j]);
+			};
+
+			Menu->OnItemSelected.Connect(this, &UIMenuBar::OnItemSelected);
+		};
+
+		CurrentPosition.x += TextSize.x + 5;
+	};
+};
+
+void UIMenuBar::PerformLayout()
+{
+	SizeValue = Vector2((float)Manager->GetOwner()->getSize().x, 25);
+};
+
+void UIMenuBar::Update(const Vector2 &ParentPosition)
+{
+	//We span the whole window, so follow its size
+	if(SizeValue.x != (float)Manager->GetOwner()->getSize().x)
+		InvalidateLayout();
+};
+
+void UIMenuBar::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	SpriteBatch::Instance.AddRect(Vector2(), SizeValue, Vector4(0, 0, 0, 1));
+
+	Vector2 CurrentPosition;
+
+	AxisAlignedBoundingBox AABB;
+	bool DrewSelector = false;
+	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+
+	for(unsigned long i = 0; i < Items.size(); i++)
+	{
+		Vector2 TextSize = MeasureTextSimple(Items[i].Caption, Manager->GetDefaultFont(), FontSize).ToFullSize();
+
+		AABB.min = ActualPosition + CurrentPosition + Vector2(Padding.x, 0);
+		AABB.max = AABB.min + Vector2(TextSize.x, 22);
+
+		if(!DrewSelector && AABB.IsInside(MousePosition))
+		{
+			DrewSelector = true;
+
+			Sprite TheSprite;
+			TheSprite.SpriteTexture = SelectorBackgroundTexture;
+			TheSprite.Options.Position(AABB.min.ToVector2()).NinePatch(true, TextureRect).Scale(Vector2(TextSize.x, 22.f + SelectorPadding));
+
+			TheSprite.Draw(Renderer);
+		};
+
+		RenderText(*Renderer, Items[i].Caption, Manager->GetDefaultFont(), FontSize, TextParams().Color(FontColor)
+			.Position(AABB.min.ToVector2() + Vector2(0, (22 - 12) / 2.f)));
+
+		CurrentPosition.x += TextSize.x + 5;
+	};
+};
+
+void UIMessageBox::OnMainButtonClicked(UIPanel *Self)
+{
+	OnButtonPressed(this, 0);
+
+	Future::Instance.Post(Manager, &UIManager::RemoveElement, ID);
+};
+
+void UIMessageBox::OnSecondaryButtonClicked(UIPanel *Self)
+{
+	OnButtonPressed(this, 1);
+
+	Future::Instance.Post(Manager, &UIManager::RemoveElement, ID);
+};
+
+void UIMessageBox::InitMessageBox()
+{
+	SetSkin(Manager->GetSkin());
+
+	TheWindow.Reset(new UIWindow(Manager));
+	TheText.Reset(new UIText(Manager));
+
+	SuperSmartPointer<UIButton> TheMainButton(new UIButton(Manager));
+	SuperSmartPointer<UIButton> TheSecondaryButton;
+
+	TheWindow->Title = Title;
+	TheWindow->SetSkin(Skin);
+
+	TheMainButton->SetSkin(Skin);
+	TheMainButton->SetSize(Vector2(100, 0));
+	TheMainButton->Caption = ButtonTitle.getSize() ? ButtonTitle : "OK";
+	TheMainButton->PerformLayout();
+	TheMainButton->OnClick.Connect(this, &UIMessageBox::OnMainButtonClicked);
+
+	if(SecondaryButtonTitle.getSize())
+	{
+		TheSecondaryButton.Reset(new UIButton(Manager));
+		TheSecondaryButton->SetSkin(Skin);
+		TheSecondaryButton->SetSize(Vector2(100, 0));
+		TheSecondaryButton->Caption = SecondaryButtonTitle.getSize() ? SecondaryButtonTitle : "Cancel";
+		TheSecondaryButton->PerformLayout();
+		TheSecondaryButton->OnClick.Connect(this, &UIMessageBox::OnSecondaryButtonClicked);
+	};
+
+	Vector2 MaxSize = Vector2(Manager->GetOwner()->getSize().x * 0.95f, Manager->GetOwner()->getSize().y * 0.45f);
+
+	TheText->SetSkin(Skin);
+	TheText->SetSize(MaxSize);
+	TheText->SetText(Message);
+
+	MaxSize = TheText->GetTextSize();
+
+	TheText->SetSize(MaxSize);
+	TheWindow->SetSize(MaxSize + Vector2(0, (float)TheWindow->GetTitleHeight() + TheWindow->GetTitleOffset()));
+	TheText->SetPosition(Vector2(0, (float)TheWindow->GetTitleHeight() + TheWindow->GetTitleOffset()));
+
+	TheMainButton->SetPosition(TheText->GetPosition() + Vector2(TheSecondaryButton.Get() ? (TheWindow->GetSize().x / 2 - TheMainButton->GetSize().x * 2) :
+		(TheWindow->GetSize().x - TheMainButton->GetSize().x) / 2.f, TheText->GetSize().y + 10));
+
+	AddChildren(TheWindow);
+	AddChildren(TheText);
+	AddChildren(TheMainButton);
+
+	std::string Base = std::string("__MESSAGEBOX__") + StringUtils::MakeIntString((long)this, true);
+
+	Manager->AddElement(MakeStringID(Base + "_WINDOW__"), TheWindow);
+	Manager->AddElement(MakeStringID(Base + "_TEXT__"), TheText);
+	Manager->AddElement(MakeStringID(Base + "_MAINBUTTON__"), TheMainButton);
+
+	if(TheSecondaryButton.Get())
+	{
+		TheSecondaryButton->SetPosition(TheText->GetPosition() + Vector2((TheWindow->GetSize().x / 2 + TheSecondaryButton->GetSize().x), TheText->GetSize().y + 10));
+
+		AddChildren(TheSecondaryButton);
+
+		Manager->AddElement(MakeStringID(Base + "_SECONDARYBUTTON__"), TheSecondaryButton);
+	};
+
+	SetPosition(Vector2(((float)Manager->GetOwner()->getSize().x - MaxSize.x) / 2.f,
+		((float)Manager->GetOwner()->getSize().y - MaxSize.y) / 2.f));
+};
+
+void UIMessageBox::PerformLayout()
+{
+	SizeValue = GetChildrenSize();
+};
+
+void UIMessageBox::Update(const Vector2 &ParentPosition)
+{
+	Children[0]->SetSize(SizeValue);
+
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->Update(ParentPosition + PositionValue);
+	};
+
+	SetPosition(PositionValue + Children[0]->GetPosition());
+	Children[0]->SetPosition(Vector2());
+};
+
+void UIMessageBox::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+{
+	Vector2 ActualPosition = ParentPosition + PositionValue;
+
+	if(!IsVisible() || AlphaValue == 0 || IsCulled(ActualPosition, Renderer))
+		return;
+
+	if(TheWindow->IsClosed())
+	{
+		Future::Instance.Post(Manager, &UIManager::RemoveElement, ID);
+	};
+
+	for(unsigned long i = 0; i < Children.size(); i++)
+	{
+		Children[i]->DrawLayered(ParentPosition + PositionValue, Renderer);
+	};
+};
+
+void UIDraggable::OnMouseJustPressedDraggable(UIPanel *This, const InputCenter::MouseButtonInfo &o)
+{
+	if(o.Name != sf::Mouse::Left)
+		return;
+
+	Dragging = true;
+
+	OnDragBegin(this);
+};
+
+void UIDraggable::OnMouseReleasedDraggable(UIPanel *This, const InputCenter::MouseButtonInfo &o)
+{
+	if(o.Name != sf::Mouse::Left)
+		return;
+
+	if(Dragging)
+	{
+		OnDragEnd(this);
+
+		Dragging = false;
+
+		SuperSmartPointer<UIDroppable> Drop = GetManager()->GetMouseOverElement();
+
+		if(!Drop.Get())
+			return;
+
+		Drop->OnDrop(this);
+	};
+};
+
+SuperSmartPointer<UIPanel> UIManager::GetMouseOverElement()
+{
+	RefreshMouseOver();
+
+	return MouseOverElementValue;
+};
+
+UIPanel *UIManager::FindMouseOverElement()
+{
+	RefreshDrawOrderCache();
+
+	UIPanel *FoundElement = NULL;
+
+	SuperSmartPointer<UIPanel> InputBlocker = FindInputBlocker();
+
+	if(InputBlocker.Get())
+	{
+		UIPanel *p = InputBlocker;
+		RecursiveFindFocusedElement(p, FoundElement);
+	}
+	else
+	{
+		FoundElement = HitTest(GetInput()->MousePosition);
+	};
+
+	return FoundElement;
+};
+
+SuperSmartPointer<UIPanel> UIManager::FindInputBlocker()
+{
+	for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
+	{
+		while(it != Elements.end() && it->second.Get() == NULL)
+		{
+			Elements.erase(it);
+			it = Elements.begin();
+		};
+
+		if(it == Elements.end())
+			break;
+
+		if(it->second->Panel->BlockingInput && it->second->Panel->IsVisible())
+		{
+			return it->second->Panel;
+		};
+	};
+
+	return SuperSmartPointer<UIPanel>();
+};
+
+void UIManager::RefreshMouseOver()
+{
+	RefreshHitTestIndex();
+
+	const Vector2 &MousePosition = GetInput()->MousePosition;
+
+	if(!MouseOverDirty && MousePosition == MouseOverPosition)
+		return;
+
+	MouseOverDirty = false;
+	MouseOverPosition = MousePosition;
+
+	UIPanel *FoundElement = FindMouseOverElement();
+
+	//Elements may highlight whatever part of them is under the mouse
+	if(MouseOverElementValue)
+		MouseOverElementValue->Damage();
+
+	if(FoundElement == MouseOverElementValue.Get() && (FoundElement != NULL || MouseOverChain.size() == 0))
+		return;
+
+	std::vector<SuperSmartPointer<UIPanel> > Chain;
+
+	if(FoundElement && Elements[FoundElement->ID].Get())
+	{
+		for(UIPanel *p = FoundElement; p != NULL; p = p->GetParent())
+		{
+			Chain.push_back(GetElement(p->ID));
+		};
+	};
+
+	//Swap first so handlers see the new state if they call GetMouseOverElement
+	std::vector<SuperSmartPointer<UIPanel> > PreviousChain = MouseOverChain;
+	MouseOverChain = Chain;
+	MouseOverElementValue = Chain.size() ? Chain[0] : SuperSmartPointer<UIPanel>();
+
+	//Chains are only as long as the hierarchy is deep, so a linear search is fine
+	for(unsigned long i = 0; i < PreviousChain.size(); i++)
+	{
+		if(PreviousChain[i].Get() == NULL)
+			continue;
+
+		bool StillOver = false;
+
+		for(unsigned long j = 0; j < Chain.size() && !StillOver; j++)
+		{
+			StillOver = Chain[j].Get() == PreviousChain[i].Get();
+		};
+
+		if(!StillOver)
+			PreviousChain[i]->OnMouseLeavePriv();
+	};
+
+	for(unsigned long i = Chain.size(); i > 0; i--)
+	{
+		if(Chain[i - 1].Get() == NULL)
+			continue;
+
+		bool WasOver = false;
+
+		for(unsigned long j = 0; j < PreviousChain.size() && !WasOver; j++)
+		{
+			WasOver = PreviousChain[j].Get() == Chain[i - 1].Get();
+		};
+
+		if(!WasOver)
+			Chain[i - 1]->OnMouseEnterPriv();
+	};
+};
+
+void UIManager::Update()
+{
+	Textures.Collect();
+	Textures.Upload(TEXTURECACHE_UPLOAD_BUDGET);
+
+	UpdateAnimations();
+
+	LayoutCount = 0;
+
+	RefreshDrawOrderCache();
+
+	for(unsigned long i = 0; i < DrawOrderCache.size(); i++)
+	{
+		if(DrawOrderCache[i]->Panel.Get() == NULL)
+			continue;
+
+		if(DrawOrderCache[i]->Panel->IsVisible())
+		{
+			DrawOrderCache[i]->Panel->UpdateLayout();
+			DrawOrderCache[i]->Panel->Update(Vector2());
+			//After Update, since that's where most elements move, and before anything is drawn where they moved to
+			DrawOrderCache[i]->Panel->UpdateTransform();
+		};
+	};
 
-void UICheckBox::Update(const Vector2 &ParentPosition)
-{
-	PerformLayout();
+	//Layout changes can move elements under a still mouse
+	RefreshMouseOver();
 };
 
-void UICheckBox::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+unsigned long UIManager::GetTimeUntilUpdate()
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+	if(!DamageTrackingValue || HasDamage || HasPreviousDamage || RedrawPending || HitTestIndexDirty || HitTestMovedElements.size() ||
+		Textures.HasPendingUploads())
+		return 0;
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x || ActualPosition.y + SizeValue.y < 0 ||
-		ActualPosition.y > Renderer->getSize().y))
-		return;
+	unsigned long Out = FocusedElementValue ? FocusedElementValue->GetTimeUntilUpdate() : InputCenter::WaitForever;
+	unsigned long AnimationTime = GetTimeUntilNextAnimation();
 
-	Sprite TheSprite;
-	TheSprite.SpriteTexture = Checked ? CheckTexture : UnCheckTexture;
-	TheSprite.Options = SpriteDrawOptions().Position(ActualPosition);
-	TheSprite.Draw(Renderer);
+	return AnimationTime < Out ? AnimationTime : Out;
+};
 
-	RenderText(*Renderer, Caption, Manager->GetDefaultFont(), FontSize, TextParams().Color(FontColor).Position(ActualPosition +
-		Vector2((float)TheSprite.SpriteTexture->getSize().x, 0) + LabelOffset));
+unsigned long long UIManager::GetAnimationTime() const
+{
+	//sf::Clock is monotonic
+	return AnimationClock.getElapsedTime().asMicroseconds() / 1000;
 };
 
-void UIMenu::OnSkinChange()
+void UIManager::UpdateAnimations()
 {
-	std::string TexturePath = Skin->GetString("Menu", "BackgroundTexture");
+	unsigned long long Now = GetAnimationTime();
+	unsigned long Count = 0;
 
-	BackgroundTexture = LoadTexture(TexturePath);
+	FinishedAnimations.clear();
 
-	TexturePath = Skin->GetString("Menu", "SelectorBackgroundTexture");
+	for(unsigned long i = 0; i < Animations.size(); i++)
+	{
+		UIAnimation &Animation = Animations[i];
+		bool Finished = false;
 
-	SelectorBackgroundTexture = LoadTexture(TexturePath);
+		if(Animation.Property == AnimationProperty::SpriteFrame)
+		{
+			if(Animation.Sprite->Update(Now))
+				Animation.Panel->Damage();
 
-	std::string NinePatchRectValue = Skin->GetString("Menu", "TextureRect");
+			Finished = Animation.Sprite->IsFinished();
+		}
+		else if(Now >= Animation.StartTime)
+		{
+			if(!Animation.Started)
+			{
+				Animation.Started = true;
 
-	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
-		&TextureRect.Top, &TextureRect.Bottom);
+				switch(Animation.Property)
+				{
+				case AnimationProperty::Position:
+					Animation.From = Animation.Panel->GetPosition();
 
-	std::string PaddingValue = Skin->GetString("Menu", "Padding");
+					break;
+				case AnimationProperty::Size:
+					Animation.From = Animation.Panel->GetSize();
 
-	sscanf(PaddingValue.c_str(), "%f,%f", &Padding.x, &Padding.y);
+					break;
+				case AnimationProperty::Alpha:
+					Animation.From = Vector2(Animation.Panel->GetAlpha(), 0);
 
-	std::string SelectorPaddingValue = Skin->GetString("Menu", "SelectorPadding");
+					break;
+				};
+			};
 
-	sscanf(SelectorPaddingValue.c_str(), "%u", &SelectorPadding);
+			float t = Animation.Duration ? (Now - Animation.StartTime) / (float)Animation.Duration : 1;
+			Vector2 Value = Vector2::LinearInterpolate(Animation.From, Animation.To, MathUtils::Ease(Animation.Curve, t));
 
-	std::string TextOffsetValue = Skin->GetString("Menu", "TextOffset");
+			//The setters only mark the element dirty if the value changed
+			switch(Animation.Property)
+			{
+			case AnimationProperty::Position:
+				Animation.Panel->SetPosition(Value);
 
-	sscanf(TextOffsetValue.c_str(), "%f,%f", &TextOffset.x, &TextOffset.y);
+				break;
+			case AnimationProperty::Size:
+				Animation.Panel->SetSize(Value);
 
-	std::string ItemHeightValue = Skin->GetString("Menu", "ItemHeight");
+				break;
+			case AnimationProperty::Alpha:
+				Animation.Panel->SetAlpha(Value.x);
 
-	sscanf(ItemHeightValue.c_str(), "%u", &ItemHeight);
+				break;
+			};
 
-	FontSize = Manager->GetDefaultFontSize();
-	FontColor = Manager->GetDefaultFontColor();
+			Finished = t >= 1;
+		};
 
-	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
-};
+		if(Finished)
+		{
+			FinishedAnimations.push_back(Animation);
+		}
+		else
+		{
+			if(Count != i)
+				Animations[Count] = Animation;
 
-void UIMenu::CloseSelf(UIPanel *Self)
-{
-	Future::Instance.Post(Manager, &UIManager::RemoveMenuFuture);
+			Count++;
+		};
+	};
+
+	Animations.resize(Count);
+
+	//Handlers may start or stop animations, or destroy elements (which clears their Panel below)
+	for(unsigned long i = 0; i < FinishedAnimations.size(); i++)
+	{
+		if(FinishedAnimations[i].Panel)
+			FinishedAnimations[i].Panel->OnAnimationFinished(FinishedAnimations[i].Panel, FinishedAnimations[i].Handle);
+	};
+
+	FinishedAnimations.clear();
 };
 
-void UIMenu::PerformLayout()
+unsigned long UIManager::GetTimeUntilNextAnimation() const
 {
-	SizeValue.y = (float)Items.size() * ItemHeight + Padding.y * 2.f;
+	unsigned long long Now = GetAnimationTime(), Out = InputCenter::WaitForever;
 
-	for(unsigned long i = 0; i < Items.size(); i++)
+	for(unsigned long i = 0; i < Animations.size(); i++)
 	{
-		float SizeW = MeasureTextSimple(Items[i].Caption, Manager->GetDefaultFont(), FontSize).ToFullSize().x;
+		const UIAnimation &Animation = Animations[i];
+		unsigned long long Time;
 
-		if(SizeW > SizeValue.x)
-			SizeValue.x = SizeW;
+		if(Animation.Property == AnimationProperty::SpriteFrame)
+		{
+			Time = Animation.Sprite->GetTimeUntilNextFrame(Now);
+		}
+		else
+		{
+			Time = Animation.StartTime > Now ? Animation.StartTime - Now : UIANIMATION_FRAME_TIME;
+		};
+
+		if(Time < Out)
+			Out = Time;
 	};
+
+	return (unsigned long)Out;
 };
 
-void UIMenu::OnItemClick(UIPanel *Self)
+AnimationHandle UIManager::Animate(UIPanel *Panel, unsigned long Property, const Vector2 &To, unsigned long Duration,
+	unsigned long Curve, unsigned long Delay)
 {
-	Vector2 ActualPosition = PositionValue + GetParentPosition();
-
-	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+	if(Panel == NULL || Property == AnimationProperty::SpriteFrame)
+		return 0;
 
-	AxisAlignedBoundingBox AABB;
-
-	for(unsigned long i = 0, ypos = 0; i < Items.size(); i++, ypos += ItemHeight)
+	for(unsigned long i = 0; i < Animations.size(); i++)
 	{
-		AABB.min = ActualPosition + Vector2(Padding.x, Padding.y + (float)ypos);
-		AABB.max = AABB.min + Vector2(SizeValue.x, (float)ItemHeight);
-
-		if(AABB.IsInside(MousePosition))
+		if(Animations[i].Panel == Panel && Animations[i].Property == Property)
 		{
-			OnItemSelected(&Items[i]);
+			//Order doesn't matter, so don't move everything after it
+			Animations[i] = Animations.back();
+			Animations.pop_back();
 
 			break;
 		};
 	};
 
-	CloseSelf(NULL);
-};
+	UIAnimation Animation;
+	Animation.Handle = NextAnimationHandle++;
+	Animation.Property = Property;
+	Animation.Panel = Panel;
+	Animation.To = To;
+	Animation.StartTime = GetAnimationTime() + Delay;
+	Animation.Duration = Duration;
+	Animation.Curve = Curve;
 
-void UIMenu::Update(const Vector2 &ParentPosition)
-{
-	PerformLayout();
+	Animations.push_back(Animation);
+
+	return Animation.Handle;
 };
 
-void UIMenu::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+AnimationHandle UIManager::AnimateSprite(UIPanel *Panel, AnimatedSprite *Sprite)
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue - Vector2(Padding.x, 0);
-	Vector2 ActualSize = SizeValue + Vector2(4 + Padding.x, Padding.y);
-
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x || ActualPosition.y + SizeValue.y < 0 ||
-		ActualPosition.y > Renderer->getSize().y))
-		return;
-
-	Sprite TheSprite;
-	TheSprite.SpriteTexture = BackgroundTexture;
-	TheSprite.Options.Position(ActualPosition).NinePatch(true, TextureRect).Scale(ActualSize);
+	if(Panel == NULL || Sprite == NULL)
+		return 0;
 
-	TheSprite.Draw(Renderer);
+	UIAnimation Animation;
+	Animation.Handle = NextAnimationHandle++;
+	Animation.Property = AnimationProperty::SpriteFrame;
+	Animation.Panel = Panel;
+	Animation.Sprite = Sprite;
+	Animation.StartTime = GetAnimationTime();
 
-	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+	Animations.push_back(Animation);
 
-	AxisAlignedBoundingBox AABB;
-	bool DrewSelector = false;
+	return Animation.Handle;
+};
 
-	for(unsigned long i = 0, ypos = 0; i < Items.size(); i++, ypos += ItemHeight)
+bool UIManager::StopAnimation(AnimationHandle Handle)
+{
+	for(unsigned long i = 0; i < Animations.size(); i++)
 	{
-		AABB.min = ActualPosition + Vector2(Padding.x, Padding.y + (float)ypos);
-		AABB.max = AABB.min + Vector2(SizeValue.x, (float)ItemHeight);
-
-		if(!DrewSelector && AABB.IsInside(MousePosition))
+		if(Animations[i].Handle == Handle)
 		{
-			DrewSelector = true;
-
-			TheSprite.SpriteTexture = SelectorBackgroundTexture;
-			TheSprite.Options.Position(AABB.min.ToVector2()).NinePatch(true, Rect()).Scale(Vector2(SizeValue.x, (float)ItemHeight + SelectorPadding));
+			Animations[i] = Animations.back();
+			Animations.pop_back();
 
-			TheSprite.Draw(Renderer);
+			return true;
 		};
-
-		Vector2 TextSize = MeasureTextSimple(Items[i].Caption, Manager->GetDefaultFont(), FontSize).ToFullSize();
-
-		RenderText(*Renderer, Items[i].Caption, Manager->GetDefaultFont(), FontSize, TextParams().Color(FontColor)
-			.Position(AABB.min.ToVector2() + Vector2(0, (ItemHeight - TextSize.y) / 2.f)));
 	};
+
+	return false;
 };
 
-void UIMenuBar::OnSkinChange()
+void UIManager::StopAnimations(UIPanel *Panel)
 {
-	std::string TexturePath = Skin->GetString("Menu", "SelectorBackgroundTexture");
+	unsigned long Count = 0;
 
-	SelectorBackgroundTexture = LoadTexture(TexturePath);
+	for(unsigned long i = 0; i < Animations.size(); i++)
+	{
+		if(Animations[i].Panel == Panel)
+			continue;
 
-	std::string NinePatchRectValue = Skin->GetString("Menu", "TextureRect");
+		if(Count != i)
+			Animations[Count] = Animations[i];
 
-	sscanf(NinePatchRectValue.c_str(), "%f,%f,%f,%f", &TextureRect.Left, &TextureRect.Right,
-		&TextureRect.Top, &TextureRect.Bottom);
+		Count++;
+	};
 
-	std::string PaddingValue = Skin->GetString("Menu", "Padding");
+	Animations.resize(Count);
 
-	sscanf(PaddingValue.c_str(), "%f,%f", &Padding.x, &Padding.y);
+	for(unsigned long i = 0; i < FinishedAnimations.size(); i++)
+	{
+		if(FinishedAnimations[i].Panel == Panel)
+			FinishedAnimations[i].Panel = NULL;
+	};
+};
 
-	std::string SelectorPaddingValue = Skin->GetString("Menu", "SelectorPadding");
+void UIManager::SetDamageTracking(bool Value)
+{
+	DamageTrackingValue = Value;
+	RedrawPending = HasPreviousDamage = false;
 
-	sscanf(SelectorPaddingValue.c_str(), "%u", &SelectorPadding);
+	DamageAll();
+};
 
-	std::string TextOffsetValue = Skin->GetString("Menu", "TextOffset");
+void UIManager::AddDamage(const Rect &Area)
+{
+	if(!DamageTrackingValue || Area.Left >= Area.Right || Area.Top >= Area.Bottom)
+		return;
 
-	sscanf(TextOffsetValue.c_str(), "%f,%f", &TextOffset.x, &TextOffset.y);
+	if(!HasDamage)
+	{
+		DamageRect = Area;
+		HasDamage = true;
 
-	FontSize = Manager->GetDefaultFontSize();
-	FontColor = Manager->GetDefaultFontColor();
+		return;
+	};
 
-	SelectBoxExtraSize = Vector2(TextureRect.Left + TextureRect.Right, TextureRect.Top + TextureRect.Bottom);
+	DamageRect.Left = DamageRect.Left < Area.Left ? DamageRect.Left : Area.Left;
+	DamageRect.Right = DamageRect.Right > Area.Right ? DamageRect.Right : Area.Right;
+	DamageRect.Top = DamageRect.Top < Area.Top ? DamageRect.Top : Area.Top;
+	DamageRect.Bottom = DamageRect.Bottom > Area.Bottom ? DamageRect.Bottom : Area.Bottom;
 };
 
-void UIMenuBar::OnItemSelected(UIMenu::Item *Item)
+void UIManager::DamageAll()
 {
-	OnMenuItemSelected(Item->Caption);
+	AddDamage(Rect(0, (float)Owner->getSize().x, 0, (float)Owner->getSize().y));
 };
 
-void UIMenuBar::OnItemClick(UIPanel *Self)
+bool UIManager::GetRedrawArea(Rect &Out)
 {
-	Vector2 ActualPosition = PositionValue + GetParentPosition();
-	Vector2 CurrentPosition;
-	AxisAlignedBoundingBox AABB;
-	bool DrewSelector = false;
-	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+	Vector2 OwnerSize((float)Owner->getSize().x, (float)Owner->getSize().y);
 
-	for(unsigned long i = 0; i < Items.size(); i++)
+	if(!DamageTrackingValue)
 	{
-		Vector2 TextSize = MeasureTextSimple(Items[i].Caption, Manager->GetDefaultFont(), FontSize).ToFullSize();
+		Out = Rect(0, OwnerSize.x, 0, OwnerSize.y);
 
-		AABB.min = ActualPosition + CurrentPosition + Vector2(Padding.x, 0);
-		AABB.max = AABB.min + Vector2(TextSize.x, 22);
+		return true;
+	};
 
-		if(AABB.IsInside(MousePosition) && Items[i].SubItems.size())
-		{
-			UIMenu *Menu = Manager->CreateMenu(Vector2(AABB.min.x, AABB.max.y));
+	//Things drawn outside of any element's area
+	if(OwnerSize != DamageOwnerSize)
+	{
+		DamageOwnerSize = OwnerSize;
 
-			for(unsigned long j = 0; j < Items[i].SubItems.size(); j++)
-			{
-				Menu->AddItem(Items[i].SubItems[j]);
-			};
+		DamageAll();
+	};
 
-			Menu->OnItemSelected.Connect(this, &UIMenuBar::OnItemSelected);
-		};
+	UIPanel *InputBlocker = FindInputBlocker().Get();
 
-		CurrentPosition.x += TextSize.x + 5;
+	if(InputBlocker != DamageInputBlocker)
+	{
+		DamageInputBlocker = InputBlocker;
+
+		//The Input Blocker's shade covers everything
+		DamageAll();
 	};
-};
 
-void UIMenuBar::PerformLayout()
-{
-	SizeValue = Vector2((float)Manager->GetOwner()->getSize().x, 25);
-};
+	Rect TooltipArea;
+	bool TooltipShown = Tooltip->GetTooltipArea(GetInput()->MousePosition, Owner, TooltipArea);
+	sf::String TooltipText = Tooltip->Source ? Tooltip->Source->GetTooltipText() : Tooltip->OverrideText;
 
-void UIMenuBar::Update(const Vector2 &ParentPosition)
-{
-	PerformLayout();
-};
+	if(TooltipShown != DamageTooltipShown || (TooltipShown && (TooltipText != DamageTooltipText ||
+		TooltipArea.Left != DamageTooltipArea.Left || TooltipArea.Right != DamageTooltipArea.Right ||
+		TooltipArea.Top != DamageTooltipArea.Top || TooltipArea.Bottom != DamageTooltipArea.Bottom)))
+	{
+		if(DamageTooltipShown)
+			AddDamage(DamageTooltipArea);
 
-void UIMenuBar::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
-{
-	Vector2 ActualPosition = ParentPosition + PositionValue;
+		if(TooltipShown)
+			AddDamage(TooltipArea);
 
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x || ActualPosition.y + SizeValue.y < 0 ||
-		ActualPosition.y > Renderer->getSize().y))
-		return;
+		DamageTooltipShown = TooltipShown;
+		DamageTooltipArea = TooltipArea;
+		DamageTooltipText = TooltipText;
+	};
 
-	glBindTexture(GL_TEXTURE_2D, NULL);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisableClientState(GL_NORMAL_ARRAY);
-	glEnableClientState(GL_VERTEX_ARRAY);
+	Rect Area;
 
-	Vector2 Vertices[6] = {
-		Vector2(),
-		Vector2(0, SizeValue.y),
-		SizeValue,
-		SizeValue,
-		Vector2(SizeValue.x, 0),
-		Vector2()
-	};
+	if(HasDamage && HasPreviousDamage)
+	{
+		Area.Left = DamageRect.Left < PreviousDamageRect.Left ? DamageRect.Left : PreviousDamageRect.Left;
+		Area.Right = DamageRect.Right > PreviousDamageRect.Right ? DamageRect.Right : PreviousDamageRect.Right;
+		Area.Top = DamageRect.Top < PreviousDamageRect.Top ? DamageRect.Top : PreviousDamageRect.Top;
+		Area.Bottom = DamageRect.Bottom > PreviousDamageRect.Bottom ? DamageRect.Bottom : PreviousDamageRect.Bottom;
+	}
+	else if(HasDamage || HasPreviousDamage)
+	{
+		Area = HasDamage ? DamageRect : PreviousDamageRect;
+	}
+	else
+	{
+		DamageCounters.SkippedFrames++;
 
-	glColor4f(0, 0, 0, 1);
+		return false;
+	};
 
-	glVertexPointer(2, GL_FLOAT, 0, Vertices);
+	//Whole pixels inside the Owner
+	Area.Left = floorf(Area.Left < 0 ? 0 : Area.Left);
+	Area.Top = floorf(Area.Top < 0 ? 0 : Area.Top);
+	Area.Right = ceilf(Area.Right > OwnerSize.x ? OwnerSize.x : Area.Right);
+	Area.Bottom = ceilf(Area.Bottom > OwnerSize.y ? OwnerSize.y : Area.Bottom);
 
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	if(Area.Left >= Area.Right || Area.Top >= Area.Bottom)
+	{
+		HasDamage = HasPreviousDamage = false;
+		DamageCounters.SkippedFrames++;
 
-	glColor4f(1, 1, 1, 1);
+		return false;
+	};
 
-	Vector2 CurrentPosition;
+	RedrawRect = Out = Area;
+	RedrawPending = true;
 
-	AxisAlignedBoundingBox AABB;
-	bool DrewSelector = false;
-	const Vector2 &MousePosition = Manager->GetInput()->MousePosition;
+	return true;
+};
 
-	for(unsigned long i = 0; i < Items.size(); i++)
+void UIManager::Draw(sf::RenderWindow *Renderer)
+{
+	if(DamageTrackingValue)
 	{
-		Vector2 TextSize = MeasureTextSimple(Items[i].Caption, Manager->GetDefaultFont(), FontSize).ToFullSize();
+		Rect Area;
 
-		AABB.min = ActualPosition + CurrentPosition + Vector2(Padding.x, 0);
-		AABB.max = AABB.min + Vector2(TextSize.x, 22);
+		if(!RedrawPending && !GetRedrawArea(Area))
+			return;
 
-		if(!DrewSelector && AABB.IsInside(MousePosition))
+		RedrawPending = false;
+
+		DamageCounters.DrawnFrames++;
+		DamageCounters.RedrawnPixels += (unsigned long long)((RedrawRect.Right - RedrawRect.Left) * (RedrawRect.Bottom - RedrawRect.Top));
+
+		//Anything damaged while drawing belongs to the next frame
+		PreviousDamageRect = DamageRect;
+		HasPreviousDamage = HasDamage;
+		HasDamage = false;
+	};
+
+	SpriteBatch::Instance.BeginFrame();
+	TextEngine::Instance.BeginFrame();
+
+	RefreshDrawOrderCache();
+
+	SuperSmartPointer<UIPanel> InputBlocker = FindInputBlocker();
+
+	for(unsigned long i = 0; i < DrawOrderCache.size(); i++)
+	{
+		if(DrawOrderCache[i]->Panel.Get() == NULL || !DrawOrderCache[i]->Panel->IsVisible())
+			continue;
+
+		if(DrawOrderCache[i]->Panel == InputBlocker)
 		{
-			DrewSelector = true;
+			SpriteBatch::Instance.AddRect(Vector2(), Vector2((float)Renderer->getSize().x, (float)Renderer->getSize().y),
+				Vector4(0, 0, 0, 0.3f));
+		};
 
-			Sprite TheSprite;
-			TheSprite.SpriteTexture = SelectorBackgroundTexture;
-			TheSprite.Options.Position(AABB.min.ToVector2()).NinePatch(true, TextureRect).Scale(Vector2(TextSize.x, 22.f + SelectorPadding));
+		UIPanel *Panel = DrawOrderCache[i]->Panel;
 
-			TheSprite.Draw(Renderer);
+		if(!Panel->DrawCommandsDirty && Panel->DrawCommandsGlyphGeneration == TextEngine::Instance.GetGlyphGeneration())
+		{
+			Panel->DrawCommands.Replay();
+
+			continue;
 		};
 
-		RenderText(*Renderer, Items[i].Caption, Manager->GetDefaultFont(), FontSize, TextParams().Color(FontColor)
-			.Position(AABB.min.ToVector2() + Vector2(0, (22 - 12) / 2.f)));
+		//Anything invalidated while drawing is picked up next frame
+		Panel->DrawCommandsDirty = false;
+		Panel->DrawCommandsGlyphGeneration = TextEngine::Instance.GetGlyphGeneration();
+		Panel->DrawCommands.Clear();
 
-		CurrentPosition.x += TextSize.x + 5;
+		SpriteBatch::Instance.SetRecorder(&Panel->DrawCommands);
+		Panel->DrawLayered(Vector2(), Renderer);
+		SpriteBatch::Instance.SetRecorder(NULL);
 	};
+
+	Tooltip->Update(Vector2());
+	Tooltip->Draw(GetInput()->MousePosition, Renderer);
+
+	SpriteBatch::Instance.Flush();
 };
 
-void UIMessageBox::OnMainButtonClicked(UIPanel *Self)
+std::string UIManager::DumpDrawCommands()
 {
-	OnButtonPressed(this, 0);
+	RefreshDrawOrderCache();
+
+	std::stringstream Out;
 
-	unsigned long ManagerID = (unsigned long)Manager;
+	for(unsigned long i = 0; i < DrawOrderCache.size(); i++)
+	{
+		UIPanel *Panel = DrawOrderCache[i]->Panel;
+
+		if(Panel == NULL || !Panel->IsVisible())
+			continue;
 
-	std::vector<unsigned char> Stream(sizeof(StringID) + sizeof(unsigned long));
-	memcpy(&Stream[0], &ID, sizeof(StringID));
-	memcpy(&Stream[sizeof(StringID)], &ManagerID, sizeof(unsigned long));
+		Out << "Element 0x" << std::hex << Panel->GetID() << std::dec << " (Draw Order " << DrawOrderCache[i]->DrawOrder << ", " <<
+			(Panel->DrawCommandsDirty ? "dirty" : "retained") << ")\n" << Panel->DrawCommands.Dump();
+	};
 
-	Future::Instance.Post(RemoveElementFuture, Stream);
+	return Out.str();
 };
 
-void UIMessageBox::OnSecondaryButtonClicked(UIPanel *Self)
+void UIManager::RefreshDrawOrderCache()
 {
-	OnButtonPressed(this, 1);
-
-	unsigned long ManagerID = (unsigned long)Manager;
+	if(!DrawOrderCacheDirty)
+		return;
 
-	std::vector<unsigned char> Stream(sizeof(StringID) + sizeof(unsigned long));
-	memcpy(&Stream[0], &ID, sizeof(StringID));
-	memcpy(&Stream[sizeof(StringID)], &ManagerID, sizeof(unsigned long));
+	DrawOrderCacheDirty = false;
+	DrawOrderCache.clear();
 
-	Future::Instance.Post(RemoveElementFuture, Stream);
+	for(ZOrderMap::iterator it = ZOrder.begin(); it != ZOrder.end(); it++)
+	{
+		if(it->second->Panel.Get() && it->second->Panel->GetParent() == NULL)
+		{
+			DrawOrderCache.push_back(it->second);
+		};
+	};
 };
 
-void UIMessageBox::InitMessageBox()
+void UIManager::CompactDrawOrder()
 {
-	SetSkin(Manager->GetSkin());
-
-	TheWindow.Reset(new UIWindow(Manager));
-	TheText.Reset(new UIText(Manager));
-
-	SuperSmartPointer<UIButton> TheMainButton(new UIButton(Manager));
-	SuperSmartPointer<UIButton> TheSecondaryButton;
-
-	TheWindow->Title = Title;
-	TheWindow->SetSkin(Skin);
+	//Keeps the counter bounded by the amount of live elements rather than by every element ever created
+	if(DrawOrderCounter < ZOrder.size() * 2 + 1024)
+		return;
 
-	TheMainButton->SetSkin(Skin);
-	TheMainButton->SetSize(Vector2(100, 0));
-	TheMainButton->Caption = ButtonTitle.getSize() ? ButtonTitle : "OK";
-	TheMainButton->PerformLayout();
-	TheMainButton->OnClick.Connect(this, &UIMessageBox::OnMainButtonClicked);
+	ZOrderMap Compacted;
+	DrawOrderCounter = 0;
 
-	if(SecondaryButtonTitle.getSize())
+	for(ZOrderMap::iterator it = ZOrder.begin(); it != ZOrder.end(); it++)
 	{
-		TheSecondaryButton.Reset(new UIButton(Manager));
-		TheSecondaryButton->SetSkin(Skin);
-		TheSecondaryButton->SetSize(Vector2(100, 0));
-		TheSecondaryButton->Caption = SecondaryButtonTitle.getSize() ? SecondaryButtonTitle : "Cancel";
-		TheSecondaryButton->PerformLayout();
-		TheSecondaryButton->OnClick.Connect(this, &UIMessageBox::OnSecondaryButtonClicked);
+		it->second->DrawOrder = ++DrawOrderCounter;
+		Compacted[it->second->DrawOrder] = it->second;
 	};
 
-	Vector2 MaxSize = Vector2(Manager->GetOwner()->getSize().x * 0.95f, Manager->GetOwner()->getSize().y * 0.45f);
-
-	TheText->SetSkin(Skin);
-	TheText->SetSize(MaxSize);
-	TheText->SetText(Message);
-
-	MaxSize = TheText->GetTextSize();
-
-	TheText->SetSize(MaxSize);
-	TheWindow->SetSize(MaxSize + Vector2(0, (float)TheWindow->GetTitleHeight() + TheWindow->GetTitleOffset()));
-	TheText->SetPosition(Vector2(0, (float)TheWindow->GetTitleHeight() + TheWindow->GetTitleOffset()));
+	ZOrder.swap(Compacted);
 
-	TheMainButton->SetPosition(TheText->GetPosition() + Vector2(TheSecondaryButton.Get() ? (TheWindow->GetSize().x / 2 - TheMainButton->GetSize().x * 2) :
-		(TheWindow->GetSize().x - TheMainButton->GetSize().x) / 2.f, TheText->GetSize().y + 10));
+	DrawOrderCacheDirty = HitTestIndexDirty = true;
+};
 
-	AddChildren(TheWindow);
-	AddChildren(TheText);
-	AddChildren(TheMainButton);
+void UIManager::BringToFront(UIPanel *Element)
+{
+	if(Element == NULL || Element->Manager != this)
+		return;
 
-	std::string Base = std::string("__MESSAGEBOX__") + StringUtils::MakeIntString((long)this, true);
+	while(Element->GetParent())
+	{
+		Element = Element->GetParent();
+	};
 
-	Manager->AddElement(MakeStringID(Base + "_WINDOW__"), TheWindow);
-	Manager->AddElement(MakeStringID(Base + "_TEXT__"), TheText);
-	Manager->AddElement(MakeStringID(Base + "_MAINBUTTON__"), TheMainButton);
+	ElementMap::iterator it = Elements.find(Element->ID);
 
-	if(TheSecondaryButton.Get())
-	{
-		TheSecondaryButton->SetPosition(TheText->GetPosition() + Vector2((TheWindow->GetSize().x / 2 + TheSecondaryButton->GetSize().x), TheText->GetSize().y + 10));
+	if(it == Elements.end() || it->second.Get() == NULL || it->second->DrawOrder == DrawOrderCounter)
+		return;
 
-		AddChildren(TheSecondaryButton);
+	ZOrder.erase(it->second->DrawOrder);
+	it->second->DrawOrder = ++DrawOrderCounter;
+	ZOrder[it->second->DrawOrder] = it->second;
 
-		Manager->AddElement(MakeStringID(Base + "_SECONDARYBUTTON__"), TheSecondaryButton);
-	};
+	DrawOrderCacheDirty = HitTestIndexDirty = true;
 
-	PositionValue = Vector2(((float)Manager->GetOwner()->getSize().x - MaxSize.x) / 2.f,
-		((float)Manager->GetOwner()->getSize().y - MaxSize.y) / 2.f);
+	CompactDrawOrder();
 };
 
-void UIMessageBox::PerformLayout()
+UIManager::ElementInfo::~ElementInfo()
 {
-	SizeValue = GetChildrenSize();
+	Manager->ZOrder.erase(DrawOrder);
+	Manager->DrawOrderCacheDirty = Manager->HitTestIndexDirty = true;
+
+	Panel.Dispose();
 };
 
-void UIMessageBox::Update(const Vector2 &ParentPosition)
+#define HITTEST_CELL_SIZE 64
+
+void UIManager::BuildHitTestIndex()
 {
-	PerformLayout();
+	HitTestIndexDirty = false;
+	HitTestMovedElements.clear();
+	//Whatever made us rebuild may have moved elements under the mouse
+	MouseOverDirty = true;
+	HitTestEntries.clear();
+	HitTestCells.clear();
+	HitTestAreaSize = Vector2((float)Owner->getSize().x, (float)Owner->getSize().y);
 
-	Children[0]->SetSize(SizeValue);
+	RefreshDrawOrderCache();
 
-	for(unsigned long i = 0; i < Children.size(); i++)
+	unsigned long Order = 0;
+	Rect Unbounded(-999999999.f, 999999999.f, -999999999.f, 999999999.f);
+
+	for(unsigned long i = 0; i < DrawOrderCache.size(); i++)
 	{
-		Children[i]->Update(ParentPosition + PositionValue);
-	};
+		if(DrawOrderCache[i]->Panel.Get() == NULL)
+			continue;
 
-	PositionValue = PositionValue + Children[0]->GetPosition();
-	Children[0]->SetPosition(Vector2());
+		AddToHitTestIndex(DrawOrderCache[i]->Panel, Unbounded, DrawOrderCache[i]->DrawOrder, Order);
+	};
 };
 
-void UIMessageBox::Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer)
+void UIManager::AddToHitTestIndex(UIPanel *p, const Rect &ParentBounds, unsigned long DrawOrder, unsigned long &Order)
 {
-	Vector2 ActualPosition = ParentPosition + PositionValue;
-
-	if(!IsVisible() || AlphaValue == 0 || (ActualPosition.x + SizeValue.x < 0 ||
-		ActualPosition.x > Renderer->getSize().x || ActualPosition.y + SizeValue.y < 0 ||
-		ActualPosition.y > Renderer->getSize().y))
+	if(!p->IsVisible() || !p->IsEnabled() || !p->IsMouseInputEnabled())
 		return;
 
-	if(TheWindow->IsClosed())
-	{
-		unsigned long ManagerID = (unsigned long)Manager;
+	//Elements that can't be hit anywhere still get an entry, so they keep their Order if they move into view
+	HitTestEntry Entry;
+	Entry.Panel = p;
+	Entry.DrawOrder = DrawOrder;
+	Entry.Order = Order++;
+	Entry.Indexed = false;
 
-		std::vector<unsigned char> Stream(sizeof(StringID) + sizeof(unsigned long));
-		memcpy(&Stream[0], &ID, sizeof(StringID));
-		memcpy(&Stream[sizeof(StringID)], &ManagerID, sizeof(unsigned long));
+	p->HitTestEntryIndex = HitTestEntries.size();
+	HitTestEntries.push_back(Entry);
 
-		Future::Instance.Post(RemoveElementFuture, Stream);
-	};
+	Rect Bounds = IndexHitTestEntry(p->HitTestEntryIndex, ParentBounds);
 
-	for(unsigned long i = 0; i < Children.size(); i++)
+	for(unsigned long i = 0; i < p->Children.size(); i++)
 	{
-		Children[i]->Draw(ParentPosition + PositionValue, Renderer);
+		AddToHitTestIndex(p->Children[i], Bounds, DrawOrder, Order);
 	};
 };
 
-void UIDraggable::OnMouseJustPressedDraggable(UIPanel *This, const InputCenter::MouseButtonInfo &o)
+bool UIManager::HasHitTestEntry(UIPanel *p) const
 {
-	if(o.Name != sf::Mouse::Left)
-		return;
-
-	Dragging = true;
-
-	OnDragBegin(this);
+	return p->HitTestEntryIndex < HitTestEntries.size() && HitTestEntries[p->HitTestEntryIndex].Panel == p;
 };
 
-void UIDraggable::OnMouseReleasedDraggable(UIPanel *This, const InputCenter::MouseButtonInfo &o)
+Rect UIManager::IndexHitTestEntry(unsigned long Index, const Rect &ParentBounds)
 {
-	if(o.Name != sf::Mouse::Left)
-		return;
+	HitTestEntry &Entry = HitTestEntries[Index];
+	UIPanel *p = Entry.Panel;
 
-	if(Dragging)
-	{
-		OnDragEnd(this);
+	Vector2 Min = p->GetAbsolutePosition() - p->SelectBoxExtraSize / 2, Max = Min + p->GetSize() + p->SelectBoxExtraSize;
+	const Rect &ClipRect = p->GetClipRect();
 
-		Dragging = false;
+	//Children can only be hit where their parents can
+	Entry.Bounds.Left = Min.x > ParentBounds.Left ? Min.x : ParentBounds.Left;
+	Entry.Bounds.Right = Max.x < ParentBounds.Right ? Max.x : ParentBounds.Right;
+	Entry.Bounds.Top = Min.y > ParentBounds.Top ? Min.y : ParentBounds.Top;
+	Entry.Bounds.Bottom = Max.y < ParentBounds.Bottom ? Max.y : ParentBounds.Bottom;
 
-		SuperSmartPointer<UIDroppable> Drop = GetManager()->GetMouseOverElement();
+	if(ClipRect.Left > Entry.Bounds.Left)
+		Entry.Bounds.Left = ClipRect.Left;
 
-		if(!Drop.Get())
-			return;
+	if(ClipRect.Right < Entry.Bounds.Right)
+		Entry.Bounds.Right = ClipRect.Right;
 
-		Drop->OnDrop(this);
-	};
-};
+	if(ClipRect.Top > Entry.Bounds.Top)
+		Entry.Bounds.Top = ClipRect.Top;
 
-SuperSmartPointer<UIPanel> UIManager::GetMouseOverElement()
-{
-	if(DrawOrderCacheDirty)
-	{
-		DrawOrderCacheDirty = false;
-		DrawOrderCache.clear();
+	if(ClipRect.Bottom < Entry.Bounds.Bottom)
+		Entry.Bounds.Bottom = ClipRect.Bottom;
 
-		for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
-		{
-			if(it->second->Panel->GetParent() == NULL)
-			{
-				DrawOrderCache.push_back(it->second);
-			};
-		};
-	};
+	Entry.Indexed = Entry.Bounds.Left <= Entry.Bounds.Right && Entry.Bounds.Top <= Entry.Bounds.Bottom;
 
-	UIPanel *FoundElement = NULL;
+	if(!Entry.Indexed)
+		return Entry.Bounds;
 
-	SuperSmartPointer<UIPanel> InputBlocker;
+	//Only the Owner's area can be queried, so don't waste cells outside of it
+	long FirstX = (long)floorf((Entry.Bounds.Left > 0 ? Entry.Bounds.Left : 0) / HITTEST_CELL_SIZE),
+		LastX = (long)floorf((Entry.Bounds.Right < HitTestAreaSize.x ? Entry.Bounds.Right : HitTestAreaSize.x) / HITTEST_CELL_SIZE),
+		FirstY = (long)floorf((Entry.Bounds.Top > 0 ? Entry.Bounds.Top : 0) / HITTEST_CELL_SIZE),
+		LastY = (long)floorf((Entry.Bounds.Bottom < HitTestAreaSize.y ? Entry.Bounds.Bottom : HitTestAreaSize.y) / HITTEST_CELL_SIZE);
 
-	for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
+	for(long y = FirstY; y <= LastY; y++)
 	{
-		while(it != Elements.end() && it->second.Get() == NULL)
+		for(long x = FirstX; x <= LastX; x++)
 		{
-			Elements.erase(it);
-			it = Elements.begin();
+			HitTestCells[std::pair<long, long>(x, y)].push_back(Index);
 		};
+	};
 
-		if(it == Elements.end())
-			break;
+	return Entry.Bounds;
+};
 
-		if(it->second->Panel->BlockingInput && it->second->Panel->IsVisible())
-		{
-			InputBlocker = it->second->Panel;
+void UIManager::UnindexHitTestEntry(unsigned long Index)
+{
+	HitTestEntry &Entry = HitTestEntries[Index];
 
-			break;
-		};
-	};
+	if(!Entry.Indexed)
+		return;
 
-	if(InputBlocker.Get())
-	{
-		UIPanel *p = InputBlocker;
-		RecursiveFindFocusedElement(Vector2(), p, FoundElement);
-	}
-	else
+	Entry.Indexed = false;
+
+	//The same cells IndexHitTestEntry added it to
+	long FirstX = (long)floorf((Entry.Bounds.Left > 0 ? Entry.Bounds.Left : 0) / HITTEST_CELL_SIZE),
+		LastX = (long)floorf((Entry.Bounds.Right < HitTestAreaSize.x ? Entry.Bounds.Right : HitTestAreaSize.x) / HITTEST_CELL_SIZE),
+		FirstY = (long)floorf((Entry.Bounds.Top > 0 ? Entry.Bounds.Top : 0) / HITTEST_CELL_SIZE),
+		LastY = (long)floorf((Entry.Bounds.Bottom < HitTestAreaSize.y ? Entry.Bounds.Bottom : HitTestAreaSize.y) / HITTEST_CELL_SIZE);
+
+	for(long y = FirstY; y <= LastY; y++)
 	{
-		for(long i = DrawOrderCounter; i >= 0; i--)
+		for(long x = FirstX; x <= LastX; x++)
 		{
-			for(unsigned long j = 0; j < DrawOrderCache.size(); j++)
-			{
-				if(!DrawOrderCache[j]->Panel->MouseInputValue || DrawOrderCache[j]->DrawOrder != i)
-					continue;
+			HitTestCellMap::iterator it = HitTestCells.find(std::pair<long, long>(x, y));
 
-				UIPanel *p = DrawOrderCache[j]->Panel;
+			if(it == HitTestCells.end())
+				continue;
 
-				RecursiveFindFocusedElement(Vector2(), p, FoundElement);
+			std::vector<unsigned long>::iterator CellEntry = std::find(it->second.begin(), it->second.end(), Index);
 
-				if(FoundElement)
-					break;
-			};
+			if(CellEntry == it->second.end())
+				continue;
 
-			if(FoundElement)
-				break;
+			//Order within a cell doesn't matter, since HitTest compares Draw Orders
+			*CellEntry = it->second.back();
+			it->second.pop_back();
 		};
 	};
-
-	if(FoundElement && Elements[FoundElement->ID].Get())
-	{
-		return Elements[FoundElement->ID]->Panel;
-	};
-
-	return SuperSmartPointer<UIPanel>();
 };
 
-void UIManager::Update()
+void UIManager::ReindexHitTestEntries(UIPanel *p, const Rect &ParentBounds)
 {
-	if(DrawOrderCacheDirty)
-	{
-		DrawOrderCacheDirty = false;
-		DrawOrderCache.clear();
+	//Elements without entries were hidden or disabled, which rebuilds the whole index when it changes
+	if(!HasHitTestEntry(p))
+		return;
 
-		for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
-		{
-			if(it->second->Panel->GetParent() == NULL)
-			{
-				DrawOrderCache.push_back(it->second);
-			};
-		};
-	};
+	UnindexHitTestEntry(p->HitTestEntryIndex);
 
-	for(unsigned long i = 0; i < DrawOrderCache.size(); i++)
-	{
-		if(DrawOrderCache[i]->Panel.Get() == NULL)
-			continue;
+	Rect Bounds = IndexHitTestEntry(p->HitTestEntryIndex, ParentBounds);
 
-		if(DrawOrderCache[i]->Panel->IsVisible())
-		{
-			DrawOrderCache[i]->Panel->Update(Vector2());
-		};
+	for(unsigned long i = 0; i < p->Children.size(); i++)
+	{
+		ReindexHitTestEntries(p->Children[i], Bounds);
 	};
 };
 
-void UIManager::Draw(sf::RenderWindow *Renderer)
+void UIManager::RefreshHitTestIndex()
 {
-	if(DrawOrderCacheDirty)
+	if(HitTestIndexDirty || HitTestAreaSize != Vector2((float)Owner->getSize().x, (float)Owner->getSize().y))
 	{
-		DrawOrderCacheDirty = false;
-		DrawOrderCache.clear();
+		BuildHitTestIndex();
 
-		for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
-		{
-			if(it->second->Panel->GetParent() == NULL)
-			{
-				DrawOrderCache.push_back(it->second);
-			};
-		};
+		return;
 	};
 
-	SuperSmartPointer<UIPanel> InputBlocker;
+	if(HitTestMovedElements.size() == 0)
+		return;
+
+	//Moved elements may now be under the mouse
+	MouseOverDirty = true;
 
-	for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
+	std::vector<UIPanel *> Moved;
+	Moved.swap(HitTestMovedElements);
+
+	for(unsigned long i = 0; i < Moved.size(); i++)
 	{
-		if(it->second->Panel->BlockingInput && it->second->Panel->IsVisible())
-		{
-			InputBlocker = it->second->Panel;
+		UIPanel *Parent = Moved[i]->GetParent();
 
-			break;
+		if(Parent == NULL)
+		{
+			ReindexHitTestEntries(Moved[i], Rect(-999999999.f, 999999999.f, -999999999.f, 999999999.f));
+		}
+		else if(HasHitTestEntry(Parent))
+		{
+			ReindexHitTestEntries(Moved[i], HitTestEntries[Parent->HitTestEntryIndex].Bounds);
 		};
 	};
+};
 
-	for(unsigned long i = 0; i <= DrawOrderCounter; i++)
-	{
-		for(unsigned long j = 0; j < DrawOrderCache.size(); j++)
-		{
-			if(DrawOrderCache[j]->Panel.Get() == NULL || DrawOrderCache[j]->DrawOrder != i || !DrawOrderCache[j]->Panel->IsVisible())
-				continue;
+UIPanel *UIManager::HitTest(const Vector2 &Position)
+{
+	RefreshHitTestIndex();
 
-			if(DrawOrderCache[j]->Panel == InputBlocker)
-			{
-				glBindTexture(GL_TEXTURE_2D, NULL);
-				glEnableClientState(GL_VERTEX_ARRAY);
-				glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-				glDisableClientState(GL_NORMAL_ARRAY);
+	if(Position.x < 0 || Position.y < 0 || Position.x > HitTestAreaSize.x || Position.y > HitTestAreaSize.y)
+		return NULL;
 
-				Vector2 Vertices[6] = {
-					Vector2(),
-					Vector2(0, Renderer->getSize().y),
-					Vector2(Renderer->getSize().x, Renderer->getSize().y),
-					Vector2(Renderer->getSize().x, Renderer->getSize().y),
-					Vector2(Renderer->getSize().x, 0),
-					Vector2(),
-				};
+	HitTestCellMap::iterator it = HitTestCells.find(std::pair<long, long>((long)floorf(Position.x / HITTEST_CELL_SIZE),
+		(long)floorf(Position.y / HITTEST_CELL_SIZE)));
 
-				glVertexPointer(2, GL_FLOAT, 0, Vertices);
+	if(it == HitTestCells.end())
+		return NULL;
 
-				glColor4f(0, 0, 0, 0.3f);
+	const HitTestEntry *Found = NULL;
 
-				glDrawArrays(GL_TRIANGLES, 0, 6);
+	for(unsigned long i = 0; i < it->second.size(); i++)
+	{
+		const HitTestEntry &Entry = HitTestEntries[it->second[i]];
 
-				glColor4f(1, 1, 1, 1);
-			};
+		if(Position.x < Entry.Bounds.Left || Position.x > Entry.Bounds.Right || Position.y < Entry.Bounds.Top ||
+			Position.y > Entry.Bounds.Bottom)
+			continue;
 
-			DrawOrderCache[j]->Panel->Draw(Vector2(), Renderer);
-		};
+		//Most recently added root first, then the last element in its hierarchy, like the recursive search
+		if(Found == NULL || Entry.DrawOrder > Found->DrawOrder || (Entry.DrawOrder == Found->DrawOrder && Entry.Order > Found->Order))
+			Found = &Entry;
 	};
 
-	Tooltip->Update(Vector2());
-	Tooltip->Draw(GetInput()->MousePosition, Renderer);
+	return Found ? Found->Panel : NULL;
 };
 
-void UIManager::RecursiveFindFocusedElement(const Vector2 &ParentPosition, UIPanel *p, UIPanel *&FoundElement)
+void UIManager::RecursiveFindFocusedElement(UIPanel *p, UIPanel *&FoundElement)
 {
 	if(!p->IsVisible() || !p->IsEnabled() || !p->IsMouseInputEnabled())
 		return;
 
+	const Vector2 &MousePosition = GetInput()->MousePosition;
+	const Rect &ClipRect = p->GetClipRect();
+
+	//Clipped away, such as items scrolled out of a Scrollable Frame
+	if(MousePosition.x < ClipRect.Left || MousePosition.x > ClipRect.Right || MousePosition.y < ClipRect.Top ||
+		MousePosition.y > ClipRect.Bottom)
+		return;
+
 	static AxisAlignedBoundingBox AABB;
 
-	AABB.min = ParentPosition + p->GetPosition() - p->SelectBoxExtraSize / 2;
+	AABB.min = p->GetAbsolutePosition() - p->SelectBoxExtraSize / 2;
 	AABB.max = AABB.min + p->GetSize() + p->SelectBoxExtraSize;
 
-	if(AABB.IsInside(GetInput()->MousePosition) &&
+	if(AABB.IsInside(MousePosition) &&
 		p->MouseInputValue)
 	{
 		FoundElement = p;
 
 		for(unsigned long i = 0; i < p->Children.size(); i++)
 		{
-			RecursiveFindFocusedElement(ParentPosition + p->GetPosition() - p->GetTranslation() *
-				(p->GetParent() == NULL ? p->GetSize() : p->SizeValue - p->GetParent()->GetSize()),
-				p->Children[i], FoundElement);
+			RecursiveFindFocusedElement(p->Children[i], FoundElement);
 		};
 	};
 };
 
 void UIManager::OnMouseJustPressedPriv(const InputCenter::MouseButtonInfo &o)
 {
-	if(DrawOrderCacheDirty)
-	{
-		DrawOrderCacheDirty = false;
-		DrawOrderCache.clear();
-
-		for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
-		{
-			if(it->second->Panel->GetParent() == NULL)
-			{
-				DrawOrderCache.push_back(it->second);
-			};
-		};
-	};
+	RefreshDrawOrderCache();
 
 	if(o.Name == sf::Mouse::Left)
 	{
@@ -3147,43 +5243,16 @@ void UIManager::OnMouseJustPressedPriv(const InputCenter::MouseButtonInfo &o)
 		FocusedElementValue = SuperSmartPointer<UIPanel>();
 		UIPanel *FoundElement = NULL;
 
-		SuperSmartPointer<UIPanel> InputBlocker;
-
-		for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
-		{
-			if(it->second->Panel->BlockingInput && it->second->Panel->IsVisible())
-			{
-				InputBlocker = it->second->Panel;
-
-				break;
-			};
-		};
+		SuperSmartPointer<UIPanel> InputBlocker = FindInputBlocker();
 
 		if(InputBlocker.Get())
 		{
 			UIPanel *p = InputBlocker;
-			RecursiveFindFocusedElement(Vector2(), p, FoundElement);
+			RecursiveFindFocusedElement(p, FoundElement);
 		}
 		else
 		{
-			for(long i = DrawOrderCounter; i >= 0; i--)
-			{
-				for(unsigned long j = 0; j < DrawOrderCache.size(); j++)
-				{
-					if(!DrawOrderCache[j]->Panel->MouseInputValue || DrawOrderCache[j]->DrawOrder != i)
-						continue;
-
-					UIPanel *p = DrawOrderCache[j]->Panel;
-
-					RecursiveFindFocusedElement(Vector2(), p, FoundElement);
-
-					if(FoundElement)
-						break;
-				};
-
-				if(FoundElement)
-					break;
-			};
+			FoundElement = HitTest(GetInput()->MousePosition);
 		};
 
 		if(FoundElement)
@@ -3214,8 +5283,7 @@ void UIManager::OnMouseJustPressedPriv(const InputCenter::MouseButtonInfo &o)
 
 		if(CurrentMenu.Get() && FocusedElementValue.Get() != CurrentMenu.Get())
 		{
-			std::vector<unsigned char> Temp;
-			RemoveMenuFuture(Temp);
+			RemoveMenuFuture();
 		};
 	};
 
@@ -3223,6 +5291,10 @@ void UIManager::OnMouseJustPressedPriv(const InputCenter::MouseButtonInfo &o)
 	{
 		FocusedElementValue->OnMouseJustPressedPriv(o);
 		GetInput()->ConsumeInput();
+
+		//It may have changed how it looks, or even been removed
+		if(FocusedElementValue)
+			FocusedElementValue->Damage();
 	};
 };
 
@@ -3241,6 +5313,9 @@ void UIManager::OnMouseReleasedPriv(const InputCenter::MouseButtonInfo &o)
 	{
 		FocusedElementValue->OnMouseReleasedPriv(o);
 		GetInput()->ConsumeInput();
+
+		if(FocusedElementValue)
+			FocusedElementValue->Damage();
 	};
 };
 
@@ -3273,6 +5348,9 @@ void UIManager::OnKeyJustPressedPriv(const InputCenter::KeyInfo &o)
 	{
 		FocusedElementValue->OnKeyJustPressedPriv(o);
 		GetInput()->ConsumeInput();
+
+		if(FocusedElementValue)
+			FocusedElementValue->Damage();
 	};
 };
 
@@ -3291,6 +5369,9 @@ void UIManager::OnKeyReleasedPriv(const InputCenter::KeyInfo &o)
 	{
 		FocusedElementValue->OnKeyReleasedPriv(o);
 		GetInput()->ConsumeInput();
+
+		if(FocusedElementValue)
+			FocusedElementValue->Damage();
 	};
 };
 
@@ -3300,6 +5381,9 @@ void UIManager::OnCharacterEnteredPriv()
 	{
 		FocusedElementValue->OnCharacterEnteredPriv();
 		GetInput()->ConsumeInput();
+
+		if(FocusedElementValue)
+			FocusedElementValue->Damage();
 	};
 };
 
@@ -3345,7 +5429,7 @@ void UIManager::UnRegisterInput()
 
 bool UIManager::AddElement(StringID ID, SuperSmartPointer<UIPanel> Element)
 {
-	DrawOrderCacheDirty = true;
+	DrawOrderCacheDirty = HitTestIndexDirty = true;
 
 	ElementMap::iterator it = Elements.find(ID);
 
@@ -3366,18 +5450,21 @@ bool UIManager::AddElement(StringID ID, SuperSmartPointer<UIPanel> Element)
 	if(Element->Manager != this)
 		return false;
 
-	Elements[ID].Reset(new ElementInfo());
+	Elements[ID].Reset(new ElementInfo(this));
 	Elements[ID]->Panel = Element;
 	Elements[ID]->DrawOrder = ++DrawOrderCounter;
+	ZOrder[DrawOrderCounter] = Elements[ID];
 	Element->ID = ID;
 	Element->SetSkin(Skin);
 
+	CompactDrawOrder();
+
 	return true;
 };
 
 void UIManager::RemoveElement(StringID ID)
 {
-	DrawOrderCacheDirty = true;
+	DrawOrderCacheDirty = HitTestIndexDirty = true;
 
 	ElementMap::iterator it = Elements.find(ID);
 
@@ -3386,13 +5473,18 @@ void UIManager::RemoveElement(StringID ID)
 		SuperSmartPointer<ElementInfo> Element = it->second;
 		Elements.erase(it);
 
+		if(Element.Get() && Element->Panel.Get())
+			Element->Panel->Damage();
+
 		Element.Dispose();
 	};
 };
 
 void UIManager::Clear()
 {
-	DrawOrderCacheDirty = true;
+	DrawOrderCacheDirty = HitTestIndexDirty = true;
+
+	DamageAll();
 
 	while(Elements.begin() != Elements.end())
 	{
@@ -3452,11 +5544,40 @@ void UIManager::SetSkin(SuperSmartPointer<GenericConfig> Skin)
 
 	std::string DefaultFontValue = Skin->GetString("General", "DefaultFont");
 
+	//Glyph pages and cached metrics are keyed by the font's address, which may be reused by the new font
+	TextEngine::Instance.Clear();
+
 	DefaultFont.Reset(new sf::Font());
 
 	if(!DefaultFont->loadFromFile(DefaultFontValue))
 		DefaultFont.Dispose();
 
+	std::vector<std::string> SkinTexturePaths;
+	std::vector<std::string> Sections = Skin->GetSectionNames();
+
+	for(unsigned long i = 0; i < Sections.size(); i++)
+	{
+		std::vector<std::string> Values = Skin->GetValueNames(Sections[i].c_str());
+
+		for(unsigned long j = 0; j < Values.size(); j++)
+		{
+			//Anything named *Texture* that isn't a nine-patch *TextureRect is a texture path
+			if(Values[j].find("Texture") == std::string::npos || Values[j].rfind("Rect") == Values[j].length() - 4)
+				continue;
+
+			SkinTexturePaths.push_back(Skin->GetString(Sections[i].c_str(), Values[j].c_str()));
+		};
+	};
+
+	SkinAtlas.Build(SkinTexturePaths);
+
+	SpriteBatch::Instance.SetAtlas(&SkinAtlas);
+
+	for(unsigned long i = 0; i < SkinTexturePaths.size(); i++)
+	{
+		Textures.Add(SkinTexturePaths[i], SkinAtlas.GetTexture(SkinTexturePaths[i]));
+	};
+
 	for(ElementMap::iterator it = Elements.begin(); it != Elements.end(); it++)
 	{
 		if(it->second.Get() == NULL)
@@ -3464,6 +5585,9 @@ void UIManager::SetSkin(SuperSmartPointer<GenericConfig> Skin)
 
 		it->second->Panel->SetSkin(Skin);
 	};
+
+	//Drop whatever the previous skin was holding on to
+	Textures.Collect();
 };
 
 UIMenu *UIManager::CreateMenu(const Vector2 &Position)
@@ -3492,7 +5616,12 @@ UIMenuBar *UIManager::CreateMenuBar()
 	return CurrentMenuBar;
 };
 
-void UIManager::RemoveMenuFuture(std::vector<unsigned char> &Stream)
+SuperSmartPointer<sf::Texture> UIManager::GetSkinTexture(const std::string &Path)
+{
+	return Textures.Get(Path);
+};
+
+void UIManager::RemoveMenuFuture()
 {
 	RemoveElement(MakeStringID("__UIMANAGER_CURRENT_MENU__"));
 };
@@ -5,91 +5,8 @@ class UILayout;
 
 #define FLAGVALUE(x) (1 << x)
 
-/*!
-*	Text rendering parameters
-*/
-class TextParams
-{
-public:
-	Vector4 TextColorValue, SecondaryTextColorValue, BorderColorValue;
-	Vector2 PositionValue;
-	float BorderSizeValue;
-
-	TextParams() : BorderSizeValue(0), TextColorValue(1, 1, 1, 1), SecondaryTextColorValue(1, 1, 1, 1), BorderColorValue(0, 0, 0, 1) {}
-	TextParams(const TextParams &o) : BorderSizeValue(o.BorderSizeValue), TextColorValue(o.TextColorValue), SecondaryTextColorValue(o.SecondaryTextColorValue),
-		BorderColorValue(o.BorderColorValue), PositionValue(o.PositionValue) {};
-
-	TextParams &operator=(const TextParams &o)
-	{
-		BorderSizeValue = o.BorderSizeValue;
-		TextColorValue = o.TextColorValue;
-		SecondaryTextColorValue = o.SecondaryTextColorValue;
-		BorderColorValue = o.BorderColorValue;
-		PositionValue = o.PositionValue;
-
-		return *this;
-	};
-
-	/*!
-	*	Sets the text color
-	*	\param Color the color to use
-	*	\note Changes the secondary color too to prevent issues with using this
-	*	\sa SecondaryColor
-	*/
-	TextParams &Color(const Vector4 &Color)
-	{
-		TextColorValue = SecondaryTextColorValue = Color;
-
-		return *this;
-	};
-
-	/*!
-	*	Sets the secondary text color
-	*	\param SecondaryColor the secondary color to use
-	*	\sa Color
-	*/
-	TextParams &SecondaryColor(const Vector4 &SecondaryColor)
-	{
-		SecondaryTextColorValue = SecondaryColor;
-
-		return *this;
-	};
-
-	/*!
-	*	Sets the border color for the text
-	*	\param BorderColor the border color to use (default value is 0, 0, 0, 1)
-	*	\sa BorderSize
-	*/
-	TextParams &BorderColor(const Vector4 &BorderColor)
-	{
-		BorderColorValue = BorderColor;
-
-		return *this;
-	};
-
-	/*!
-	*	Sets the border size for the text
-	*	\param BorderSize the size of the border, in pixels (default value is 0)
-	*	\sa BorderColor
-	*/
-	TextParams &BorderSize(float BorderSize)
-	{
-		BorderSizeValue = BorderSize;
-
-		return *this;
-	};
-
-	/*!
-	*	Sets the text position
-	*	\param Position the text's position
-	*/
-	TextParams &Position(const Vector2 &Position)
-	{
-		PositionValue = Position;
-
-		return *this;
-	};
-};
+//!<Identifies an animation started by UIManager::Animate or UIManager::AnimateSprite. 0 is never used
+typedef unsigned long AnimationHandle;
 
 /*!
 *	UI Panel class
@@ -97,6 +14,7 @@ public:
 class UIPanel
 {
 	friend class UIManager;
+	friend class UIScrollableFrame;
 protected:
 	bool VisibleValue, EnabledValue, MouseInputValue, KeyboardInputValue;
 	Vector2 PositionValue, SizeValue, TranslationValue, SelectBoxExtraSize;
@@ -113,6 +31,36 @@ protected:
 	bool ClickPressed;
 	//!<Whether we are blocking Input
 	bool BlockingInput;
+	//!<Whether PerformLayout must run on the next layout pass
+	bool LayoutDirty;
+	//!<Absolute position of this element, as drawn
+	Vector2 AbsolutePositionValue;
+	//!<Absolute area in which this element is visible
+	Rect ClipRectValue;
+	//!<Whether our own position changed since AbsolutePositionValue and ClipRectValue were calculated
+	bool TransformDirty;
+	//!<Whether UpdateTransform must visit us, because we or one of our children moved
+	bool TransformPending;
+	//!<Changes whenever what our children's transforms depend on changes
+	unsigned long TransformVersion;
+	//!<Our parent's TransformVersion when AbsolutePositionValue and ClipRectValue were calculated
+	unsigned long ParentTransformVersion;
+	//!<Whether the mouse is over this element or one of its children
+	bool MouseOverValue;
+	//!<What we drew last time, when we're a root element
+	DrawCommandList DrawCommands;
+	//!<Whether anything in our hierarchy changed since DrawCommands were recorded
+	bool DrawCommandsDirty;
+	//!<TextEngine Glyph Generation DrawCommands were recorded with
+	unsigned long DrawCommandsGlyphGeneration;
+	//!<Whether we draw our hierarchy once into Layer and then draw Layer, rather than drawing our hierarchy every time
+	bool CacheAsLayerValue;
+	//!<Our hierarchy as last drawn, when CacheAsLayerValue is set
+	SuperSmartPointer<sf::RenderTexture> Layer;
+	//!<Whether anything in our hierarchy changed since Layer was drawn
+	bool LayerDirty;
+	//!<Our entry in the UI Manager's hit testing index, if it still refers to us
+	unsigned long HitTestEntryIndex;
 	StringID ID;
 	SuperSmartPointer<GenericConfig> Skin;
 
@@ -121,6 +69,76 @@ protected:
 	*/
 	virtual void OnSkinChange() {};
 
+	/*!
+	*	\param Child one of our children
+	*	\return whether our Translation (and content clipping) applies to that child
+	*/
+	virtual bool IsTranslatedChild(const UIPanel *Child) const
+	{
+		return true;
+	};
+
+	/*!
+	*	Gets the absolute area our translated children are clipped to
+	*	\param Out the area
+	*	\return whether we clip our children
+	*/
+	virtual bool GetContentClipRect(Rect &Out)
+	{
+		return false;
+	};
+
+	/*!
+	*	Recalculates the absolute position and clip rect of this element if it or one of its parents changed
+	*	\note Resolves our parents first, so this is O(depth) even when nothing changed
+	*/
+	void RefreshTransform();
+
+	/*!
+	*	Recalculates the transforms of this moved element and all its children, damaging where they were and are now drawn
+	*/
+	void RefreshMovedTransform();
+
+	/*!
+	*	Tells the UI Manager its hit testing index is out of date
+	*	\note Rebuilds the whole index, so only use it when elements are added, removed, shown, hidden, enabled or disabled
+	*/
+	void InvalidateHitTest();
+
+	/*!
+	*	Tells the UI Manager where this element and its children can be hit changed, but nothing else did
+	*/
+	void InvalidateHitTestBounds();
+
+	/*!
+	*	Tells the UI Manager the area we draw to must be redrawn
+	*	\note Does nothing unless the UI Manager is tracking damage
+	*	\sa UIManager::SetDamageTracking
+	*/
+	void Damage();
+
+	/*!
+	*	\return the absolute area this element draws to
+	*	\note Used for damage tracking, so it may be larger than what we draw, but never smaller
+	*/
+	virtual Rect GetDrawArea();
+
+	/*!
+	*	\param ActualPosition where we're being drawn
+	*	\param Renderer the Renderer being drawn to
+	*	\return whether nothing we'd draw would be visible, because we're outside the Renderer or scissored away
+	*/
+	bool IsCulled(const Vector2 &ActualPosition, sf::RenderWindow *Renderer);
+
+	/*!
+	*	\return how long until this element changes on its own, in milliseconds, or InputCenter::WaitForever
+	*	\note Only asked of the focused element
+	*/
+	virtual unsigned long GetTimeUntilUpdate()
+	{
+		return InputCenter::WaitForever;
+	};
+
 	void OnMouseJustPressedPriv(const InputCenter::MouseButtonInfo &o)
 	{
 		if(!MouseInputValue || !EnabledValue)
@@ -169,6 +187,22 @@ protected:
 		OnMouseMove(this);
 	};
 
+	void OnMouseEnterPriv()
+	{
+		MouseOverValue = true;
+
+		Damage();
+		OnMouseEnter(this);
+	};
+
+	void OnMouseLeavePriv()
+	{
+		MouseOverValue = false;
+
+		Damage();
+		OnMouseLeave(this);
+	};
+
 	void OnKeyPressedPriv(const InputCenter::KeyInfo &o)
 	{
 		if(!KeyboardInputValue || !EnabledValue)
@@ -203,11 +237,13 @@ protected:
 
 	void OnLoseFocusPriv()
 	{
+		Damage();
 		OnLoseFocus(this);
 	};
 
 	void OnGainFocusPriv()
 	{
+		Damage();
 		OnGainFocus(this);
 	};
 
@@ -223,12 +259,19 @@ protected:
 public:
 
 	Signal1<UIPanel *> OnClick, OnLoseFocus, OnGainFocus, OnCharacterEntered, OnMouseMove;
+	//!<Emitted when the mouse starts or stops being over this element or one of its children
+	Signal1<UIPanel *> OnMouseEnter, OnMouseLeave;
 	Signal2<UIPanel *, const InputCenter::MouseButtonInfo &> OnMouseJustPressed, OnMousePressed, OnMouseReleased;
 	Signal2<UIPanel *, const InputCenter::KeyInfo &> OnKeyJustPressed, OnKeyPressed, OnKeyReleased;
+	//!<Emitted when one of this element's animations finishes (but not when it's stopped)
+	Signal2<UIPanel *, AnimationHandle> OnAnimationFinished;
 
 	UIPanel(UIManager *_Manager) : Manager(_Manager), VisibleValue(true),
 		EnabledValue(true), MouseInputValue(true), KeyboardInputValue(true), AlphaValue(1),
-		ClickPressed(false), BlockingInput(false)
+		ClickPressed(false), BlockingInput(false), LayoutDirty(true), TransformDirty(true), TransformPending(false),
+		TransformVersion(0), ParentTransformVersion(0), MouseOverValue(false),
+		DrawCommandsDirty(true), DrawCommandsGlyphGeneration(0), CacheAsLayerValue(false), LayerDirty(true),
+		HitTestEntryIndex(0)
 	{
 	};
 
@@ -248,6 +291,15 @@ public:
 	*/
 	virtual void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer) = 0;
 
+	/*!
+	*	Draws this element based on the parent position, using our cached layer if we have one
+	*	\param ParentPosition the parent's position
+	*	\param Renderer the Renderer to draw to
+	*	\note Elements should draw their children with this rather than with Draw
+	*	\sa SetCacheAsLayer
+	*/
+	void DrawLayered(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
+
 	/*!
 	*	\return Whether this element respondes to Tooltips
 	*/
@@ -264,15 +316,44 @@ public:
 
 	/*!
 	*	Perform auto calculation of sizes here
+	*	\note Prefer InvalidateLayout, which lets the UI Manager lay out only what changed
 	*/
 	virtual void PerformLayout()
 	{
 		for(unsigned long i = 0; i < Children.size(); i++)
 		{
-			Children[i]->PerformLayout();
+			Children[i]->UpdateLayout();
+		};
+	};
+
+	/*!
+	*	Marks this element and all its parents as needing layout
+	*	\note Must be called after changing public members that affect layout (such as a Caption, Items or FontSize)
+	*/
+	void InvalidateLayout()
+	{
+		Damage();
+
+		//Parents of a dirty element are always dirty, so we can stop at the first one
+		for(UIPanel *p = this; p != NULL && !p->LayoutDirty; p = p->GetParent())
+		{
+			p->LayoutDirty = true;
 		};
 	};
 
+	/*!
+	*	Performs layout on this element and its children, if they were invalidated
+	*/
+	void UpdateLayout();
+
+	/*!
+	*	\return whether this element needs layout
+	*/
+	bool IsLayoutDirty() const
+	{
+		return LayoutDirty;
+	};
+
 	/*!
 	*	\return the Tooltip Text to display
 	*/
@@ -325,34 +406,71 @@ public:
 	};
 
 	/*!
-	*	Calculates the position of this element and all its parents to return the overall (absolute) position
-	*	\return the calculated absolute position of this UI Element
+	*	\return the absolute position our Position is relative to (our parent's position minus its translation)
 	*/
 	Vector2 GetParentPosition()
 	{
-		if(!ParentValue)
+		UIPanel *Parent = GetParent();
+
+		if(Parent == NULL)
 			return Vector2();
 
-		Vector2 Position;
-		UIPanel *p = ParentValue;
+		return Parent->GetAbsolutePosition() - (Parent->IsTranslatedChild(this) ? Parent->GetTranslation() : Vector2());
+	};
 
-		while(p)
-		{
-			Position += p->GetPosition() + p->GetTranslation();
+	/*!
+	*	\return the cached absolute position of this element
+	*/
+	const Vector2 &GetAbsolutePosition()
+	{
+		RefreshTransform();
 
-			p = p->GetParent();
-		};
+		return AbsolutePositionValue;
+	};
+
+	/*!
+	*	\return the cached absolute area in which this element is visible
+	*/
+	const Rect &GetClipRect()
+	{
+		RefreshTransform();
 
-		return Position;
+		return ClipRectValue;
 	};
 
+	/*!
+	*	Marks the absolute position and clip rect of this element as out of date
+	*	\note Must be called after changing PositionValue directly
+	*	\note Our children notice on their own when they're next used
+	*/
+	void InvalidateTransform();
+
+	/*!
+	*	Marks the absolute positions and clip rects of our children as out of date, but not ours
+	*	\note Must be called after changing TranslationValue or what GetContentClipRect returns
+	*	\note Only damages our own area, since translated children are clipped to it
+	*/
+	void InvalidateChildTransforms();
+
+	/*!
+	*	Refreshes the transforms of the elements in this hierarchy that moved, and damages where they're drawn
+	*	\note Only visits the path to the elements that moved
+	*/
+	void UpdateTransform();
+
 	/*!
 	*	Set this Element's Visiblity
 	*	\param value whether the element should be visible
 	*/
 	void SetVisible(bool value)
 	{
+		if(VisibleValue == value)
+			return;
+
 		VisibleValue = value;
+
+		InvalidateHitTest();
+		InvalidateLayout();
 	};
 
 	/*!
@@ -369,7 +487,13 @@ public:
 	*/
 	void SetEnabled(bool value)
 	{
+		if(EnabledValue == value)
+			return;
+
 		EnabledValue = value;
+
+		InvalidateHitTest();
+		Damage();
 	};
 
 	/*!
@@ -386,7 +510,12 @@ public:
 	*/
 	void SetMouseInputEnabled(bool value)
 	{
+		if(MouseInputValue == value)
+			return;
+
 		MouseInputValue = value;
+
+		InvalidateHitTest();
 	};
 
 	/*!
@@ -424,19 +553,7 @@ public:
 	*	Removes a children from this element
 	*	\param Child the Child to remove
 	*/
-	void RemoveChild(UIPanel *Child)
-	{
-		for(std::vector<UIPanel *>::iterator it = Children.begin(); it != Children.end(); it++)
-		{
-			if(*it == Child)
-			{
-				Child->ParentValue = SuperSmartPointer<UIPanel>();
-				Children.erase(it);
-
-				return;
-			};
-		};
-	};
+	void RemoveChild(UIPanel *Child);
 
 	/*!
 	*	\return the Translation of this element
@@ -455,6 +572,15 @@ public:
 		return (UIPanel *)ParentValue.Get();
 	};
 
+	/*!
+	*	\return whether the mouse is over this element or one of its children
+	*	\note Updated by the UI Manager, so no hit testing is done here
+	*/
+	bool IsMouseOver() const
+	{
+		return MouseOverValue;
+	};
+
 	/*!
 	*	\return the Position of this Element
 	*/
@@ -469,7 +595,13 @@ public:
 	*/
 	void SetPosition(const Vector2 &Position)
 	{
+		if(PositionValue == Position)
+			return;
+
 		PositionValue = Position;
+
+		InvalidateLayout();
+		InvalidateTransform();
 	};
 
 	/*!
@@ -486,13 +618,23 @@ public:
 	*/
 	void SetSize(const Vector2 &Size)
 	{
-		SizeValue = Size;
+		Vector2 NewSize = Size;
+
+		if(NewSize.x < 0)
+			NewSize.x = 0;
 
-		if(SizeValue.x < 0)
-			SizeValue.x = 0;
+		if(NewSize.y < 0)
+			NewSize.y = 0;
 
-		if(SizeValue.y < 0)
-			SizeValue.y = 0;
+		if(SizeValue == NewSize)
+			return;
+
+		SizeValue = NewSize;
+
+		InvalidateLayout();
+
+		//Our size may clip our children
+		InvalidateTransform();
 	};
 
 	/*!
@@ -509,7 +651,34 @@ public:
 	*/
 	void SetAlpha(float Alpha)
 	{
+		if(AlphaValue == Alpha)
+			return;
+
+		bool LayerValid = !LayerDirty;
+
 		AlphaValue = Alpha;
+
+		Damage();
+
+		//Our layer is drawn without our alpha, which is only applied when compositing it
+		if(CacheAsLayerValue && LayerValid)
+			LayerDirty = false;
+	};
+
+	/*!
+	*	Sets whether this element and its children are drawn once to an offscreen texture, which is then drawn in their place
+	*	\param Value whether to cache this element as a layer
+	*	\note Useful for complex elements that rarely change, since the layer is only redrawn when something in it is damaged
+	*	\note Ignored when the SpriteBatch is headless
+	*/
+	void SetCacheAsLayer(bool Value);
+
+	/*!
+	*	\return whether this element is cached as a layer
+	*/
+	bool IsCacheAsLayer() const
+	{
+		return CacheAsLayerValue;
 	};
 
 	/*!
@@ -524,7 +693,7 @@ public:
 			if(!Children[i]->IsVisible())
 				continue;
 
-			Children[i]->PerformLayout();
+			Children[i]->UpdateLayout();
 
 			if(Out.x < Children[i]->GetPosition().x + Children[i]->GetSize().x)
 				Out.x = Children[i]->GetPosition().x + Children[i]->GetSize().x;
@@ -549,6 +718,7 @@ public:
 	{
 		this->Skin = Skin;
 		OnSkinChange();
+		InvalidateLayout();
 	};
 
 	/*!
@@ -583,8 +753,6 @@ public:
 
 	void Update(const Vector2 &ParentPosition)
 	{
-		PerformLayout();
-
 		for(unsigned long i = 0; i < Children.size(); i++)
 		{
 			Children[i]->Update(ParentPosition + PositionValue);
@@ -676,116 +844,741 @@ protected:
 	std::string FontName;
 	bool IsPasswordValue;
 
-	Vector2 LastSizeValue;
+	Vector2 LastSizeValue;
+
+	//!<The text as displayed (masked when this is a password), edited along with Text
+	std::wstring DisplayText;
+	//!<Pen position after each displayed character, from the start of the text
+	std::vector<float> PrefixAdvances;
+	//!<Font Size the Prefix Advances were calculated with
+	unsigned long PrefixAdvancesFontSize;
+
+	//!<Time since the cursor last started blinking
+	sf::Clock CursorBlinkClock;
+	//!<Whether the blinking cursor is currently shown
+	bool CursorVisible;
+
+	/*!
+	*	Shows the cursor and restarts its blinking, such as after it moved
+	*/
+	void ResetCursorBlink();
+
+	/*!
+	*	Rebuilds DisplayText and the Prefix Advances after the whole text changed
+	*/
+	void RefreshDisplayText();
+
+	/*!
+	*	Recalculates the Prefix Advances after DisplayText changed
+	*	\param From the index of the first character that changed
+	*/
+	void UpdatePrefixAdvances(unsigned long From);
+
+	/*!
+	*	\return how far left of the pen the first visible character's glyph starts
+	*/
+	float GetVisibleTextLeft() const;
+
+	/*!
+	*	\param Start the index of the first character
+	*	\param Count the amount of characters
+	*	\return the width of a range of the displayed text
+	*/
+	float GetTextWidth(unsigned long Start, unsigned long Count) const;
+
+	/*!
+	*	\param Start the index of the first character
+	*	\param Width the available width
+	*	\return how many characters starting at Start are narrower than Width
+	*/
+	unsigned long FitCharacters(unsigned long Start, float Width) const;
+
+	void OnMouseJustPressedTextBox(UIPanel *This, const InputCenter::MouseButtonInfo &o);
+	void OnKeyJustPressedTextBox(UIPanel *This, const InputCenter::KeyInfo &o);
+	void OnCharacterEnteredTextBox(UIPanel *This);
+	void OnSkinChange();
+	Rect GetDrawArea();
+	unsigned long GetTimeUntilUpdate();
+public:
+	/*!
+	*	The Text Box's Font Size
+	*/
+	unsigned long FontSize;
+
+	UITextBox(UIManager *Manager);
+	void PerformLayout();
+	void Update(const Vector2 &ParentPosition);
+	void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
+
+	/*!
+	*	\return whether this textbox is a password
+	*/
+	bool IsPassword()
+	{
+		return IsPasswordValue;
+	};
+
+	/*!
+	*	Sets whether this textbox is a password
+	*	\param Value whether this textbox is a password
+	*/
+	void SetPassword(bool Value)
+	{
+		IsPasswordValue = Value;
+
+		RefreshDisplayText();
+		Damage();
+	};
+
+	/*!
+	*	\return the Text of this Text Box
+	*/
+	const sf::String &GetText() const
+	{
+		return Text;
+	};
+
+	/*!
+	*	Sets the Text of this Text Box
+	*	\param Text the new Text
+	*/
+	void SetText(const sf::String &Text)
+	{
+		this->Text = Text;
+		CursorPosition = TextOffset = 0;
+
+		RefreshDisplayText();
+		InvalidateLayout();
+	};
+};
+
+/*!
+*	UI Text Editor Element
+*	Multi-line text editing meant for large documents (such as config files or scripts)
+*	\note Will AutoSize outwards vertically
+*	\note Must have a ScrollableFrame parent
+*	\note Lines are wrapped lazily, so lines that were never visible count as a single row
+*/
+class UITextEditor : public UIPanel
+{
+protected:
+	/*!
+	*	A line of text, ended by a newline or the end of the text
+	*/
+	class Line
+	{
+	public:
+		//!<Position of the first character before the line gap, or its distance from the end of the text after the line gap
+		unsigned long Start;
+		//!<Positions (relative to Start) at which each row after the first starts
+		std::vector<unsigned long> Wraps;
+		//!<Amount of rows, as counted in RowTree, which is always 1 while WrapDirty
+		unsigned long RowCount;
+		//!<Whether Wraps is out of date
+		bool WrapDirty;
+
+		Line() : Start(0), RowCount(1), WrapDirty(true) {};
+	};
+
+	SuperSmartPointer<sf::Texture> BackgroundTexture;
+	Rect TextureRect;
+	unsigned long Padding;
+	float LineSpacing;
+	GapBuffer Text;
+	//!<Lines, with a gap at the last edited line so edits don't move the lines after it or change their Start
+	std::vector<Line> Lines;
+	//!<The line gap is [LineGapStart, LineGapEnd) inside Lines
+	unsigned long LineGapStart, LineGapEnd;
+	//!<Fenwick tree of each slot of Lines' RowCount (none inside the line gap), to find rows by height without visiting every line
+	std::vector<long> RowTree;
+	unsigned long TotalRows;
+	//!<Width and Font Size the lines were wrapped with
+	float WrapWidth;
+	unsigned long WrapFontSize;
+	unsigned long CursorPosition;
+	//!<Time since the cursor last started blinking
+	sf::Clock CursorBlinkClock;
+	//!<Whether the blinking cursor is currently shown
+	bool CursorVisible;
+	//!<Scratch space for getting text out of the buffer
+	std::wstring TextCache;
+
+	/*!
+	*	Shows the cursor and restarts its blinking, such as after it moved
+	*/
+	void ResetCursorBlink();
+
+	/*!
+	*	\param Index the index of a line
+	*	\return the line's position inside Lines
+	*/
+	unsigned long GetLineSlot(unsigned long Index) const
+	{
+		return Index < LineGapStart ? Index : Index + (LineGapEnd - LineGapStart);
+	};
+
+	/*!
+	*	\param Index the index of a line
+	*	\return the position of the line's first character
+	*/
+	unsigned long GetLineStart(unsigned long Index) const;
+
+	/*!
+	*	\param Index the index of a line
+	*	\return the amount of characters in the line, not counting the newline
+	*/
+	unsigned long GetLineLength(unsigned long Index) const;
+
+	/*!
+	*	Moves the line gap so it starts at a line
+	*	\param Index the index of the line
+	*	\note Must be called before changing the text, since lines after the gap store their Start from the end of the text
+	*/
+	void MoveLineGap(unsigned long Index);
+
+	/*!
+	*	Makes the line gap large enough for some lines
+	*	\param Count the amount of lines
+	*/
+	void ReserveLineGap(unsigned long Count);
+
+	/*!
+	*	Moves a line from one slot of Lines to another
+	*/
+	void MoveLineSlot(unsigned long From, unsigned long To);
+
+	/*!
+	*	Adds an unwrapped line at the start of the line gap
+	*	\param Start the position of its first character
+	*/
+	void InsertLine(unsigned long Start);
+
+	/*!
+	*	\param Position a position in the text
+	*	\return the index of the line containing that position
+	*/
+	unsigned long FindLine(unsigned long Position) const;
+
+	/*!
+	*	Recalculates where a line wraps
+	*	\param Index the index of the line
+	*/
+	void WrapLine(unsigned long Index);
+
+	/*!
+	*	Rebuilds RowTree from every line's RowCount, after Lines was reallocated
+	*/
+	void RebuildRowTree();
+
+	/*!
+	*	Adds to the amount of rows of a slot of Lines in RowTree
+	*/
+	void AddRowsToSlot(unsigned long Slot, long Delta);
+
+	/*!
+	*	Changes the RowCount of a line
+	*	\param Index the index of the line
+	*	\param Count the new amount of rows
+	*/
+	void SetLineRowCount(unsigned long Index, unsigned long Count);
+
+	/*!
+	*	\param Index the index of a line
+	*	\return the amount of rows before that line
+	*/
+	unsigned long GetRowsBefore(unsigned long Index) const;
+
+	/*!
+	*	\param Row the index of a row
+	*	\param RowInLine receives the index of the row inside the line
+	*	\return the index of the line containing that row, clamped to the last line
+	*/
+	unsigned long FindLineAtRow(unsigned long Row, unsigned long &RowInLine) const;
+
+	/*!
+	*	Gets which characters are in a row
+	*	\param Index the index of the line
+	*	\param Row the index of the row inside the line
+	*	\param Start receives the position of the first character
+	*	\param Count receives the amount of characters
+	*/
+	void GetRowRange(unsigned long Index, unsigned long Row, unsigned long &Start, unsigned long &Count) const;
+
+	/*!
+	*	\param Start the position of the first character of a row
+	*	\param Count the amount of characters to measure
+	*	\return the width of those characters
+	*/
+	float GetTextWidth(unsigned long Start, unsigned long Count) const;
+
+	/*!
+	*	\param Start the position of the first character of a row
+	*	\param Count the amount of characters in the row
+	*	\param x a distance from the start of the row
+	*	\return the position closest to that distance
+	*/
+	unsigned long GetPositionAt(unsigned long Start, unsigned long Count, float x) const;
+
+	/*!
+	*	Gets the row the cursor is on
+	*	\param Index receives the index of the line
+	*	\param Row receives the index of the row inside the line
+	*/
+	void GetCursorRow(unsigned long &Index, unsigned long &Row);
+
+	/*!
+	*	Gets the rows inside the area we're visible in
+	*	\param First receives the index of the first row
+	*	\param Last receives the index of the last row
+	*	\return whether any row is visible
+	*/
+	bool GetVisibleRows(unsigned long &First, unsigned long &Last);
+
+	void OnMouseJustPressedTextEditor(UIPanel *This, const InputCenter::MouseButtonInfo &o);
+	void OnKeyJustPressedTextEditor(UIPanel *This, const InputCenter::KeyInfo &o);
+	void OnCharacterEnteredTextEditor(UIPanel *This);
+	void OnSkinChange();
+	unsigned long GetTimeUntilUpdate();
+public:
+	/*!
+	*	The Text Editor's Font Size
+	*/
+	unsigned long FontSize;
+
+	UITextEditor(UIManager *Manager);
+	void PerformLayout();
+	void Update(const Vector2 &ParentPosition);
+	void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
+
+	/*!
+	*	\return the Text of this Text Editor
+	*	\note Copies the whole text, so avoid calling this often on large documents
+	*/
+	sf::String GetText() const;
+
+	/*!
+	*	Sets the Text of this Text Editor
+	*	\param Text the new Text
+	*/
+	void SetText(const sf::String &Text);
+
+	/*!
+	*	\return the amount of characters
+	*/
+	unsigned long GetLength() const
+	{
+		return Text.GetSize();
+	};
+
+	/*!
+	*	\return the amount of lines
+	*/
+	unsigned long GetLineCount() const
+	{
+		return Lines.size() - (LineGapEnd - LineGapStart);
+	};
+
+	/*!
+	*	Inserts text, updating only the lines it touches
+	*	\param Position where to insert it
+	*	\param String the text to insert
+	*/
+	void Insert(unsigned long Position, const std::wstring &String);
+
+	/*!
+	*	Removes text, updating only the lines it touches
+	*	\param Position the position of the first character
+	*	\param Count the amount of characters
+	*/
+	void Erase(unsigned long Position, unsigned long Count);
+
+	/*!
+	*	\return the position of the cursor
+	*/
+	unsigned long GetCursorPosition() const
+	{
+		return CursorPosition;
+	};
+
+	/*!
+	*	Moves the cursor
+	*	\param Position the new position
+	*/
+	void SetCursorPosition(unsigned long Position)
+	{
+		CursorPosition = Position < Text.GetSize() ? Position : Text.GetSize();
+
+		ResetCursorBlink();
+	};
+};
+
+#define SCROLLBAR_DRAGGABLE_SIZE 15
+
+class UIScrollbar;
+
+/*!
+*	UI Scrollable Frame Element
+*	\note Will not Autoresize
+*	\note Includes SCROLLBAR_DRAGGABLE_SIZE Pixels on the Size's Width should scrolling be required
+*/
+class UIScrollableFrame : public UIPanel
+{
+	friend class UIList;
+protected:
+	SuperSmartPointer<UIScrollbar> VerticalScroll, HorizontalScroll;
+	//!<Size of the children as of the last layout
+	Vector2 ChildrenSizeValue;
+	//!<Top of each translated child's draw area and the child's index, sorted by top, as of the last layout
+	std::vector<std::pair<float, unsigned long> > ChildOrder;
+	//!<Height of the tallest translated child's draw area, as of the last layout
+	float ChildMaxHeight;
+
+	void OnSkinChange();
+	void MakeScrolls();
+	bool IsTranslatedChild(const UIPanel *Child) const;
+	bool GetContentClipRect(Rect &Out);
+
+	/*!
+	*	Finds the translated children that may be visible at a translation without visiting the others
+	*	\param Translation the translation
+	*	\param Out the indices of those children, in draw order
+	*	
+ote Returns every translated child while our layout is out of date
+	*/
+	void GetVisibleChildren(const Vector2 &Translation, std::vector<unsigned long> &Out);
+
+	/*!
+	*	Moves the children that were or will be visible in the hit testing index after our translation changes
+	*	\param PreviousTranslation the translation they were indexed at
+	*/
+	void ScrollChildren(const Vector2 &PreviousTranslation);
+public:
+	UIScrollableFrame(UIManager *Manager) : UIPanel(Manager), ChildMaxHeight(0)
+	{
+		OnConstructed();
+	};
+
+	void PerformLayout();
+	void Update(const Vector2 &ParentPosition);
+	void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
+};
+
+/*!
+*	Provides the items of a UI List, so they don't need to be copied into it
+*	\note Call InvalidateLayout on the list whenever the items change
+*	\sa UIList::SetDataSource
+*/
+class UIListDataSource
+{
+public:
+	virtual ~UIListDataSource() {};
+
+	/*!
+	*	\return the amount of items
+	*/
+	virtual unsigned long GetItemCount() = 0;
+
+	/*!
+	*	\param Index the index of an item
+	*	\return the text of that item
+	*	\note Only called for items that are visible or being measured
+	*/
+	virtual std::string GetItem(unsigned long Index) = 0;
+};
+
+/*!
+*	UI List Element
+*	\note Will AutoSize outwards vertically
+*	\note Must have a ScrollableFrame parent
+*/
+class UIList : public UIPanel
+{
+private:
+	SuperSmartPointer<sf::Texture> SelectorBackgroundTexture;
+	//!<Index of the item under the mouse, or -1
+	long HoveredItem;
+	//!<Where our items come from, or NULL to use Items
+	UIListDataSource *DataSource;
+	//!<Whether every row has the same height, so items are never measured
+	bool VirtualizedValue;
+	//!<Top of each row relative to our position, followed by the end of the last row, as of the last layout (when not virtualized)
+	std::vector<float> RowOffsets;
+
+	void OnSkinChange();
+	void OnItemClickCheck(UIPanel *Self);
+
+	/*!
+	*	\return the amount of rows we can draw, which may lag behind GetItemCount until the next layout
+	*/
+	unsigned long GetRowCount();
+
+	/*!
+	*	\param y a height relative to our position
+	*	\return the row whose area (including the space after it) contains that height, clamped to our rows
+	*	\note Must have at least one row
+	*/
+	unsigned long FindRow(float y);
+
+	/*!
+	*	\param y a height relative to our position
+	*	\return the item at that height, or -1
+	*/
+	long GetItemAt(float y);
+
+	/*!
+	*	Gets where a row is
+	*	\param Index the index of the row
+	*	\param Top receives the top of the row relative to our position
+	*	\param Height receives the height of the row
+	*/
+	void GetRowArea(unsigned long Index, float &Top, float &Height);
+public:
+	/*!
+	*	All items contained by this List, when there's no Data Source
+	*/
+	std::vector<std::string> Items;
+	/*!
+	*	The List's Font Size
+	*/
+	unsigned long FontSize;
+
+	/*!
+	*	(UIList Self, unsigned long ItemIndex)
+	*	\note OnItemMouseOver is emitted when the mouse moves onto a different item
+	*/
+	Signal2<UIList *, unsigned long> OnItemMouseOver, OnItemClick;
+
+	UIList(UIManager *Manager) : UIPanel(Manager), HoveredItem(-1), DataSource(NULL), VirtualizedValue(false), FontSize(16)
+	{
+		OnConstructed();
+		OnClick.Connect(this, &UIList::OnItemClickCheck);
+	};
+
+	/*!
+	*	Sets where our items come from
+	*	\param Source the data source (which we don't take ownership of), or NULL to use Items
+	*/
+	void SetDataSource(UIListDataSource *Source)
+	{
+		DataSource = Source;
+
+		InvalidateLayout();
+	};
+
+	/*!
+	*	\return our data source, or NULL if we're using Items
+	*/
+	UIListDataSource *GetDataSource()
+	{
+		return DataSource;
+	};
+
+	/*!
+	*	\return the amount of items in this list
+	*/
+	unsigned long GetItemCount()
+	{
+		return DataSource ? DataSource->GetItemCount() : Items.size();
+	};
+
+	/*!
+	*	\param Index the index of an item
+	*	\return the text of that item
+	*/
+	std::string GetItem(unsigned long Index)
+	{
+		return DataSource ? DataSource->GetItem(Index) : Items[Index];
+	};
+
+	/*!
+	*	Sets whether every row has the same height (that of a single line of text)
+	*	\param Value whether rows are uniform
+	*	\note Otherwise every item is measured whenever we're laid out, so this should be used for very large lists
+	*/
+	void SetVirtualized(bool Value)
+	{
+		if(VirtualizedValue == Value)
+			return;
+
+		VirtualizedValue = Value;
+
+		InvalidateLayout();
+	};
+
+	/*!
+	*	\return whether every row has the same height
+	*/
+	bool IsVirtualized() const
+	{
+		return VirtualizedValue;
+	};
+
+	void PerformLayout();
+	void Update(const Vector2 &ParentPosition);
+	void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
+};
+
+/*!
+*	UI Tree View Element
+*	\note Will AutoSize outwards vertically
+*	\note Must have a ScrollableFrame parent
+*	\note Children of a node may be added when it's first expanded, by handling OnRequestChildren
+*/
+class UITreeView : public UIPanel
+{
+public:
+	//!<Index of the hidden node that every top level node is a child of
+	static const unsigned long RootNode = 0;
+
+	/*!
+	*	UI Tree View Node
+	*/
+	class Node
+	{
+	public:
+		/*!
+		*	The Node's Caption
+		*/
+		std::string Caption;
+		/*!
+		*	The Node's User Data
+		*/
+		void *UserData;
+		//!<Index of the parent, first child, last child and next sibling, or -1
+		long Parent, FirstChild, LastChild, NextSibling;
+		//!<Amount of ancestors, not counting the root node
+		unsigned long Depth;
+		//!<Whether this node may have children, even if they weren't added yet
+		bool HasChildren;
+		bool Expanded;
+		//!<Whether OnRequestChildren was already emitted for this node
+		bool ChildrenRequested;
+
+		Node() : UserData(NULL), Parent(-1), FirstChild(-1), LastChild(-1), NextSibling(-1), Depth(0), HasChildren(false),
+			Expanded(false), ChildrenRequested(false) {};
+	};
+private:
+	SuperSmartPointer<sf::Texture> BackgroundTexture, CellTexture, ArrowTexture, FolderTexture, FileTexture;
+	Rect TextureRect;
+	float RowHeight, Indent;
+	Vector2 TextOffset;
+	std::vector<Node> Nodes;
+	//!<Every node whose ancestors are all expanded, in the order they're shown
+	std::vector<unsigned long> VisibleRows;
+	//!<Whether nodes were added to the middle of VisibleRows, which is then rebuilt before it's next used
+	bool VisibleRowsDirty;
+	//!<Row under the mouse, or -1
+	long HoveredRow;
+	//!<Selected node, or -1
+	long SelectedNode;
+
+	void OnSkinChange();
+	void OnRowClick(UIPanel *Self);
+
+	/*!
+	*	\param y a height relative to our position
+	*	\return the row at that height, or -1
+	*/
+	long GetRowAt(float y);
+
+	/*!
+	*	\param Index the index of a node
+	*	\return the row showing that node, or -1 if it isn't visible
+	*/
+	long FindRow(unsigned long Index);
+
+	/*!
+	*	Appends the rows of the visible descendants of a node
+	*	\param Index the index of the node
+	*	\param Out the rows to append to
+	*/
+	void AppendVisibleRows(unsigned long Index, std::vector<unsigned long> &Out);
 
-	void OnMouseJustPressedTextBox(UIPanel *This, const InputCenter::MouseButtonInfo &o);
-	void OnKeyJustPressedTextBox(UIPanel *This, const InputCenter::KeyInfo &o);
-	void OnCharacterEnteredTextBox(UIPanel *This);
-	void OnSkinChange();
+	/*!
+	*	Rebuilds VisibleRows if nodes were added in the middle of it
+	*/
+	void RefreshVisibleRows();
+
+	/*!
+	*	Expands or collapses a node we already found the row of
+	*	\param Index the index of the node
+	*	\param Row the row showing the node, or -1 if it isn't visible
+	*	\param Value whether to expand it
+	*/
+	void SetExpanded(unsigned long Index, long Row, bool Value);
 public:
 	/*!
-	*	The Text Box's Font Size
+	*	The Tree's Font Size
 	*/
 	unsigned long FontSize;
 
-	UITextBox(UIManager *Manager);
-	void PerformLayout();
-	void Update(const Vector2 &ParentPosition);
-	void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
+	/*!
+	*	(UITreeView Self, unsigned long NodeIndex)
+	*	\note OnRequestChildren is emitted the first time a node with HasChildren set is expanded, and should add its children
+	*/
+	Signal2<UITreeView *, unsigned long> OnRequestChildren, OnNodeClick, OnNodeExpanded, OnNodeCollapsed;
+
+	UITreeView(UIManager *Manager);
 
 	/*!
-	*	\return whether this textbox is a password
+	*	Adds a node
+	*	\param Parent the index of the parent node (or RootNode)
+	*	\param Caption the Node's Caption
+	*	\param HasChildren whether the node can be expanded
+	*	\param UserData the Node's User Data (Optional)
+	*	\return the index of the new node
 	*/
-	bool IsPassword()
-	{
-		return IsPasswordValue;
-	};
+	unsigned long AddNode(unsigned long Parent, const std::string &Caption, bool HasChildren = false, void *UserData = NULL);
 
 	/*!
-	*	Sets whether this textbox is a password
-	*	\param Value whether this textbox is a password
+	*	Removes every node
 	*/
-	void SetPassword(bool Value)
-	{
-		IsPasswordValue = Value;
-	};
+	void ClearNodes();
 
 	/*!
-	*	\return the Text of this Text Box
+	*	Expands or collapses a node
+	*	\param Index the index of the node
+	*	\param Value whether to expand it
 	*/
-	const sf::String &GetText() const
+	void SetExpanded(unsigned long Index, bool Value)
 	{
-		return Text;
+		SetExpanded(Index, FindRow(Index), Value);
 	};
 
 	/*!
-	*	Sets the Text of this Text Box
-	*	\param Text the new Text
+	*	\param Index the index of a node
+	*	\return the node
+	*	\note Adding nodes invalidates references to nodes
 	*/
-	void SetText(const sf::String &Text)
+	const Node &GetNode(unsigned long Index) const
 	{
-		this->Text = Text;
-		CursorPosition = TextOffset = 0;
+		return Nodes[Index];
 	};
-};
-
-#define SCROLLBAR_DRAGGABLE_SIZE 15
-
-class UIScrollbar;
-
-/*!
-*	UI Scrollable Frame Element
-*	\note Will not Autoresize
-*	\note Includes SCROLLBAR_DRAGGABLE_SIZE Pixels on the Size's Width should scrolling be required
-*/
-class UIScrollableFrame : public UIPanel
-{
-	friend class UIList;
-protected:
-	SuperSmartPointer<UIScrollbar> VerticalScroll, HorizontalScroll;
 
-	void OnSkinChange();
-	void MakeScrolls();
-public:
-	UIScrollableFrame(UIManager *Manager) : UIPanel(Manager)
+	/*!
+	*	\return the amount of nodes, including the root node
+	*/
+	unsigned long GetNodeCount() const
 	{
-		OnConstructed();
+		return Nodes.size();
 	};
 
-	void Update(const Vector2 &ParentPosition);
-	void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
-};
-
-/*!
-*	UI List Element
-*	\note Will AutoSize outwards vertically
-*	\note Must have a ScrollableFrame parent
-*/
-class UIList : public UIPanel
-{
-private:
-	SuperSmartPointer<sf::Texture> SelectorBackgroundTexture;
-	void OnSkinChange();
-	void OnItemClickCheck(UIPanel *Self);
-public:
-	/*!
-	*	All items contained by this List
-	*/
-	std::vector<std::string> Items;
 	/*!
-	*	The List's Font Size
+	*	\return the amount of rows currently shown
 	*/
-	unsigned long FontSize;
+	unsigned long GetRowCount()
+	{
+		RefreshVisibleRows();
+
+		return VisibleRows.size();
+	};
 
 	/*!
-	*	(UIList Self, unsigned long ItemIndex)
+	*	\return the selected node, or -1
 	*/
-	Signal2<UIList *, unsigned long> OnItemMouseOver, OnItemClick;
-
-	UIList(UIManager *Manager) : UIPanel(Manager), FontSize(16)
+	long GetSelectedNode() const
 	{
-		OnConstructed();
-		OnClick.Connect(this, &UIList::OnItemClickCheck);
+		return SelectedNode;
 	};
 
 	void PerformLayout();
@@ -841,7 +1634,12 @@ public:
 	*/
 	void SetChecked(bool Value)
 	{
-		Checked = Value;
+		if(Checked != Value)
+		{
+			Checked = Value;
+
+			Damage();
+		};
 
 		if(Checked)
 		{
@@ -917,6 +1715,8 @@ public:
 		Out.Index = Items.size();
 
 		Items.push_back(Out);
+
+		InvalidateLayout();
 	};
 
 	/*!
@@ -1037,6 +1837,8 @@ public:
 	void AddItem(const Item &TheItem)
 	{
 		Items.push_back(TheItem);
+
+		InvalidateLayout();
 	};
 };
 
@@ -1047,17 +1849,30 @@ public:
 */
 class UISprite : public UIPanel
 {
+private:
+	//!<Whether the size and scale still have to be fit to the texture, once it has a size
+	bool FitPending;
+
+	void FitTexture();
 public:
 	/*!
 	*	The Element's Sprite
 	*/
 	Sprite TheSprite;
 
-	UISprite(UIManager *Manager) : UIPanel(Manager)
+	UISprite(UIManager *Manager) : UIPanel(Manager), FitPending(false)
 	{
 		OnConstructed();
 	};
 
+	/*!
+	*	Sets the texture and fits the sprite to it
+	*	\param Texture the texture, which may still be loading (0x0)
+	*	\note If the element has no size it takes the texture's size, otherwise the texture is scaled to the element's size
+	*	\note The sprite is fit on the next Update. A texture that is still loading isn't drawn, and is fit once it's uploaded
+	*/
+	void SetTexture(SuperSmartPointer<sf::Texture> Texture);
+
 	void PerformLayout();
 	void Update(const Vector2 &ParentPosition);
 	void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
@@ -1129,6 +1944,17 @@ class UITooltip : public UIPanel
 private:
 	//Source Panel that triggered this Tooltip
 	SuperSmartPointer<UIPanel> Source;
+	//Text we last performed layout with
+	sf::String LayoutText;
+
+	/*!
+	*	Gets the area the tooltip would be drawn to
+	*	\param Position the Mouse's position
+	*	\param Renderer the Renderer we draw to
+	*	\param Out the area
+	*	\return whether the tooltip is shown at all
+	*/
+	bool GetTooltipArea(const Vector2 &Position, sf::RenderWindow *Renderer, Rect &Out);
 
 	UITooltip(UIManager *Manager) : UIPanel(Manager)
 	{
@@ -1167,6 +1993,7 @@ protected:
 
 	void OnSkinChange();
 	void CheckClosePressed(UIPanel *This);
+	Rect GetDrawArea();
 public:
 	/*!
 	*	The Window's Title
@@ -1232,6 +2059,7 @@ namespace UITextAlignment
 class UIText : public UIPanel
 {
 	std::vector<sf::String> Strings;
+	std::vector<TextLineSpan> Lines;
 	sf::String Text;
 
 protected:
@@ -1282,6 +2110,14 @@ public:
 		return Strings;
 	};
 
+	/*!
+	*	\return the formatted text lines, as spans of the text
+	*/
+	const std::vector<TextLineSpan> &GetLines()
+	{
+		return Lines;
+	};
+
 	void Update(const Vector2 &ParentPosition);
 	void Draw(const Vector2 &ParentPosition, sf::RenderWindow *Renderer);
 };
@@ -1394,6 +2230,46 @@ public:
 	SuperSmartPointer<UIPanel> FindPanelByName(const std::string &Name);
 };
 
+//!<How often a tween advances while the UI is otherwise idle, in milliseconds
+#define UIANIMATION_FRAME_TIME 16
+
+namespace AnimationProperty
+{
+	enum
+	{
+		Position = 0,
+		Size,
+		Alpha,
+		//!<Advances an AnimatedSprite the element draws
+		SpriteFrame
+	};
+};
+
+/*!
+*	An active animation
+*/
+class UIAnimation
+{
+public:
+	AnimationHandle Handle;
+	//!<One of AnimationProperty
+	unsigned long Property;
+	UIPanel *Panel;
+	//!<The sprite to advance, for SpriteFrame
+	AnimatedSprite *Sprite;
+	//!<Values to interpolate between (Alpha only uses x). From is read from the element once the delay is over
+	Vector2 From, To;
+	//!<When the animation starts, in milliseconds
+	unsigned long long StartTime;
+	unsigned long Duration;
+	//!<One of EasingCurve
+	unsigned long Curve;
+	bool Started;
+
+	UIAnimation() : Handle(0), Property(AnimationProperty::Position), Panel(NULL), Sprite(NULL), StartTime(0), Duration(0),
+		Curve(EasingCurve::Linear), Started(false) {};
+};
+
 /*!
 *	UI Manager
 *	Handles all input and processing and rendering of UI Elements
@@ -1403,22 +2279,46 @@ class UIManager
 	friend class UIPanel;
 	friend class UIMenu;
 	friend class UILayout;
+public:
+	/*!
+	*	Damage tracking statistics, accumulated until ResetDamageStats
+	*/
+	class DamageStats
+	{
+	public:
+		//!<Frames that had something to redraw
+		unsigned long DrawnFrames;
+		//!<Frames skipped because nothing changed
+		unsigned long SkippedFrames;
+		//!<Sum of the area of every redraw, in pixels
+		unsigned long long RedrawnPixels;
+
+		DamageStats() : DrawnFrames(0), SkippedFrames(0), RedrawnPixels(0) {};
+	};
 private:
 
 	class ElementInfo
 	{
 	public:
+		UIManager *Manager;
 		SuperSmartPointer<UIPanel> Panel;
 		unsigned long DrawOrder;
 
-		~ElementInfo()
-		{
-			Panel.Dispose();
-		};
+		ElementInfo(UIManager *TheManager) : Manager(TheManager), DrawOrder(0) {};
+		~ElementInfo();
 	};
 
 	unsigned long DrawOrderCounter;
 
+	typedef std::map<unsigned long, ElementInfo *> ZOrderMap;
+	//!<Every element sorted by Draw Order, back to front
+	ZOrderMap ZOrder;
+
+	/*!
+	*	Renumbers the Draw Orders from 1 once the counter has grown too far past the amount of elements
+	*/
+	void CompactDrawOrder();
+
 	typedef std::map<StringID, SuperSmartPointer<ElementInfo> > ElementMap;
 	ElementMap Elements;
 
@@ -1432,6 +2332,33 @@ private:
 	Vector4 DefaultFontColor, DefaultSecondaryFontColor;
 	unsigned long DefaultFontSize;
 
+	//!<Atlas containing every texture referenced by the current skin
+	TextureAtlas SkinAtlas;
+	//!<Textures shared between all elements
+	TextureCache Textures;
+
+	//!<Active animations, all advanced in one pass by UpdateAnimations
+	std::vector<UIAnimation> Animations;
+	//!<Animations that finished during the last UpdateAnimations, kept around so its storage is reused
+	std::vector<UIAnimation> FinishedAnimations;
+	AnimationHandle NextAnimationHandle;
+	sf::Clock AnimationClock;
+
+	/*!
+	*	\return the current time for animations, in milliseconds
+	*/
+	unsigned long long GetAnimationTime() const;
+
+	/*!
+	*	Advances every animation, then emits OnAnimationFinished for the ones that finished
+	*/
+	void UpdateAnimations();
+
+	/*!
+	*	\return how long until an animation needs to advance, in milliseconds, or InputCenter::WaitForever
+	*/
+	unsigned long GetTimeUntilNextAnimation() const;
+
 	void OnMouseJustPressedPriv(const InputCenter::MouseButtonInfo &o);
 	void OnMousePressedPriv(const InputCenter::MouseButtonInfo &o);
 	void OnMouseReleasedPriv(const InputCenter::MouseButtonInfo &o);
@@ -1444,9 +2371,94 @@ private:
 	void RegisterInput();
 	void UnRegisterInput();
 
-	void RecursiveFindFocusedElement(const Vector2 &ParentPosition, UIPanel *p, UIPanel *&FoundElement);
+	void RecursiveFindFocusedElement(UIPanel *p, UIPanel *&FoundElement);
+
+	/*!
+	*	Hit testing index entry
+	*/
+	class HitTestEntry
+	{
+	public:
+		UIPanel *Panel;
+		//!<Absolute area in which the Panel can be hit, already restricted by its parents and clip rect
+		Rect Bounds;
+		//!<Draw Order of the Panel's root element
+		unsigned long DrawOrder;
+		//!<Pre-order index of the Panel in its root's hierarchy, later elements are on top
+		unsigned long Order;
+		//!<Whether the entry is in HitTestCells, which it isn't when it can't be hit anywhere
+		bool Indexed;
+	};
+
+	typedef std::map<std::pair<long, long>, std::vector<unsigned long> > HitTestCellMap;
+	//!<Uniform grid of HitTestEntries, covering the Owner's area
+	HitTestCellMap HitTestCells;
+	std::vector<HitTestEntry> HitTestEntries;
+	Vector2 HitTestAreaSize;
+	bool HitTestIndexDirty;
+	//!<Elements whose hierarchies must be re-inserted in the hit testing index, when it isn't being rebuilt anyway
+	std::vector<UIPanel *> HitTestMovedElements;
+
+	/*!
+	*	Rebuilds the list of root elements, sorted back to front, if it's out of date
+	*/
+	void RefreshDrawOrderCache();
+	void BuildHitTestIndex();
+	void AddToHitTestIndex(UIPanel *p, const Rect &ParentBounds, unsigned long DrawOrder, unsigned long &Order);
+
+	/*!
+	*	\return whether an element has an entry in the hit testing index
+	*/
+	bool HasHitTestEntry(UIPanel *p) const;
+
+	/*!
+	*	Calculates the bounds of a hit testing entry and adds it to the cells it covers
+	*	\param Index the entry's index
+	*	\param ParentBounds the bounds of its parent's entry
+	*	\return the entry's bounds
+	*/
+	Rect IndexHitTestEntry(unsigned long Index, const Rect &ParentBounds);
+
+	/*!
+	*	Removes a hit testing entry from the cells it covers
+	*/
+	void UnindexHitTestEntry(unsigned long Index);
+
+	/*!
+	*	Removes the hit testing entries of an element and its children from the cells they cover and adds them again with their current bounds
+	*/
+	void ReindexHitTestEntries(UIPanel *p, const Rect &ParentBounds);
+
+	/*!
+	*	Finds the top-most element under a position using the hit testing index
+	*	\param Position the absolute position
+	*	\return the element or NULL
+	*	\note Does not handle Input Blockers
+	*/
+	UIPanel *HitTest(const Vector2 &Position);
+
+	/*!
+	*	Rebuilds the hit testing index if it's out of date, or re-inserts the elements that moved
+	*/
+	void RefreshHitTestIndex();
+
+	//!<Element under the mouse as of the last RefreshMouseOver
+	SuperSmartPointer<UIPanel> MouseOverElementValue;
+	//!<MouseOverElementValue and its parents, deepest first
+	std::vector<SuperSmartPointer<UIPanel> > MouseOverChain;
+	//!<Mouse position as of the last RefreshMouseOver
+	Vector2 MouseOverPosition;
+	bool MouseOverDirty;
 
-	void RemoveMenuFuture(std::vector<unsigned char> &Stream);
+	UIPanel *FindMouseOverElement();
+
+	/*!
+	*	Finds the element under the mouse if the mouse moved or the hit testing index changed,
+	*	and emits OnMouseEnter/OnMouseLeave for the elements that changed
+	*/
+	void RefreshMouseOver();
+
+	void RemoveMenuFuture();
 
 	sf::RenderWindow *Owner;
 	InputCenter *Input;
@@ -1455,18 +2467,60 @@ private:
 	LayoutMap Layouts;
 
 	bool DrawOrderCacheDirty;
+	//!<Root elements sorted by Draw Order, back to front
 	std::vector<ElementInfo *> DrawOrderCache;
 
+	//!<Amount of PerformLayout calls made by layout passes since the last Update
+	unsigned long LayoutCount;
+
+	bool DamageTrackingValue;
+	//!<Area changed since the last Draw
+	Rect DamageRect;
+	bool HasDamage;
+	//!<Area changed before the last Draw, which is missing from the back buffer after swapping
+	Rect PreviousDamageRect;
+	bool HasPreviousDamage;
+	//!<Area returned by the last GetRedrawArea that hasn't been drawn yet
+	Rect RedrawRect;
+	bool RedrawPending;
+	//!<State of things drawn outside of any element's area as of the last GetRedrawArea
+	UIPanel *DamageInputBlocker;
+	Vector2 DamageOwnerSize;
+	Rect DamageTooltipArea;
+	bool DamageTooltipShown;
+	sf::String DamageTooltipText;
+	DamageStats DamageCounters;
+
+	/*!
+	*	\return the visible element blocking input, if any
+	*/
+	SuperSmartPointer<UIPanel> FindInputBlocker();
+
 	void CopyElementsToLayout(SuperSmartPointer<UILayout> TheLayout, Json::Value &Elements, UIPanel *Parent, const std::string &ParentElementName);
 public:
 
-	UIManager(sf::RenderWindow *TheOwner, InputCenter *TheInput) : Owner(TheOwner), Input(TheInput), DrawOrderCounter(0)
+	UIManager(sf::RenderWindow *TheOwner, InputCenter *TheInput) : Owner(TheOwner), Input(TheInput), DrawOrderCounter(0), LayoutCount(0),
+		DrawOrderCacheDirty(true), HitTestIndexDirty(true), MouseOverDirty(true), DamageTrackingValue(false), HasDamage(false),
+		HasPreviousDamage(false), RedrawPending(false), DamageInputBlocker(NULL), DamageTooltipShown(false), NextAnimationHandle(1)
 	{
 		Tooltip.Reset(new UITooltip(this));
 		RegisterInput();
 	};
 
-	~UIManager() { UnRegisterInput(); Clear(); };
+	~UIManager()
+	{
+		UnRegisterInput();
+		Clear();
+
+		//Destroy it while the animation lists it unregisters from still exist
+		Tooltip.Dispose();
+
+		if(SpriteBatch::Instance.GetAtlas() == &SkinAtlas)
+			SpriteBatch::Instance.SetAtlas(NULL);
+
+		//Our default font is about to go away
+		TextEngine::Instance.Clear();
+	};
 
 	/*!
 	*	\return the Renderer that owns this UI Manager
@@ -1492,9 +2546,119 @@ public:
 	/*!
 	*	Draws all visible Elements
 	*	\param Renderer the Renderer to draw to
+	*	\note When tracking damage, only the area from GetRedrawArea needs to be redrawn, so it should be scissored
 	*/
 	void Draw(sf::RenderWindow *Renderer);
 
+	/*!
+	*	Gets how long the UI can go without Update and Draw if no input arrives
+	*	\return the time in milliseconds, or InputCenter::WaitForever
+	*	\note Always 0 unless we're tracking damage, since we can't tell whether anything changed otherwise
+	*/
+	unsigned long GetTimeUntilUpdate();
+
+	/*!
+	*	Describes the retained draw commands of every visible root element, back to front
+	*	\return the description
+	*	\note Commands are recorded by Draw, so this is only meaningful after drawing at least once
+	*/
+	std::string DumpDrawCommands();
+
+	/*!
+	*	Animates a property of an element
+	*	\param Panel the element to animate
+	*	\param Property one of AnimationProperty, except SpriteFrame
+	*	\param To the value to animate to (Alpha only uses x)
+	*	\param Duration how long the animation takes, in milliseconds
+	*	\param Curve one of EasingCurve
+	*	\param Delay how long to wait before starting, in milliseconds
+	*	\return the animation's handle
+	*	\note Replaces any animation of the same property of that element
+	*/
+	AnimationHandle Animate(UIPanel *Panel, unsigned long Property, const Vector2 &To, unsigned long Duration,
+		unsigned long Curve = EasingCurve::Linear, unsigned long Delay = 0);
+
+	/*!
+	*	Plays an AnimatedSprite's current animation
+	*	\param Panel the element that draws the sprite, which is damaged whenever the frame changes
+	*	\param Sprite the sprite, which must outlive the animation
+	*	\return the animation's handle
+	*	\note Finishes once a non-repeating animation reaches its last frame
+	*/
+	AnimationHandle AnimateSprite(UIPanel *Panel, AnimatedSprite *Sprite);
+
+	/*!
+	*	Stops an animation where it is, without emitting OnAnimationFinished
+	*	\param Handle the animation's handle
+	*	\return whether it was active
+	*/
+	bool StopAnimation(AnimationHandle Handle);
+
+	/*!
+	*	Stops every animation of an element where it is, without emitting OnAnimationFinished
+	*	\param Panel the element
+	*/
+	void StopAnimations(UIPanel *Panel);
+
+	/*!
+	*	\return the amount of active animations
+	*/
+	unsigned long GetAnimationCount() const
+	{
+		return Animations.size();
+	};
+
+	/*!
+	*	Sets whether we track which areas changed so the UI can be drawn on demand
+	*	\param Value whether to track damage
+	*	\sa GetRedrawArea
+	*/
+	void SetDamageTracking(bool Value);
+
+	/*!
+	*	\return whether we track which areas changed
+	*/
+	bool IsDamageTracking() const
+	{
+		return DamageTrackingValue;
+	};
+
+	/*!
+	*	Marks an area as needing a redraw
+	*	\param Area the absolute area
+	*/
+	void AddDamage(const Rect &Area);
+
+	/*!
+	*	Marks the whole Owner as needing a redraw
+	*/
+	void DamageAll();
+
+	/*!
+	*	Checks whether anything must be redrawn
+	*	\param Out receives the area to redraw, in pixels from the top left of the Owner
+	*	\return false if nothing changed, in which case clearing, drawing, and displaying can be skipped
+	*	\note The area includes what changed before the previous Draw too, since a swapped back buffer is one frame behind
+	*	\note Always redraws everything when we're not tracking damage
+	*/
+	bool GetRedrawArea(Rect &Out);
+
+	/*!
+	*	\return the damage tracking statistics
+	*/
+	const DamageStats &GetDamageStats() const
+	{
+		return DamageCounters;
+	};
+
+	/*!
+	*	Resets the damage tracking statistics
+	*/
+	void ResetDamageStats()
+	{
+		DamageCounters = DamageStats();
+	};
+
 	/*!
 	*	Adds an UI element to this UI Manager
 	*	\param ID the UI Element's ID
@@ -1510,6 +2674,13 @@ public:
 	*/
 	void RemoveElement(StringID ID);
 
+	/*!
+	*	Draws an element on top of every other element and gives it priority for input
+	*	\param Element the element to raise
+	*	\note If the element has a parent, its root element is raised instead
+	*/
+	void BringToFront(UIPanel *Element);
+
 	/*!
 	*	Loads one or more Layouts from a Stream
 	*	Format is JSON:
@@ -1559,6 +2730,7 @@ public:
 
 	/*!
 	*	\return the element that has the mouse moving over
+	*	\note Only searches again if the mouse moved or the UI changed since the last call
 	*/
 	SuperSmartPointer<UIPanel> GetMouseOverElement();
 
@@ -1638,6 +2810,30 @@ public:
 	*/
 	void SetSkin(SuperSmartPointer<GenericConfig> Skin);
 
+	/*!
+	*	Gets a texture used by the current skin
+	*	\param Path the texture's file name
+	*	\return the cached texture, shared with the Skin's Texture Atlas if it is part of it
+	*/
+	SuperSmartPointer<sf::Texture> GetSkinTexture(const std::string &Path);
+
+	/*!
+	*	\return the Texture Cache shared by all elements
+	*/
+	TextureCache &GetTextureCache()
+	{
+		return Textures;
+	};
+
+	/*!
+	*	\return the amount of times elements were laid out during the last Update
+	*	\note Should be 0 while nothing changes
+	*/
+	unsigned long GetLayoutCount() const
+	{
+		return LayoutCount;
+	};
+
 	/*!
 	*	\return the UI Skin we are currently using
 	*/
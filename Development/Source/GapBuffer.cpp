@@ -0,0 +1,119 @@
+#include <vector>
+#include <string>
+#include <string.h>
+#include "GapBuffer.hpp"
+
+#define GAPBUFFER_MINIMUM_GAP 64
+
+void GapBuffer::MoveGap(unsigned long Position)
+{
+	if(Position == GapStart)
+		return;
+
+	unsigned long GapSize = GapEnd - GapStart;
+
+	if(Position < GapStart)
+	{
+		//Characters between Position and the gap move to after it
+		unsigned long Count = GapStart - Position;
+
+		memmove(&Buffer[GapEnd - Count], &Buffer[Position], Count * sizeof(wchar_t));
+	}
+	else
+	{
+		//Characters between the gap and Position move to before it
+		unsigned long Count = Position - GapStart;
+
+		memmove(&Buffer[GapStart], &Buffer[GapEnd], Count * sizeof(wchar_t));
+	};
+
+	GapStart = Position;
+	GapEnd = Position + GapSize;
+};
+
+void GapBuffer::ReserveGap(unsigned long Count)
+{
+	unsigned long GapSize = GapEnd - GapStart;
+
+	if(GapSize >= Count)
+		return;
+
+	//Grow geometrically, so appending one character at a time stays cheap
+	unsigned long Size = GetSize(), NewGapSize = Size > Count ? Size : Count;
+
+	if(NewGapSize < GAPBUFFER_MINIMUM_GAP)
+		NewGapSize = GAPBUFFER_MINIMUM_GAP;
+
+	unsigned long AfterGap = Buffer.size() - GapEnd;
+
+	Buffer.resize(Size + NewGapSize);
+
+	if(AfterGap)
+		memmove(&Buffer[Buffer.size() - AfterGap], &Buffer[GapEnd], AfterGap * sizeof(wchar_t));
+
+	GapEnd = GapStart + NewGapSize;
+};
+
+void GapBuffer::Insert(unsigned long Position, const wchar_t *Text, unsigned long Count)
+{
+	if(Count == 0)
+		return;
+
+	if(Position > GetSize())
+		Position = GetSize();
+
+	ReserveGap(Count);
+	MoveGap(Position);
+
+	memcpy(&Buffer[GapStart], Text, Count * sizeof(wchar_t));
+
+	GapStart += Count;
+};
+
+void GapBuffer::Erase(unsigned long Position, unsigned long Count)
+{
+	if(Position >= GetSize())
+		return;
+
+	if(Position + Count > GetSize())
+		Count = GetSize() - Position;
+
+	MoveGap(Position);
+
+	//Erased characters just become part of the gap
+	GapEnd += Count;
+};
+
+void GapBuffer::Get(unsigned long Position, unsigned long Count, std::wstring &Out) const
+{
+	Out.clear();
+
+	if(Position >= GetSize())
+		return;
+
+	if(Position + Count > GetSize())
+		Count = GetSize() - Position;
+
+	Out.reserve(Count);
+
+	//Up to two runs, one on each side of the gap
+	if(Position < GapStart)
+	{
+		unsigned long Before = GapStart - Position < Count ? GapStart - Position : Count;
+
+		Out.append(&Buffer[Position], Before);
+
+		Position += Before;
+		Count -= Before;
+	};
+
+	if(Count)
+		Out.append(&Buffer[Position + (GapEnd - GapStart)], Count);
+};
+
+void GapBuffer::SetText(const std::wstring &Text)
+{
+	Buffer.assign(Text.begin(), Text.end());
+
+	GapStart = GapEnd = Buffer.size();
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+/*!
+*	Gap Buffer
+*	Stores text with a gap at the last edit position, so edits near each other don't move the rest of the text
+*/
+class GapBuffer
+{
+private:
+	std::vector<wchar_t> Buffer;
+	//!<The gap is [GapStart, GapEnd) inside Buffer
+	unsigned long GapStart, GapEnd;
+
+	/*!
+	*	Moves the gap so it starts at a position
+	*	\param Position the position in the text
+	*/
+	void MoveGap(unsigned long Position);
+
+	/*!
+	*	Makes the gap large enough for some characters
+	*	\param Count the amount of characters
+	*/
+	void ReserveGap(unsigned long Count);
+public:
+	GapBuffer() : GapStart(0), GapEnd(0) {};
+
+	/*!
+	*	\return the amount of characters
+	*/
+	unsigned long GetSize() const
+	{
+		return Buffer.size() - (GapEnd - GapStart);
+	};
+
+	/*!
+	*	\param Index the position of a character
+	*	\return the character
+	*/
+	wchar_t operator[](unsigned long Index) const
+	{
+		return Index < GapStart ? Buffer[Index] : Buffer[Index + (GapEnd - GapStart)];
+	};
+
+	/*!
+	*	Inserts characters
+	*	\param Position where to insert them
+	*	\param Text the characters
+	*	\param Count the amount of characters
+	*/
+	void Insert(unsigned long Position, const wchar_t *Text, unsigned long Count);
+
+	/*!
+	*	Removes characters
+	*	\param Position the position of the first character
+	*	\param Count the amount of characters
+	*/
+	void Erase(unsigned long Position, unsigned long Count);
+
+	/*!
+	*	Copies characters out of the buffer
+	*	\param Position the position of the first character
+	*	\param Count the amount of characters
+	*	\param Out receives the characters
+	*/
+	void Get(unsigned long Position, unsigned long Count, std::wstring &Out) const;
+
+	/*!
+	*	Replaces all characters
+	*	\param Text the new text
+	*/
+	void SetText(const std::wstring &Text);
+};
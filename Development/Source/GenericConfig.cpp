@@ -115,6 +115,35 @@ void GenericConfig::SetValue(const char *SectionName, const char *ValueName, con
 	Sections[SectionName].Values[ValueName].Content = Content;
 };
 
+std::vector<std::string> GenericConfig::GetSectionNames()
+{
+	std::vector<std::string> Out;
+
+	for(SectionMap::iterator it = Sections.begin(); it != Sections.end(); it++)
+	{
+		Out.push_back(it->first);
+	};
+
+	return Out;
+};
+
+std::vector<std::string> GenericConfig::GetValueNames(const char *SectionName)
+{
+	std::vector<std::string> Out;
+
+	SectionMap::iterator it = Sections.find(SectionName);
+
+	if(it == Sections.end())
+		return Out;
+
+	for(Section::ValueMap::iterator vit = it->second.Values.begin(); vit != it->second.Values.end(); vit++)
+	{
+		Out.push_back(vit->first);
+	};
+
+	return Out;
+};
+
 std::string GenericConfig::Serialize()
 {
 	std::stringstream str;
@@ -59,4 +59,6 @@ public:
 	float GetFloat(const char *SectionName, const char *ValueName, float Default);
 	std::string GetString(const char *SectionName, const char *ValueName, const std::string &Default = "");
 	void SetValue(const char *SectionName, const char *ValueName, const char *Content);
+	std::vector<std::string> GetSectionNames();
+	std::vector<std::string> GetValueNames(const char *SectionName);
 };
@@ -12,6 +12,8 @@
 using namespace Gallant;
 #include "Input.hpp"
 
+const unsigned long InputCenter::WaitForever;
+
 InputCenter::InputCenter() : HasFocus(true)
 {
 	for(wchar_t i = 0; i < sf::Keyboard::KeyCount; i++)
@@ -27,11 +29,52 @@ InputCenter::InputCenter() : HasFocus(true)
 	MouseWheel = 0;
 };
 
-bool InputCenter::Update(sf::RenderWindow *Renderer)
+//sf::Window::waitEvent has no timeout, and blocking in it would miss whatever made us pass one (a cursor blink, a finished job),
+//so finite waits poll. Sleeping through the whole timeout would hold input back until it ends, so we wake about once a frame
+//at 60 FPS instead, keeping input latency under a frame without waking hundreds of times a second
+#define INPUT_WAIT_SLICE 16
+
+bool InputCenter::NextEvent(sf::RenderWindow *Renderer, sf::Event &Event, unsigned long Timeout)
+{
+	if(Timeout == 0)
+		return Renderer->pollEvent(Event);
+
+	if(Timeout == WaitForever)
+		return Renderer->waitEvent(Event);
+
+	sf::Clock Clock;
+
+	for(;;)
+	{
+		if(Renderer->pollEvent(Event))
+			return true;
+
+		unsigned long Elapsed = (unsigned long)Clock.getElapsedTime().asMilliseconds();
+
+		if(Elapsed >= Timeout)
+			return false;
+
+		sf::sleep(sf::milliseconds(Timeout - Elapsed < INPUT_WAIT_SLICE ? Timeout - Elapsed : INPUT_WAIT_SLICE));
+	};
+};
+
+bool InputCenter::Update(sf::RenderWindow *Renderer, unsigned long Timeout)
 {
 	if(Renderer == NULL)
 		return false;
 
+	for(unsigned long i = 0; i < sf::Keyboard::KeyCount && Timeout != 0; i++)
+	{
+		if(Keys[i].Pressed)
+			Timeout = 0;
+	};
+
+	for(unsigned long i = 0; i < sf::Mouse::ButtonCount && Timeout != 0; i++)
+	{
+		if(MouseButtons[i].Pressed)
+			Timeout = 0;
+	};
+
 	for(unsigned long i = 0; i < sf::Keyboard::KeyCount; i++)
 	{
 		Keys[i].JustPressed = false;
@@ -53,7 +96,8 @@ bool InputCenter::Update(sf::RenderWindow *Renderer)
 	bool HasPendingResize = false;
 	unsigned long PendingResizeWidth, PendingResizeHeight;
 
-	while(Renderer->pollEvent(Event))
+	//Only the first event is waited for, the rest are whatever arrived with it
+	for(; NextEvent(Renderer, Event, Timeout); Timeout = 0)
 	{
 		InputConsumedValue = false;
 
@@ -35,8 +35,19 @@ public:
 	long MouseWheel;
 	Vector3 MouseMovement;
 
+	//!<Timeout for Update that waits until an event arrives
+	static const unsigned long WaitForever = 0xFFFFFFFF;
+
 	InputCenter();
-	bool Update(sf::RenderWindow *Renderer);
+
+	/*!
+	*	Processes every pending event, optionally waiting for one first
+	*	\param Renderer the window to get events from
+	*	\param Timeout how long to wait for an event when there's none pending, in milliseconds
+	*	\return false if the window was closed
+	*	\note Never waits while keys or mouse buttons are held, since those must send OnPressed every Update
+	*/
+	bool Update(sf::RenderWindow *Renderer, unsigned long Timeout = 0);
 	void CenterMouse(sf::RenderWindow *Renderer);
 
 	/*!
@@ -51,4 +62,13 @@ public:
 
 private:
 	bool InputConsumedValue;
+
+	/*!
+	*	Gets the next event
+	*	\param Renderer the window to get events from
+	*	\param Event receives the event
+	*	\param Timeout how long to wait for one, in milliseconds
+	*	\return whether there was an event
+	*/
+	bool NextEvent(sf::RenderWindow *Renderer, sf::Event &Event, unsigned long Timeout);
 };
@@ -871,3 +871,59 @@ void AxisAlignedBoundingBox::Corners(Vector3 *Destination) const
 
 const double MathUtils::Pi = 3.14159265358979323846264338327950288419716939937510;
 const float MathUtils::Epsilon = 0.000001f;
+
+float MathUtils::Ease(unsigned long Curve, float t)
+{
+	t = Clamp(t);
+
+	switch(Curve)
+	{
+	case EasingCurve::QuadIn:
+		return t * t;
+	case EasingCurve::QuadOut:
+		return t * (2 - t);
+	case EasingCurve::QuadInOut:
+		return t < 0.5f ? 2 * t * t : -1 + (4 - 2 * t) * t;
+	case EasingCurve::CubicIn:
+		return t * t * t;
+	case EasingCurve::CubicOut:
+		t -= 1;
+
+		return t * t * t + 1;
+	case EasingCurve::CubicInOut:
+		return t < 0.5f ? 4 * t * t * t : (t - 1) * (2 * t - 2) * (2 * t - 2) + 1;
+	case EasingCurve::SineInOut:
+		return 0.5f - cosf(t * (float)Pi) * 0.5f;
+	case EasingCurve::BackOut:
+		{
+			const float Overshoot = 1.70158f;
+
+			t -= 1;
+
+			return t * t * ((Overshoot + 1) * t + Overshoot) + 1;
+		};
+	case EasingCurve::BounceOut:
+		if(t < 1 / 2.75f)
+			return 7.5625f * t * t;
+
+		if(t < 2 / 2.75f)
+		{
+			t -= 1.5f / 2.75f;
+
+			return 7.5625f * t * t + 0.75f;
+		};
+
+		if(t < 2.5f / 2.75f)
+		{
+			t -= 2.25f / 2.75f;
+
+			return 7.5625f * t * t + 0.9375f;
+		};
+
+		t -= 2.625f / 2.75f;
+
+		return 7.5625f * t * t + 0.984375f;
+	};
+
+	return t;
+};
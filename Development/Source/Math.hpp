@@ -266,6 +266,23 @@ public:
 	void Corners(Vector3 *Destination) const;
 };
 
+namespace EasingCurve
+{
+	enum
+	{
+		Linear = 0,
+		QuadIn,
+		QuadOut,
+		QuadInOut,
+		CubicIn,
+		CubicOut,
+		CubicInOut,
+		SineInOut,
+		BackOut,
+		BounceOut
+	};
+};
+
 class MathUtils
 {
 public:
@@ -323,4 +340,12 @@ public:
 	{
 		return Value * 57.32484076433121f;
 	};
+
+	/*!
+		Applies an easing curve to an animation's progress
+		\param Curve one of EasingCurve
+		\param t the progress, between 0 and 1
+		\return the eased progress, which is 0 at t=0 and 1 at t=1 but may overshoot in between
+	*/
+	static float Ease(unsigned long Curve, float t);
 };
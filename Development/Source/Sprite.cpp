@@ -8,6 +8,9 @@
 #include "StringID.hpp"
 #include "Math.hpp"
 #include "Sprite.hpp"
+#include "TextureAtlas.hpp"
+#include "DrawCommandList.hpp"
+#include "SpriteBatch.hpp"
 
 //Generates a ninepatch quad
 void GenerateNinePatchGeometry(Vector2 *Vertices, Vector2 *TexCoords, const Vector2 &TextureSize, const Vector2 &Position, const Vector2 &Size, const Vector2 &Offset,
@@ -32,34 +35,6 @@ void GenerateNinePatchGeometry(Vector2 *Vertices, Vector2 *TexCoords, const Vect
 
 void Sprite::Draw(sf::RenderWindow *Renderer)
 {
-	static unsigned long LastBlendingMode = BlendingMode::None;
-
-	if(Options.BlendingModeValue != LastBlendingMode)
-	{
-		switch(Options.BlendingModeValue)
-		{
-		case BlendingMode::None:
-			glDisable(GL_BLEND);
-
-			break;
-		case BlendingMode::Alpha:
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-			break;
-		case BlendingMode::Additive:
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_ONE, GL_ONE);
-
-			break;
-		case BlendingMode::Subtractive:
-			glEnable(GL_BLEND);
-			glBlendEquation(GL_FUNC_SUBTRACT);
-
-			break;
-		};
-	};
-
 	Vector2 Vertices[6] = {
 		Vector2(),
 		Vector2(0, 1),
@@ -87,8 +62,14 @@ void Sprite::Draw(sf::RenderWindow *Renderer)
 		};
 
 		Vector2 NinePatchVertices[54], NinePatchTexCoords[54];
-		Vector4 NinePatchColors[54] = {
-			Options.ColorValue
+		Vector4 NinePatchColors[54];
+
+		if(Options.NinePatchValue)
+		{
+			for(unsigned long i = 0; i < 54; i++)
+			{
+				NinePatchColors[i] = Options.ColorValue;
+			};
 		};
 
 		Vector2 *VerticesTarget = Options.NinePatchValue ? NinePatchVertices : Vertices, *TexCoordTarget = Options.NinePatchValue ? NinePatchTexCoords : TexCoords;
@@ -288,35 +269,7 @@ void Sprite::Draw(sf::RenderWindow *Renderer)
 			};
 		};
 
-		sf::Texture::bind(SpriteTexture.Get());
-		glDisableClientState(GL_NORMAL_ARRAY);
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glVertexPointer(2, GL_FLOAT, 0, VerticesTarget);
-
-		if(SpriteTexture.Get() == NULL)
-		{
-			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		}
-		else
-		{
-			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-			glTexCoordPointer(2, GL_FLOAT, 0, TexCoordTarget);
-		};
-
-		if(Options.ColorValue != Vector4(1, 1, 1, 1))
-		{
-			glEnableClientState(GL_COLOR_ARRAY);
-			glColorPointer(4, GL_FLOAT, 0, ColorsTarget);
-		}
-		else
-		{
-			glDisableClientState(GL_COLOR_ARRAY);
-			glColor4f(1, 1, 1, 1);
-		};
-
-		glDrawArrays(GL_TRIANGLES, 0, VertexCount);
-
-		glColor4f(1, 1, 1, 1);
+		SpriteBatch::Instance.Add(SpriteTexture.Get(), Options.BlendingModeValue, VerticesTarget, TexCoordTarget, ColorsTarget, VertexCount);
 };
 
 void AnimatedSprite::AddAnimation(const std::string &Name, const std::vector<Vector2> &Frames)
@@ -333,24 +286,25 @@ void AnimatedSprite::SetAnimation(const std::string &Name, bool Repeats)
 {
 	StringID NameID = MakeStringID(Name);
 
+	FrameStarted = false;
+
 	if(Animations.find(NameID) == Animations.end())
 	{
 		CurrentAnimation = NULL;
-		LastFrameUpdate = 0;
 
 		return;
 	};
 
 	CurrentAnimation = &Animations[NameID];
 	CurrentAnimation->Repeating = Repeats;
-	LastFrameUpdate = 0;
 };
 
-void AnimatedSprite::Update()
+bool AnimatedSprite::Update(unsigned long long Time)
 {
-	if(LastFrameUpdate == 0)
+	if(!FrameStarted)
 	{
-		LastFrameUpdate = time(NULL);
+		FrameStarted = true;
+		LastFrameUpdate = Time;
 
 		if(CurrentAnimation != NULL && CurrentAnimation->Frames.size())
 		{
@@ -366,21 +320,58 @@ void AnimatedSprite::Update()
 		{
 			Options = Options.Scale(FrameSize / Vector2(SpriteTexture->getSize().x, SpriteTexture->getSize().y) * Scale);
 		};
+
+		return true;
 	};
 
-	if(CurrentAnimation != NULL && CurrentAnimation->Frames.size() && time(NULL) - LastFrameUpdate > FrameInterval)
-	{
-		LastFrameUpdate = time(NULL) - (time(NULL) - LastFrameUpdate - FrameInterval);
+	unsigned long long Interval = FrameInterval ? FrameInterval : 1;
 
-		CurrentAnimation->CurrentFrame++;
+	if(IsFinished() || Time - LastFrameUpdate < Interval)
+		return false;
 
-		if(CurrentAnimation->CurrentFrame >= CurrentAnimation->Frames.size())
-			CurrentAnimation->CurrentFrame = CurrentAnimation->Repeating ? 0 : CurrentAnimation->Frames.size() - 1;
+	unsigned long long Elapsed = (Time - LastFrameUpdate) / Interval;
+	unsigned long PreviousFrame = CurrentAnimation->CurrentFrame;
 
-		Vector2 Frame = CurrentAnimation->Frames[CurrentAnimation->CurrentFrame];
+	//Keep the remainder so the frame rate doesn't drift
+	LastFrameUpdate += Elapsed * Interval;
 
-		Options = Options.Crop(CropMode::CropTiled, Rect(FrameSize.x, Frame.x, FrameSize.y, Frame.y));
+	if(CurrentAnimation->CurrentFrame + Elapsed >= CurrentAnimation->Frames.size())
+	{
+		CurrentAnimation->CurrentFrame = CurrentAnimation->Repeating ?
+			(unsigned long)((CurrentAnimation->CurrentFrame + Elapsed) % CurrentAnimation->Frames.size()) : CurrentAnimation->Frames.size() - 1;
+	}
+	else
+	{
+		CurrentAnimation->CurrentFrame += (unsigned long)Elapsed;
 	};
+
+	if(CurrentAnimation->CurrentFrame == PreviousFrame)
+		return false;
+
+	Vector2 Frame = CurrentAnimation->Frames[CurrentAnimation->CurrentFrame];
+
+	Options = Options.Crop(CropMode::CropTiled, Rect(FrameSize.x, Frame.x, FrameSize.y, Frame.y));
+
+	return true;
+};
+
+bool AnimatedSprite::IsFinished() const
+{
+	return CurrentAnimation == NULL || CurrentAnimation->Frames.size() < 2 ||
+		(!CurrentAnimation->Repeating && CurrentAnimation->CurrentFrame + 1 >= CurrentAnimation->Frames.size());
+};
+
+unsigned long long AnimatedSprite::GetTimeUntilNextFrame(unsigned long long Time) const
+{
+	if(!FrameStarted)
+		return 0;
+
+	if(IsFinished())
+		return (unsigned long long)-1;
+
+	unsigned long long Due = LastFrameUpdate + (FrameInterval ? FrameInterval : 1);
+
+	return Due > Time ? Due - Time : 0;
 };
 
 void AnimatedSprite::StopAnimation()
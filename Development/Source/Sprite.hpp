@@ -33,7 +33,9 @@ namespace BlendingMode
 		None = 0,
 		Alpha,
 		Additive,
-		Subtractive
+		Subtractive,
+		//!<Like Alpha, for textures whose color is already multiplied by their alpha (such as cached layers)
+		Premultiplied
 	};
 };
 
@@ -90,6 +92,7 @@ public:
 	SuperSmartPointer<sf::Texture> SpriteTexture;
 	SpriteDrawOptions Options;
 
+	//Appends this sprite to SpriteBatch::Instance, so it is only visible once the batch is flushed
 	void Draw(sf::RenderWindow *Renderer);
 };
 
@@ -106,15 +109,19 @@ class AnimatedSprite : public Sprite
 
 	typedef std::map<StringID, AnimationInfo> FrameMap;
 	FrameMap Animations;
+	//!<When the current frame started, in milliseconds
 	unsigned long long LastFrameUpdate;
+	//!<Whether the current frame was applied since the animation was set
+	bool FrameStarted;
 	AnimationInfo *CurrentAnimation;
 public:
 	Vector2 FrameSize, DefaultFrame, Scale;
 
+	//!<How long each frame is shown, in milliseconds
 	unsigned long long FrameInterval;
 
 	AnimatedSprite(const Vector2 &SpriteFrameSize, const Vector2 &SpriteDefaultFrame = Vector2()) :
-		FrameSize(SpriteFrameSize), LastFrameUpdate(0), CurrentAnimation(NULL), DefaultFrame(SpriteDefaultFrame),
+		FrameSize(SpriteFrameSize), LastFrameUpdate(0), FrameStarted(false), CurrentAnimation(NULL), DefaultFrame(SpriteDefaultFrame),
 		FrameInterval(250), Scale(1, 1) {};
 
 	void AddAnimation(const std::string &Name, const std::vector<Vector2> &Frames);
@@ -122,5 +129,23 @@ public:
 	void SetAnimation(const std::string &Name, bool Repeats);
 	void StopAnimation();
 
-	void Update();
+	/*!
+	*	Advances the animation
+	*	\param Time the current time in milliseconds, from a monotonic clock
+	*	\return whether the shown frame changed
+	*	\note Frames that were missed are skipped, so the animation keeps its pace
+	*/
+	bool Update(unsigned long long Time);
+
+	/*!
+	*	\return whether there's no animation, or it doesn't repeat and reached its last frame
+	*/
+	bool IsFinished() const;
+
+	/*!
+	*	Gets how long until the shown frame changes
+	*	\param Time the current time in milliseconds
+	*	\return the time in milliseconds, or (unsigned long long)-1 if it won't change
+	*/
+	unsigned long long GetTimeUntilNextFrame(unsigned long long Time) const;
 };
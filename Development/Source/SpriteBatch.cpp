@@ -0,0 +1,367 @@
+#include <map>
+#include <vector>
+#include <GL/glew.h>
+#include <SFML/Graphics.hpp>
+#include <math.h>
+#include <string.h>
+#include "SuperSmartPointer.hpp"
+#include "StringID.hpp"
+#include "Math.hpp"
+#include "Sprite.hpp"
+#include "TextureAtlas.hpp"
+#include "DrawCommandList.hpp"
+#include "SpriteBatch.hpp"
+
+SpriteBatch SpriteBatch::Instance;
+
+void SpriteBatch::ApplyBlendingMode(unsigned long Mode)
+{
+	if(Mode == AppliedBlendingMode)
+		return;
+
+	AppliedBlendingMode = Mode;
+
+	switch(Mode)
+	{
+	case BlendingMode::None:
+		glDisable(GL_BLEND);
+
+		break;
+	case BlendingMode::Alpha:
+		glEnable(GL_BLEND);
+		glBlendEquation(GL_FUNC_ADD);
+
+		//Offscreen targets start out transparent, so they must keep track of coverage in their alpha
+		if(TargetStack.size())
+		{
+			glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		}
+		else
+		{
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		};
+
+		break;
+	case BlendingMode::Premultiplied:
+		glEnable(GL_BLEND);
+		glBlendEquation(GL_FUNC_ADD);
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+		break;
+	case BlendingMode::Additive:
+		glEnable(GL_BLEND);
+		glBlendEquation(GL_FUNC_ADD);
+		glBlendFunc(GL_ONE, GL_ONE);
+
+		break;
+	case BlendingMode::Subtractive:
+		glEnable(GL_BLEND);
+		glBlendEquation(GL_FUNC_SUBTRACT);
+
+		break;
+	};
+};
+
+void SpriteBatch::AddGeometry(unsigned long Type, const sf::Texture *Texture, unsigned long Blending, const Vector2 *InVertices,
+	const Vector2 *InTexCoords, const Vector4 *InColors, unsigned long Count)
+{
+	if(Count == 0)
+		return;
+
+	if(Recorder)
+		Recorder->AddGeometry(Type, Texture, Blending, InVertices, InTexCoords, InColors, Count);
+
+	if(Atlas && Texture)
+	{
+		RemapBuffer.assign(InTexCoords, InTexCoords + Count);
+
+		if(Atlas->Remap(Texture, &RemapBuffer[0], Count))
+		{
+			InTexCoords = &RemapBuffer[0];
+		};
+	};
+
+	if(Vertices.size() && (Texture != CurrentTexture || Blending != CurrentBlendingMode))
+	{
+		Flush();
+	};
+
+	CurrentTexture = Texture;
+	CurrentBlendingMode = Blending;
+
+	Vertices.insert(Vertices.end(), InVertices, InVertices + Count);
+	TexCoords.insert(TexCoords.end(), InTexCoords, InTexCoords + Count);
+	Colors.insert(Colors.end(), InColors, InColors + Count);
+
+	FrameStats.RequestCount++;
+};
+
+void SpriteBatch::AddRect(const Vector2 &Position, const Vector2 &Size, const Vector4 &Color)
+{
+	Vector2 RectVertices[6] = {
+		Position,
+		Position + Vector2(0, Size.y),
+		Position + Size,
+		Position + Size,
+		Position + Vector2(Size.x, 0),
+		Position
+	};
+
+	Vector2 RectTexCoords[6];
+
+	Vector4 RectColors[6] = {
+		Color, Color, Color, Color, Color, Color
+	};
+
+	AddGeometry(DrawCommandType::SolidRect, NULL, BlendingMode::Alpha, RectVertices, RectTexCoords, RectColors, 6);
+};
+
+/*!
+*	\return the area covered by both A and B, which is empty (but still positioned inside both) if they don't overlap
+*/
+static Rect IntersectScissor(const Rect &A, const Rect &B)
+{
+	Rect Out(A.Left > B.Left ? A.Left : B.Left, A.Right < B.Right ? A.Right : B.Right,
+		A.Top > B.Top ? A.Top : B.Top, A.Bottom < B.Bottom ? A.Bottom : B.Bottom);
+
+	if(Out.Right < Out.Left)
+		Out.Right = Out.Left;
+
+	if(Out.Bottom < Out.Top)
+		Out.Bottom = Out.Top;
+
+	return Out;
+};
+
+void SpriteBatch::ApplyScissor()
+{
+	if(Headless)
+		return;
+
+	bool Enabled = ScissorStack.size() != 0 || OuterScissorEnabled;
+	const Rect &Area = ScissorStack.size() ? ScissorStack.back().Area : OuterScissor;
+	GLint Box[4] = { 0, 0, 0, 0 };
+
+	if(Enabled)
+	{
+		Box[0] = (GLint)Area.Left;
+		Box[1] = (GLint)(ScissorTargetHeight - Area.Bottom);
+		Box[2] = (GLsizei)(Area.Right - Area.Left);
+		Box[3] = (GLsizei)(Area.Bottom - Area.Top);
+	};
+
+	if(AppliedScissorValid && Enabled == AppliedScissorEnabled && (!Enabled || memcmp(Box, AppliedScissorBox, sizeof(Box)) == 0))
+		return;
+
+	AppliedScissorValid = true;
+	AppliedScissorEnabled = Enabled;
+	memcpy(AppliedScissorBox, Box, sizeof(Box));
+
+	if(!Enabled)
+	{
+		glDisable(GL_SCISSOR_TEST);
+
+		return;
+	};
+
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(Box[0], Box[1], Box[2], Box[3]);
+};
+
+void SpriteBatch::PushScissor(const Rect &Area, float TargetHeight)
+{
+	//Scissoring applies to whatever is flushed next
+	Flush();
+
+	if(Recorder)
+		Recorder->AddPushScissor(Area, TargetHeight);
+
+	ScissorState State;
+
+	if(ScissorStack.size() == 0)
+	{
+		//Callers only know about the window, but we may be drawing somewhere else
+		if(TargetStack.size())
+			TargetHeight = (float)TargetStack.back().Target->getSize().y;
+
+		ScissorTargetHeight = TargetHeight;
+
+		State.CullArea = Area;
+		State.Area = OuterScissorEnabled ? IntersectScissor(Area, OuterScissor) : Area;
+	}
+	else
+	{
+		State.CullArea = IntersectScissor(Area, ScissorStack.back().CullArea);
+		State.Area = IntersectScissor(Area, ScissorStack.back().Area);
+	};
+
+	ScissorStack.push_back(State);
+
+	ApplyScissor();
+};
+
+void SpriteBatch::PopScissor()
+{
+	if(ScissorStack.size() == 0)
+		return;
+
+	Flush();
+
+	if(Recorder)
+		Recorder->AddPopScissor();
+
+	ScissorStack.pop_back();
+
+	ApplyScissor();
+};
+
+void SpriteBatch::SetOuterScissor(const Rect &Area, float TargetHeight)
+{
+	Flush();
+
+	OuterScissorEnabled = true;
+	OuterScissor = Area;
+	ScissorTargetHeight = TargetHeight;
+
+	ApplyScissor();
+};
+
+void SpriteBatch::ClearOuterScissor()
+{
+	Flush();
+
+	OuterScissorEnabled = false;
+
+	ApplyScissor();
+};
+
+void SpriteBatch::Flush()
+{
+	if(Vertices.size() == 0)
+		return;
+
+	FrameStats.BatchCount++;
+	FrameStats.VertexCount += Vertices.size();
+
+	if(!Headless)
+	{
+		ApplyBlendingMode(CurrentBlendingMode);
+
+		sf::Texture::bind(CurrentTexture);
+
+		//SFML flips render texture coordinates with the texture matrix and doesn't always undo it, but ours are never flipped
+		glMatrixMode(GL_TEXTURE);
+		glLoadIdentity();
+		glMatrixMode(GL_MODELVIEW);
+
+		glDisableClientState(GL_NORMAL_ARRAY);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glVertexPointer(2, GL_FLOAT, 0, &Vertices[0]);
+
+		if(CurrentTexture == NULL)
+		{
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		}
+		else
+		{
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			glTexCoordPointer(2, GL_FLOAT, 0, &TexCoords[0]);
+		};
+
+		glEnableClientState(GL_COLOR_ARRAY);
+		glColorPointer(4, GL_FLOAT, 0, &Colors[0]);
+
+		glDrawArrays(GL_TRIANGLES, 0, Vertices.size());
+
+		glDisableClientState(GL_COLOR_ARRAY);
+		glColor4f(1, 1, 1, 1);
+	};
+
+	//clear() keeps the capacity, so the buffers stop growing after the first few frames
+	Vertices.clear();
+	TexCoords.clear();
+	Colors.clear();
+};
+
+void SpriteBatch::BeginFrame()
+{
+	Flush();
+
+	FrameStats = Stats();
+	AppliedBlendingMode = (unsigned long)-1;
+};
+
+void SpriteBatch::BeginTarget(sf::RenderTexture *Target, sf::RenderWindow *Window)
+{
+	//Whatever is pending belongs to the previous target
+	Flush();
+
+	TargetState State;
+	State.Target = Target;
+	State.Window = Window;
+	State.Recorder = Recorder;
+	State.ScissorStack.swap(ScissorStack);
+	State.ScissorTargetHeight = ScissorTargetHeight;
+	State.OuterScissorEnabled = OuterScissorEnabled;
+	State.OuterScissor = OuterScissor;
+
+	TargetStack.push_back(State);
+
+	Recorder = NULL;
+	OuterScissorEnabled = false;
+	AppliedBlendingMode = (unsigned long)-1;
+	AppliedScissorValid = false;
+
+	if(Headless)
+		return;
+
+	//Render textures may have their own GL context, so set up everything we rely on
+	Target->setActive(true);
+
+	glViewport(0, 0, Target->getSize().x, Target->getSize().y);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0, Target->getSize().x, Target->getSize().y, 0, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glEnable(GL_TEXTURE_2D);
+	glDisable(GL_SCISSOR_TEST);
+
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+};
+
+void SpriteBatch::EndTarget()
+{
+	if(TargetStack.size() == 0)
+		return;
+
+	Flush();
+
+	TargetState &State = TargetStack.back();
+
+	Recorder = State.Recorder;
+	ScissorStack.swap(State.ScissorStack);
+	ScissorTargetHeight = State.ScissorTargetHeight;
+	OuterScissorEnabled = State.OuterScissorEnabled;
+	OuterScissor = State.OuterScissor;
+
+	AppliedBlendingMode = (unsigned long)-1;
+	AppliedScissorValid = false;
+
+	if(!Headless)
+	{
+		State.Target->display();
+
+		if(TargetStack.size() > 1)
+		{
+			TargetStack[TargetStack.size() - 2].Target->setActive(true);
+		}
+		else
+		{
+			State.Window->setActive(true);
+		};
+	};
+
+	TargetStack.pop_back();
+};
@@ -0,0 +1,235 @@
+#pragma once
+/*!
+*	Sprite Batcher
+*	Collects the geometry of every Sprite drawn during a frame and submits it in as few draw calls as possible
+*	\note Geometry is only flushed when the texture or blending mode changes, or when Flush is called
+*/
+class SpriteBatch
+{
+public:
+	/*!
+	*	Batching statistics, reset on BeginFrame
+	*/
+	class Stats
+	{
+	public:
+		//!<Amount of draw calls issued (or that would have been issued, when headless)
+		unsigned long BatchCount;
+		//!<Amount of vertices submitted
+		unsigned long VertexCount;
+		//!<Amount of quads/nine-patches appended
+		unsigned long RequestCount;
+
+		Stats() : BatchCount(0), VertexCount(0), RequestCount(0) {};
+	};
+private:
+	std::vector<Vector2> Vertices, TexCoords;
+	std::vector<Vector4> Colors;
+	std::vector<Vector2> RemapBuffer;
+	const sf::Texture *CurrentTexture;
+	TextureAtlas *Atlas;
+	unsigned long CurrentBlendingMode, AppliedBlendingMode;
+	bool Headless;
+	Stats FrameStats;
+	DrawCommandList *Recorder;
+
+	/*!
+	*	An area pushed by PushScissor, already intersected with the ones below it
+	*/
+	class ScissorState
+	{
+	public:
+		//!<What is actually scissored to, including the outer scissor
+		Rect Area;
+		//!<What elements are culled against, which excludes the outer scissor
+		Rect CullArea;
+	};
+
+	/*!
+	*	An offscreen target being drawn to, and the batch state from before BeginTarget
+	*/
+	class TargetState
+	{
+	public:
+		sf::RenderTexture *Target;
+		sf::RenderWindow *Window;
+		DrawCommandList *Recorder;
+		std::vector<ScissorState> ScissorStack;
+		float ScissorTargetHeight;
+		bool OuterScissorEnabled;
+		Rect OuterScissor;
+	};
+
+	std::vector<ScissorState> ScissorStack;
+	float ScissorTargetHeight;
+	//!<Scissoring applied below everything pushed, in pixels from the top left
+	bool OuterScissorEnabled;
+	Rect OuterScissor;
+	//!<Scissoring we last sent to GL, so unchanged areas aren't sent again
+	bool AppliedScissorValid, AppliedScissorEnabled;
+	GLint AppliedScissorBox[4];
+
+	std::vector<TargetState> TargetStack;
+
+	void ApplyBlendingMode(unsigned long Mode);
+	void ApplyScissor();
+public:
+	static SpriteBatch Instance;
+
+	SpriteBatch() : CurrentTexture(NULL), Atlas(NULL), CurrentBlendingMode(BlendingMode::Alpha), AppliedBlendingMode((unsigned long)-1),
+		Headless(false), Recorder(NULL), ScissorTargetHeight(0), OuterScissorEnabled(false), AppliedScissorValid(false),
+		AppliedScissorEnabled(false) {};
+
+	/*!
+	*	Sets whether we're running without a GPU
+	*	\param Value whether to skip all GL calls and only count batches and vertices
+	*/
+	void SetHeadless(bool Value)
+	{
+		Headless = Value;
+	};
+
+	/*!
+	*	\return whether we're running without a GPU
+	*/
+	bool IsHeadless() const
+	{
+		return Headless;
+	};
+
+	/*!
+	*	Sets the Texture Atlas used to redirect textures into atlas pages
+	*	\param TheAtlas the atlas to use, or NULL to disable remapping
+	*/
+	void SetAtlas(TextureAtlas *TheAtlas)
+	{
+		Flush();
+
+		Atlas = TheAtlas;
+	};
+
+	/*!
+	*	\return the Texture Atlas in use, or NULL
+	*/
+	TextureAtlas *GetAtlas()
+	{
+		return Atlas;
+	};
+
+	/*!
+	*	Sets the list that records everything sent to the batch, in addition to drawing it
+	*	\param List the list to record into, or NULL to stop recording
+	*/
+	void SetRecorder(DrawCommandList *List)
+	{
+		Recorder = List;
+	};
+
+	/*!
+	*	Appends triangle geometry to the batch
+	*	\param Type one of DrawCommandType (Geometry, SolidRect, or Text), only used when recording
+	*	\param Texture the texture to use (or NULL)
+	*	\param Blending the BlendingMode to use
+	*	\param Vertices the vertices (in triangle list order)
+	*	\param TexCoords the texture coordinates of each vertex
+	*	\param Colors the color of each vertex
+	*	\param Count the amount of vertices
+	*/
+	void AddGeometry(unsigned long Type, const sf::Texture *Texture, unsigned long Blending, const Vector2 *Vertices,
+		const Vector2 *TexCoords, const Vector4 *Colors, unsigned long Count);
+
+	/*!
+	*	Appends triangle geometry to the batch
+	*	\param Texture the texture to use (or NULL)
+	*	\param Blending the BlendingMode to use
+	*	\param Vertices the vertices (in triangle list order)
+	*	\param TexCoords the texture coordinates of each vertex
+	*	\param Colors the color of each vertex
+	*	\param Count the amount of vertices
+	*/
+	void Add(const sf::Texture *Texture, unsigned long Blending, const Vector2 *Vertices, const Vector2 *TexCoords,
+		const Vector4 *Colors, unsigned long Count)
+	{
+		AddGeometry(DrawCommandType::Geometry, Texture, Blending, Vertices, TexCoords, Colors, Count);
+	};
+
+	/*!
+	*	Appends a solid colored rectangle to the batch
+	*	\param Position the rectangle's position
+	*	\param Size the rectangle's size
+	*	\param Color the rectangle's color
+	*/
+	void AddRect(const Vector2 &Position, const Vector2 &Size, const Vector4 &Color);
+
+	/*!
+	*	Restricts drawing to an area until the matching PopScissor
+	*	\param Area the area, in pixels from the top left
+	*	\param TargetHeight the height of the render target
+	*	\note The area is intersected with whatever was being scissored already, including the outer scissor
+	*/
+	void PushScissor(const Rect &Area, float TargetHeight);
+
+	/*!
+	*	Restores the scissoring from before the last PushScissor
+	*/
+	void PopScissor();
+
+	/*!
+	*	Sets scissoring that applies below everything pushed by PushScissor, such as the area of the window being redrawn
+	*	\param Area the area, in pixels from the top left
+	*	\param TargetHeight the height of the render target
+	*	\note Unlike pushed areas, this isn't recorded nor used for culling, since recorded commands may be replayed with a different one
+	*/
+	void SetOuterScissor(const Rect &Area, float TargetHeight);
+
+	/*!
+	*	Removes the outer scissor
+	*/
+	void ClearOuterScissor();
+
+	/*!
+	*	\param Area an area, in pixels from the top left
+	*	\return whether nothing drawn inside that area would be visible due to the areas pushed by PushScissor
+	*/
+	bool IsClipped(const Rect &Area) const
+	{
+		if(ScissorStack.size() == 0)
+			return false;
+
+		const Rect &Clip = ScissorStack.back().CullArea;
+
+		return Area.Right <= Clip.Left || Area.Left >= Clip.Right || Area.Bottom <= Clip.Top || Area.Top >= Clip.Bottom;
+	};
+
+	/*!
+	*	Redirects drawing to an offscreen target until the matching EndTarget
+	*	\param Target the target to draw to, which is cleared to transparent
+	*	\param Window the window to return to after the last EndTarget
+	*	\note Recording and scissoring are suspended, and Alpha blending produces premultiplied colors, so the target must be drawn with BlendingMode::Premultiplied
+	*/
+	void BeginTarget(sf::RenderTexture *Target, sf::RenderWindow *Window);
+
+	/*!
+	*	Finishes drawing to the target from the last BeginTarget, and returns to whatever we were drawing to before
+	*/
+	void EndTarget();
+
+	/*!
+	*	Draws all pending geometry
+	*	\note Must be called before issuing any GL calls outside the batch (scissoring, SFML drawing, etc)
+	*/
+	void Flush();
+
+	/*!
+	*	Resets the frame statistics and cached GL state
+	*/
+	void BeginFrame();
+
+	/*!
+	*	\return the statistics since the last BeginFrame
+	*/
+	const Stats &GetStats() const
+	{
+		return FrameStats;
+	};
+};
@@ -1,139 +1,155 @@
 #pragma once
 /*!
-	Smart Pointer implementation using Observer Pattern and implicit Destruction
+	Shared state of every SuperSmartPointer and SuperWeakPointer to the same object
+	\note Blocks are recycled through a free list instead of being deleted, which is what lets weak pointers check the Generation
+	\note Not thread safe, like the pointers themselves
 */
-template<typename type>
-class SuperSmartPointer
+class SuperSmartPointerBlock
 {
-private:
-	template<typename OutType>
-	friend class SuperSmartPointer;
+public:
+	//!<Amount of strong pointers holding this block
+	unsigned long References;
+	//!<Changes whenever the object is destroyed, which invalidates every weak pointer made before
+	unsigned long Generation;
+	//!<The object, or NULL once it was disposed
+	void *Object;
+	//!<Deletes the object as the type it was created with
+	void (*Destroy)(void *Object);
+	//!<If set, incremented whenever a release leaves a single reference, so an owner can tell it may hold the last one
+	unsigned long *ReleaseCounter;
+	SuperSmartPointerBlock *NextFree;
+
+	SuperSmartPointerBlock() : References(0), Generation(0), Object(NULL), Destroy(NULL), ReleaseCounter(NULL), NextFree(NULL) {};
+
+	static SuperSmartPointerBlock *&FreeList()
+	{
+		static SuperSmartPointerBlock *List = NULL;
 
-	class SuperSmartPointerContainer
+		return List;
+	};
+
+	template<typename type> static void DestroyObject(void *Object)
 	{
-	public:
-		friend class SuperSmartPointer<type>;
-		typedef std::vector<SuperSmartPointer *> ObserverList;
-		ObserverList Observers;
-		type *Object;
+		delete static_cast<type *>(Object);
+	};
 
-		SuperSmartPointerContainer() : Object(NULL)
-		{
-		};
+	template<typename type> static SuperSmartPointerBlock *Allocate(type *Object)
+	{
+		SuperSmartPointerBlock *Block = FreeList();
 
-		void Add(SuperSmartPointer *Observer)
+		if(Block)
 		{
-			Observers.push_back(Observer);
-		};
-
-		void Remove(SuperSmartPointer *Observer)
+			FreeList() = Block->NextFree;
+		}
+		else
 		{
-			if(Observers.size())
-			{
-				for(typename ObserverList::iterator it = Observers.begin(); it != Observers.end(); it++)
-				{
-					if(*it == Observer)
-					{
-						Observer->ContainerDisposed();
-
-						it = Observers.erase(it);
-
-						if(Observers.size() == 0)
-						{
-							if(Object)
-							{
-								delete Object;
-								Object = NULL;
-							};
-
-							delete this;
-						};
-
-						break;
-					};
-				};
-			};
+			Block = new SuperSmartPointerBlock();
 		};
 
-		void Dispose()
-		{
-			while(Observers.size())
-			{
-				(*Observers.begin())->ContainerDisposed();
-				Observers.erase(Observers.begin());
-			};
-
-			if(Object)
-			{
-				delete Object;
-				Object = NULL;
-			};
-
-			delete this;
-		};
+		Block->References = 1;
+		Block->Object = Object;
+		Block->Destroy = &DestroyObject<type>;
+		Block->ReleaseCounter = NULL;
+		Block->NextFree = NULL;
+
+		return Block;
+	};
+
+	/*!
+		Destroys the object if it still exists, invalidating every weak pointer
+	*/
+	void Dispose()
+	{
+		if(!Object)
+			return;
+
+		//Clear it first, so the object's destructor sees itself as gone like everyone else does
+		void *DisposedObject = Object;
+		Object = NULL;
+		Generation++;
+
+		Destroy(DisposedObject);
+	};
 
-		void Replace(type *NewObject, bool Destroy)
+	void Release()
+	{
+		if(--References)
 		{
-			if(Object && Destroy)
-			{
-				delete Object;
-			};
+			if(References == 1 && ReleaseCounter)
+				(*ReleaseCounter)++;
 
-			Object = NewObject;
+			return;
 		};
+
+		Dispose();
+
+		NextFree = FreeList();
+		FreeList() = this;
 	};
+};
 
-	SuperSmartPointerContainer *Content;
+template<typename type>
+class SuperWeakPointer;
 
-	void ContainerDisposed()
+/*!
+	Reference counted Smart Pointer with explicit Disposal
+	\note Dispose destroys the object for every pointer sharing it, which then behave as Empty
+*/
+template<typename type>
+class SuperSmartPointer
+{
+private:
+	template<typename OutType>
+	friend class SuperSmartPointer;
+	friend class SuperWeakPointer<type>;
+
+	SuperSmartPointerBlock *Block;
+	//!<Our view of the object, which differs from Block->Object after converting between base and derived types
+	type *Object;
+
+	SuperSmartPointer(SuperSmartPointerBlock *TheBlock, type *TheObject) : Block(TheBlock), Object(TheObject)
 	{
-		Content = NULL;
+		if(Block)
+			Block->References++;
 	};
 public:
-	SuperSmartPointer() : Content(NULL) {};
-	explicit SuperSmartPointer(type *Object) : Content(NULL)
+	SuperSmartPointer() : Block(NULL), Object(NULL) {};
+	explicit SuperSmartPointer(type *Object) : Block(NULL), Object(NULL)
 	{
-		if(Object)
-		{
-			Content = new SuperSmartPointerContainer();
-			Content->Object = Object;
-			Content->Add(this);
-		};
+		Reset(Object);
 	};
 
-	SuperSmartPointer<type>(const SuperSmartPointer<type> &o) : Content(NULL)
+	SuperSmartPointer<type>(const SuperSmartPointer<type> &o) : Block(o.Block), Object(o.Object)
 	{
-		*this = o;
+		if(Block)
+			Block->References++;
 	};
 
 	~SuperSmartPointer()
 	{
-		if(Content)
-			Content->Remove(this);
-
-		Content = NULL;
+		if(Block)
+			Block->Release();
 	};
 
+	/*!
+		\return the amount of pointers sharing our object
+	*/
 	size_t ObserverCount()
 	{
-		return Content == NULL ? 0 : Content->Observers.size();
+		return Block == NULL ? 0 : Block->References;
 	};
 
 	SuperSmartPointer<type> &operator=(const SuperSmartPointer<type> &o)
 	{
-		if(Content == o.Content || this == &o)
-			return *this;
+		//Reference first, in case releasing ours destroys o
+		if(o.Block)
+			o.Block->References++;
 
-		if(Content) {
-			Content->Remove(this);
-			Content = NULL;
-		};
+		if(Block)
+			Block->Release();
 
-		if(!o.Content)
-			return *this;
-
-		Content = o.Content;
-		Content->Add(this);
+		Block = o.Block;
+		Object = o.Object;
 
 		return *this;
 	};
@@ -141,14 +157,10 @@ public:
 	template<typename OutType>
 	operator SuperSmartPointer<OutType>()
 	{
-		if(!Content)
+		if(!Get())
 			return SuperSmartPointer<OutType>();
 
-		SuperSmartPointer<OutType> Out;
-		Out.Content = reinterpret_cast<typename SuperSmartPointer<OutType>::SuperSmartPointerContainer *>(Content);
-		Out.Content->Add(&Out);
-
-		return Out;
+		return SuperSmartPointer<OutType>(Block, static_cast<OutType *>(Object));
 	}
 
 	/*!
@@ -192,12 +204,12 @@ public:
 
 	inline const type *Get() const
 	{
-		return Content ? Content->Object : NULL;
+		return Block && Block->Object ? Object : NULL;
 	};
 
 	inline type *Get()
 	{
-		return Content ? Content->Object : NULL;
+		return Block && Block->Object ? Object : NULL;
 	};
 
 	bool operator==(const SuperSmartPointer<type> &o)
@@ -220,34 +232,15 @@ public:
 		return Get();
 	};
 
-	void Reset(type *Object)
+	void Reset(type *NewObject)
 	{
-		if(Content)
-		{
-			Content->Remove(this);
-			Content = NULL;
-		};
+		SuperSmartPointerBlock *Previous = Block;
 
-		if(Object)
-		{
-			Content = new SuperSmartPointerContainer();
-			Content->Object = Object;
-			Content->Add(this);
-		};
-	};
+		Block = NewObject ? SuperSmartPointerBlock::Allocate(NewObject) : NULL;
+		Object = NewObject;
 
-	void Replace(type *Object, bool Destroy = true)
-	{
-		if(Content)
-		{
-			Content->Replace(Object, Destroy);
-		}
-		else
-		{
-			Content = new SuperSmartPointerContainer();
-			Content->Object = Object;
-			Content->Add(this);
-		};
+		if(Previous)
+			Previous->Release();
 	};
 
 	/*!
@@ -255,9 +248,74 @@ public:
 	*/
 	void Dispose()
 	{
-		if(Content)
+		if(Block)
 		{
-			Content->Dispose();
+			Block->Dispose();
 		};
 	};
+
+	/*!
+		Counts whenever a release leaves our object with a single pointer, such as when only a cache still holds it
+		\param Counter the counter to increment, or NULL to stop counting
+		\note The counter must be unset before it goes away if the object may outlive it
+	*/
+	void SetReleaseCounter(unsigned long *Counter)
+	{
+		if(Block)
+			Block->ReleaseCounter = Counter;
+	};
+};
+
+/*!
+	Weak Smart Pointer
+	Refers to an object owned by SuperSmartPointers without keeping it alive
+	\note Becomes Empty once the object is disposed or its last SuperSmartPointer goes away
+*/
+template<typename type>
+class SuperWeakPointer
+{
+private:
+	SuperSmartPointerBlock *Block;
+	unsigned long Generation;
+	type *Object;
+public:
+	SuperWeakPointer() : Block(NULL), Generation(0), Object(NULL) {};
+	SuperWeakPointer(const SuperSmartPointer<type> &o) : Block(o.Get() ? o.Block : NULL), Generation(o.Block ? o.Block->Generation : 0),
+		Object(o.Object) {};
+
+	SuperWeakPointer<type> &operator=(const SuperSmartPointer<type> &o)
+	{
+		Block = o.Get() ? o.Block : NULL;
+		Generation = Block ? Block->Generation : 0;
+		Object = o.Object;
+
+		return *this;
+	};
+
+	/*!
+		\return the object, or NULL if it's gone
+	*/
+	inline type *Get() const
+	{
+		return Block && Block->Generation == Generation ? Object : NULL;
+	};
+
+	inline operator bool() const
+	{
+		return Get() != 0;
+	};
+
+	/*!
+		\return a strong pointer to the object, or Empty if it's gone
+	*/
+	SuperSmartPointer<type> Lock() const
+	{
+		return Get() ? SuperSmartPointer<type>(Block, Object) : SuperSmartPointer<type>();
+	};
+
+	void Reset()
+	{
+		Block = NULL;
+		Object = NULL;
+	};
 };
@@ -0,0 +1,564 @@
+#include <map>
+#include <list>
+#include <vector>
+#include <GL/glew.h>
+#include <SFML/Graphics.hpp>
+#include <math.h>
+#include "SuperSmartPointer.hpp"
+#include "StringID.hpp"
+#include "CRC32.hpp"
+#include "Math.hpp"
+#include "Sprite.hpp"
+#include "TextureAtlas.hpp"
+#include "DrawCommandList.hpp"
+#include "SpriteBatch.hpp"
+#include "TextEngine.hpp"
+
+TextEngine TextEngine::Instance;
+
+class TextExtents
+{
+public:
+	float Left, Right;
+	bool Valid;
+
+	TextExtents() : Left(0), Right(0), Valid(false) {};
+
+	void Add(float InLeft, float InRight)
+	{
+		if(!Valid)
+		{
+			Left = InLeft;
+			Right = InRight;
+			Valid = true;
+
+			return;
+		};
+
+		if(InLeft < Left)
+			Left = InLeft;
+
+		if(InRight > Right)
+			Right = InRight;
+	};
+
+	void Merge(const TextExtents &o)
+	{
+		if(o.Valid)
+			Add(o.Left, o.Right);
+	};
+
+	void Offset(float Amount)
+	{
+		Left += Amount;
+		Right += Amount;
+	};
+
+	float Width() const
+	{
+		return Valid ? Right - Left : 0;
+	};
+};
+
+bool PushTextLine(std::vector<TextLineSpan> &Out, unsigned long MaxLines, unsigned long Offset, unsigned long Length,
+	const TextExtents &Extents)
+{
+	if(Out.size() >= MaxLines)
+		return false;
+
+	TextLineSpan Line;
+	Line.Offset = Offset;
+	Line.Length = Length;
+	Line.Width = Extents.Width();
+
+	Out.push_back(Line);
+
+	return true;
+};
+
+TextEngine::GlyphPage &TextEngine::GetPage(const sf::Font *Font, unsigned long FontSize)
+{
+	PageMap::iterator it = Pages.find(PageKey(Font, FontSize));
+
+	if(it != Pages.end())
+		return it->second;
+
+	GlyphPage &Page = Pages[PageKey(Font, FontSize)];
+
+	//Loading the space glyph may grow the font texture
+	SpriteBatch::Instance.Flush();
+	GlyphGeneration++;
+
+	Page.SpaceAdvance = (float)Font->getGlyph(L' ', FontSize, false).advance;
+	Page.LineSpacing = (float)Font->getLineSpacing(FontSize);
+	Page.Texture = &Font->getTexture(FontSize);
+
+	return Page;
+};
+
+const TextEngine::Glyph *TextEngine::GetGlyph(GlyphPage &Page, const sf::Font *Font, unsigned long FontSize, sf::Uint32 Character)
+{
+	GlyphMap::iterator it = Page.Glyphs.find(Character);
+
+	if(it != Page.Glyphs.end())
+		return &it->second;
+
+	FrameStats.GlyphMisses++;
+
+	//Pending quads hold normalized texture coordinates that would be invalidated if the font texture grows
+	SpriteBatch::Instance.Flush();
+	GlyphGeneration++;
+
+	const sf::Glyph &SourceGlyph = Font->getGlyph(Character, FontSize, false);
+
+	Glyph &TheGlyph = Page.Glyphs[Character];
+	TheGlyph.Advance = (float)SourceGlyph.advance;
+	TheGlyph.Offset = Vector2((float)SourceGlyph.bounds.left, (float)SourceGlyph.bounds.top);
+	TheGlyph.Size = Vector2((float)SourceGlyph.bounds.width, (float)SourceGlyph.bounds.height);
+	TheGlyph.TexturePosition = Vector2((float)SourceGlyph.textureRect.left, (float)SourceGlyph.textureRect.top);
+	TheGlyph.TextureSize = Vector2((float)SourceGlyph.textureRect.width, (float)SourceGlyph.textureRect.height);
+
+	//A grown texture may have been recreated with smoothing enabled
+	const_cast<sf::Texture *>(Page.Texture)->setSmooth(false);
+
+	return &TheGlyph;
+};
+
+float TextEngine::GetKerning(GlyphPage &Page, const sf::Font *Font, unsigned long FontSize, sf::Uint32 First, sf::Uint32 Second)
+{
+	if(First == 0)
+		return 0;
+
+	std::pair<sf::Uint32, sf::Uint32> Pair(First, Second);
+
+	KerningMap::iterator it = Page.Kerning.find(Pair);
+
+	if(it != Page.Kerning.end())
+		return it->second;
+
+	float Kerning = (float)Font->getKerning(First, Second, FontSize);
+
+	Page.Kerning[Pair] = Kerning;
+
+	return Kerning;
+};
+
+void TextEngine::Layout(GlyphPage &Page, const sf::String &String, const sf::Font *Font, unsigned long FontSize)
+{
+	ResolvedGlyphs.resize(String.getSize());
+	GlyphPositions.resize(String.getSize());
+	PenAdvances.resize(String.getSize());
+
+	//Resolve every glyph before positioning any so the texture can't grow halfway through
+	for(unsigned long i = 0; i < String.getSize(); i++)
+	{
+		ResolvedGlyphs[i] = GetGlyph(Page, Font, FontSize, String[i]);
+	};
+
+	//Same layout rules as sf::Text, baseline starts at FontSize
+	float x = 0, y = (float)FontSize;
+	sf::Uint32 PreviousCharacter = 0;
+
+	for(unsigned long i = 0; i < String.getSize(); i++)
+	{
+		sf::Uint32 Character = String[i];
+
+		x += GetKerning(Page, Font, FontSize, PreviousCharacter, Character);
+		PreviousCharacter = Character;
+
+		GlyphPositions[i] = Vector2(x, y);
+
+		switch(Character)
+		{
+		case L' ':
+			x += Page.SpaceAdvance;
+			ResolvedGlyphs[i] = NULL;
+
+			break;
+		case L'\t':
+			x += Page.SpaceAdvance * 4;
+			ResolvedGlyphs[i] = NULL;
+
+			break;
+		case L'\n':
+			y += Page.LineSpacing;
+			x = 0;
+			ResolvedGlyphs[i] = NULL;
+
+			break;
+		case L'\v':
+			y += Page.LineSpacing * 4;
+			ResolvedGlyphs[i] = NULL;
+
+			break;
+		default:
+			x += ResolvedGlyphs[i]->Advance;
+
+			break;
+		};
+
+		PenAdvances[i] = x;
+	};
+};
+
+void TextEngine::AddGlyphs(GlyphPage &Page, const sf::String &String, const TextParams &Params, const Vector2 &Offset, bool Border)
+{
+	Vector2 TextureDimensions((float)Page.Texture->getSize().x, (float)Page.Texture->getSize().y);
+
+	if(TextureDimensions.x == 0 || TextureDimensions.y == 0)
+		return;
+
+	for(unsigned long i = 0; i < String.getSize(); i++)
+	{
+		if(ResolvedGlyphs[i] == NULL)
+			continue;
+
+		const Glyph &TheGlyph = *ResolvedGlyphs[i];
+
+		Vector4 TopColor = Params.TextColorValue, BottomColor = Params.SecondaryTextColorValue;
+
+		if(Border)
+		{
+			TopColor = BottomColor = Params.BorderColorValue;
+		}
+		else
+		{
+			for(long j = (long)Params.ColorRunsValue.size() - 1; j >= 0; j--)
+			{
+				const TextColorRun &Run = Params.ColorRunsValue[j];
+
+				if(i >= Run.Start && i < Run.Start + Run.Length)
+				{
+					TopColor = BottomColor = Run.Color;
+
+					break;
+				};
+			};
+		};
+
+		Vector2 Position = Params.PositionValue + Offset + GlyphPositions[i] + TheGlyph.Offset;
+		Vector2 TexturePosition = TheGlyph.TexturePosition / TextureDimensions,
+			TextureSize = TheGlyph.TextureSize / TextureDimensions;
+
+		Vertices.push_back(Position);
+		Vertices.push_back(Position + Vector2(0, TheGlyph.Size.y));
+		Vertices.push_back(Position + TheGlyph.Size);
+		Vertices.push_back(Position + TheGlyph.Size);
+		Vertices.push_back(Position + Vector2(TheGlyph.Size.x, 0));
+		Vertices.push_back(Position);
+
+		TexCoords.push_back(TexturePosition);
+		TexCoords.push_back(TexturePosition + Vector2(0, TextureSize.y));
+		TexCoords.push_back(TexturePosition + TextureSize);
+		TexCoords.push_back(TexturePosition + TextureSize);
+		TexCoords.push_back(TexturePosition + Vector2(TextureSize.x, 0));
+		TexCoords.push_back(TexturePosition);
+
+		Colors.push_back(TopColor);
+		Colors.push_back(BottomColor);
+		Colors.push_back(BottomColor);
+		Colors.push_back(BottomColor);
+		Colors.push_back(TopColor);
+		Colors.push_back(TopColor);
+
+		FrameStats.QuadCount++;
+	};
+};
+
+void TextEngine::Draw(const sf::String &String, const sf::Font *Font, unsigned long FontSize, const TextParams &Params)
+{
+	if(Font == NULL || String.getSize() == 0)
+		return;
+
+	FrameStats.StringCount++;
+
+	GlyphPage &Page = GetPage(Font, FontSize);
+
+	Layout(Page, String, Font, FontSize);
+
+	Vertices.clear();
+	TexCoords.clear();
+	Colors.clear();
+
+	if(Params.BorderSizeValue > 0)
+	{
+		static const Vector2 BorderDirections[8] = {
+			Vector2(-1, -1), Vector2(0, -1), Vector2(1, -1),
+			Vector2(-1, 0), Vector2(1, 0),
+			Vector2(-1, 1), Vector2(0, 1), Vector2(1, 1)
+		};
+
+		for(unsigned long i = 0; i < 8; i++)
+		{
+			AddGlyphs(Page, String, Params, BorderDirections[i] * Params.BorderSizeValue, true);
+		};
+	};
+
+	AddGlyphs(Page, String, Params, Vector2(), false);
+
+	if(Vertices.size() == 0)
+		return;
+
+	SpriteBatch::Instance.AddGeometry(DrawCommandType::Text, Page.Texture, BlendingMode::Alpha, &Vertices[0], &TexCoords[0], &Colors[0],
+		Vertices.size());
+};
+
+Rect TextEngine::Measure(const sf::String &String, const sf::Font *Font, unsigned long FontSize)
+{
+	if(Font == NULL || String.getSize() == 0)
+		return Rect();
+
+	MetricsKey Key;
+	Key.Hash = CRC32::Instance.CRC((const unsigned char *)String.getData(), String.getSize() * sizeof(sf::Uint32));
+	Key.Font = Font;
+	Key.FontSize = FontSize;
+
+	MetricsMap::iterator it = MetricsIndex.find(Key);
+
+	if(it != MetricsIndex.end())
+	{
+		if(it->second->String == String)
+		{
+			MetricsCounters.Hits++;
+
+			MetricsLRU.splice(MetricsLRU.begin(), MetricsLRU, it->second);
+
+			return it->second->Bounds;
+		};
+
+		//Hash collision, replace the old entry
+		MetricsLRU.erase(it->second);
+		MetricsIndex.erase(it);
+	};
+
+	MetricsCounters.Misses++;
+
+	GlyphPage &Page = GetPage(Font, FontSize);
+
+	Layout(Page, String, Font, FontSize);
+
+	//sf::Text only counts actual glyph quads, whitespace doesn't affect the bounds
+	bool Empty = true;
+	Vector2 Min, Max;
+
+	for(unsigned long i = 0; i < String.getSize(); i++)
+	{
+		if(ResolvedGlyphs[i] == NULL)
+			continue;
+
+		Vector2 TopLeft = GlyphPositions[i] + ResolvedGlyphs[i]->Offset, BottomRight = TopLeft + ResolvedGlyphs[i]->Size;
+
+		if(Empty)
+		{
+			Min = TopLeft;
+			Max = BottomRight;
+			Empty = false;
+
+			continue;
+		};
+
+		if(TopLeft.x < Min.x)
+			Min.x = TopLeft.x;
+
+		if(TopLeft.y < Min.y)
+			Min.y = TopLeft.y;
+
+		if(BottomRight.x > Max.x)
+			Max.x = BottomRight.x;
+
+		if(BottomRight.y > Max.y)
+			Max.y = BottomRight.y;
+	};
+
+	MetricsEntry Entry;
+	Entry.Key = Key;
+	Entry.String = String;
+	Entry.Bounds = Rect(Min.x, Max.x - Min.x, Min.y, Max.y - Min.y);
+
+	MetricsLRU.push_front(Entry);
+	MetricsIndex[Key] = MetricsLRU.begin();
+
+	while(MetricsLRU.size() > MetricsCapacity)
+	{
+		MetricsIndex.erase(MetricsLRU.back().Key);
+		MetricsLRU.pop_back();
+
+		MetricsCounters.Evictions++;
+	};
+
+	return Entry.Bounds;
+};
+
+void TextEngine::BreakLines(const sf::String &String, const sf::Font *Font, unsigned long FontSize, const Vector2 &Size,
+	std::vector<TextLineSpan> &Out)
+{
+	Out.clear();
+
+	if(Font == NULL || String.getSize() == 0)
+		return;
+
+	GlyphPage &Page = GetPage(Font, FontSize);
+
+	if(Page.LineSpacing <= 0 || Size.y < Page.LineSpacing)
+		return;
+
+	unsigned long MaxLines = (unsigned long)(Size.y / Page.LineSpacing);
+
+	ResolvedGlyphs.resize(String.getSize());
+
+	for(unsigned long i = 0; i < String.getSize(); i++)
+	{
+		ResolvedGlyphs[i] = GetGlyph(Page, Font, FontSize, String[i]);
+	};
+
+	//Line holds the extents up to the last break opportunity, Segment the extents of the word after it
+	TextExtents Line, Segment;
+	unsigned long LineStart = 0;
+	long BreakIndex = -1;
+	float x = 0, PenAfterBreak = 0;
+	sf::Uint32 PreviousCharacter = 0;
+
+	for(unsigned long i = 0; i < String.getSize(); i++)
+	{
+		sf::Uint32 Character = String[i];
+
+		if(Character == L'\n')
+		{
+			Line.Merge(Segment);
+
+			if(!PushTextLine(Out, MaxLines, LineStart, i - LineStart, Line))
+				return;
+
+			LineStart = i + 1;
+			BreakIndex = -1;
+			x = 0;
+			PreviousCharacter = 0;
+			Line = Segment = TextExtents();
+
+			continue;
+		};
+
+		x += GetKerning(Page, Font, FontSize, PreviousCharacter, Character);
+		PreviousCharacter = Character;
+
+		if(Character == L' ' || Character == L'\t')
+		{
+			Line.Merge(Segment);
+			Segment = TextExtents();
+
+			x += Character == L' ' ? Page.SpaceAdvance : Page.SpaceAdvance * 4;
+
+			BreakIndex = i;
+			PenAfterBreak = x;
+
+			continue;
+		};
+
+		if(Character == L'\v')
+			continue;
+
+		const Glyph &TheGlyph = *ResolvedGlyphs[i];
+
+		if(x + TheGlyph.Offset.x + TheGlyph.Size.x > Size.x && BreakIndex >= (long)LineStart && Line.Valid)
+		{
+			//Wrap at the last break opportunity and carry the current word over
+			if(!PushTextLine(Out, MaxLines, LineStart, BreakIndex - LineStart, Line))
+				return;
+
+			LineStart = BreakIndex + 1;
+			BreakIndex = -1;
+			x -= PenAfterBreak;
+			Segment.Offset(-PenAfterBreak);
+			Line = TextExtents();
+		};
+
+		if(x + TheGlyph.Offset.x + TheGlyph.Size.x > Size.x && (Line.Valid || Segment.Valid))
+		{
+			//The word doesn't fit on a line of its own, so break it here
+			Line.Merge(Segment);
+
+			if(!PushTextLine(Out, MaxLines, LineStart, i - LineStart, Line))
+				return;
+
+			LineStart = i;
+			BreakIndex = -1;
+			x = 0;
+			Line = Segment = TextExtents();
+		};
+
+		Segment.Add(x + TheGlyph.Offset.x, x + TheGlyph.Offset.x + TheGlyph.Size.x);
+
+		x += TheGlyph.Advance;
+	};
+
+	Line.Merge(Segment);
+
+	if(LineStart < String.getSize())
+		PushTextLine(Out, MaxLines, LineStart, String.getSize() - LineStart, Line);
+};
+
+float TextEngine::GetAdvance(const sf::Font *Font, unsigned long FontSize, sf::Uint32 Character)
+{
+	if(Font == NULL)
+		return 0;
+
+	GlyphPage &Page = GetPage(Font, FontSize);
+
+	switch(Character)
+	{
+	case L' ':
+		return Page.SpaceAdvance;
+	case L'\t':
+		return Page.SpaceAdvance * 4;
+	case L'\n':
+	case L'\v':
+		return 0;
+	};
+
+	return GetGlyph(Page, Font, FontSize, Character)->Advance;
+};
+
+float TextEngine::GetKerning(const sf::Font *Font, unsigned long FontSize, sf::Uint32 First, sf::Uint32 Second)
+{
+	if(Font == NULL)
+		return 0;
+
+	return GetKerning(GetPage(Font, FontSize), Font, FontSize, First, Second);
+};
+
+void TextEngine::GetPrefixAdvances(const sf::String &String, const sf::Font *Font, unsigned long FontSize, std::vector<float> &Out)
+{
+	Out.clear();
+
+	if(Font == NULL || String.getSize() == 0)
+		return;
+
+	GlyphPage &Page = GetPage(Font, FontSize);
+
+	Layout(Page, String, Font, FontSize);
+
+	Out = PenAdvances;
+};
+
+void TextEngine::SetMetricsCacheCapacity(unsigned long Capacity)
+{
+	MetricsCapacity = Capacity;
+
+	while(MetricsLRU.size() > MetricsCapacity)
+	{
+		MetricsIndex.erase(MetricsLRU.back().Key);
+		MetricsLRU.pop_back();
+
+		MetricsCounters.Evictions++;
+	};
+};
+
+void TextEngine::Clear()
+{
+	SpriteBatch::Instance.Flush();
+	GlyphGeneration++;
+
+	Pages.clear();
+	MetricsLRU.clear();
+	MetricsIndex.clear();
+};
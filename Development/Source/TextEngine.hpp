@@ -0,0 +1,380 @@
+#pragma once
+
+/*!
+*	A range of characters drawn with a specific color
+*/
+class TextColorRun
+{
+public:
+	//!<Index of the first character of the run
+	unsigned long Start;
+	//!<Amount of characters in the run
+	unsigned long Length;
+	Vector4 Color;
+
+	TextColorRun() : Start(0), Length(0) {};
+	TextColorRun(unsigned long _Start, unsigned long _Length, const Vector4 &_Color) : Start(_Start), Length(_Length), Color(_Color) {};
+};
+
+/*!
+*	A line of text produced by line breaking, as a range of the original string
+*/
+class TextLineSpan
+{
+public:
+	//!<Index of the first character of the line
+	unsigned long Offset;
+	//!<Amount of characters in the line
+	unsigned long Length;
+	//!<Width of the line's glyphs, as measured by TextEngine::Measure
+	float Width;
+
+	TextLineSpan() : Offset(0), Length(0), Width(0) {};
+};
+
+/*!
+*	Text rendering parameters
+*/
+class TextParams
+{
+public:
+	Vector4 TextColorValue, SecondaryTextColorValue, BorderColorValue;
+	Vector2 PositionValue;
+	float BorderSizeValue;
+	std::vector<TextColorRun> ColorRunsValue;
+
+	TextParams() : BorderSizeValue(0), TextColorValue(1, 1, 1, 1), SecondaryTextColorValue(1, 1, 1, 1), BorderColorValue(0, 0, 0, 1) {}
+	TextParams(const TextParams &o) : BorderSizeValue(o.BorderSizeValue), TextColorValue(o.TextColorValue), SecondaryTextColorValue(o.SecondaryTextColorValue),
+		BorderColorValue(o.BorderColorValue), PositionValue(o.PositionValue), ColorRunsValue(o.ColorRunsValue) {};
+
+	TextParams &operator=(const TextParams &o)
+	{
+		BorderSizeValue = o.BorderSizeValue;
+		TextColorValue = o.TextColorValue;
+		SecondaryTextColorValue = o.SecondaryTextColorValue;
+		BorderColorValue = o.BorderColorValue;
+		PositionValue = o.PositionValue;
+		ColorRunsValue = o.ColorRunsValue;
+
+		return *this;
+	};
+
+	/*!
+	*	Sets the text color
+	*	\param Color the color to use
+	*	\note Changes the secondary color too to prevent issues with using this
+	*	\sa SecondaryColor
+	*/
+	TextParams &Color(const Vector4 &Color)
+	{
+		TextColorValue = SecondaryTextColorValue = Color;
+
+		return *this;
+	};
+
+	/*!
+	*	Sets the secondary text color
+	*	\param SecondaryColor the secondary color to use (used on the bottom of each glyph)
+	*	\sa Color
+	*/
+	TextParams &SecondaryColor(const Vector4 &SecondaryColor)
+	{
+		SecondaryTextColorValue = SecondaryColor;
+
+		return *this;
+	};
+
+	/*!
+	*	Sets the border color for the text
+	*	\param BorderColor the border color to use (default value is 0, 0, 0, 1)
+	*	\sa BorderSize
+	*/
+	TextParams &BorderColor(const Vector4 &BorderColor)
+	{
+		BorderColorValue = BorderColor;
+
+		return *this;
+	};
+
+	/*!
+	*	Sets the border size for the text
+	*	\param BorderSize the size of the border, in pixels (default value is 0)
+	*	\sa BorderColor
+	*/
+	TextParams &BorderSize(float BorderSize)
+	{
+		BorderSizeValue = BorderSize;
+
+		return *this;
+	};
+
+	/*!
+	*	Sets the text position
+	*	\param Position the text's position
+	*/
+	TextParams &Position(const Vector2 &Position)
+	{
+		PositionValue = Position;
+
+		return *this;
+	};
+
+	/*!
+	*	Adds a colored run of characters
+	*	\param Start the index of the first character
+	*	\param Length the amount of characters
+	*	\param Color the color of those characters
+	*	\note Later runs take priority over earlier ones when they overlap
+	*/
+	TextParams &ColorRun(unsigned long Start, unsigned long Length, const Vector4 &Color)
+	{
+		ColorRunsValue.push_back(TextColorRun(Start, Length, Color));
+
+		return *this;
+	};
+};
+
+/*!
+*	Text Engine
+*	Caches glyph metrics per font and size and generates glyph quads directly into the SpriteBatch
+*	\note The glyphs themselves live in the font's per-size texture, which is used as our glyph atlas
+*/
+class TextEngine
+{
+public:
+	/*!
+	*	Text statistics, reset on BeginFrame
+	*/
+	class Stats
+	{
+	public:
+		//!<Amount of strings drawn
+		unsigned long StringCount;
+		//!<Amount of glyph quads generated (borders included)
+		unsigned long QuadCount;
+		//!<Amount of glyphs that weren't cached yet
+		unsigned long GlyphMisses;
+
+		Stats() : StringCount(0), QuadCount(0), GlyphMisses(0) {};
+	};
+
+	/*!
+	*	Text measurement cache statistics, accumulated until ResetMetricsStats
+	*/
+	class MetricsStats
+	{
+	public:
+		//!<Measurements served from the cache
+		unsigned long Hits;
+		//!<Measurements that required a layout
+		unsigned long Misses;
+		//!<Measurements dropped because the cache was full
+		unsigned long Evictions;
+
+		MetricsStats() : Hits(0), Misses(0), Evictions(0) {};
+	};
+private:
+	class Glyph
+	{
+	public:
+		float Advance;
+		//!<Offset and size of the glyph relative to the baseline
+		Vector2 Offset, Size;
+		//!<Glyph area in the font texture, in pixels
+		Vector2 TexturePosition, TextureSize;
+
+		Glyph() : Advance(0) {};
+	};
+
+	typedef std::map<sf::Uint32, Glyph> GlyphMap;
+	typedef std::map<std::pair<sf::Uint32, sf::Uint32>, float> KerningMap;
+
+	class GlyphPage
+	{
+	public:
+		const sf::Texture *Texture;
+		GlyphMap Glyphs;
+		KerningMap Kerning;
+		float SpaceAdvance, LineSpacing;
+
+		GlyphPage() : Texture(NULL), SpaceAdvance(0), LineSpacing(0) {};
+	};
+
+	typedef std::pair<const sf::Font *, unsigned long> PageKey;
+	typedef std::map<PageKey, GlyphPage> PageMap;
+	PageMap Pages;
+
+	class MetricsKey
+	{
+	public:
+		unsigned long Hash;
+		const sf::Font *Font;
+		unsigned long FontSize;
+
+		MetricsKey() : Hash(0), Font(NULL), FontSize(0) {};
+
+		bool operator<(const MetricsKey &o) const
+		{
+			if(Hash != o.Hash)
+				return Hash < o.Hash;
+
+			if(Font != o.Font)
+				return Font < o.Font;
+
+			return FontSize < o.FontSize;
+		};
+	};
+
+	class MetricsEntry
+	{
+	public:
+		MetricsKey Key;
+		//!<Kept around to tell apart strings whose hashes collide
+		sf::String String;
+		Rect Bounds;
+	};
+
+	typedef std::list<MetricsEntry> MetricsList;
+	typedef std::map<MetricsKey, MetricsList::iterator> MetricsMap;
+	//!<Most recently used measurements first
+	MetricsList MetricsLRU;
+	MetricsMap MetricsIndex;
+	unsigned long MetricsCapacity;
+	MetricsStats MetricsCounters;
+
+	//!<Glyph of each character of the last laid out string (NULL for whitespace)
+	std::vector<const Glyph *> ResolvedGlyphs;
+	//!<Pen position of each character of the last laid out string
+	std::vector<Vector2> GlyphPositions;
+	//!<Horizontal pen position after each character of the last laid out string, relative to its line
+	std::vector<float> PenAdvances;
+	std::vector<Vector2> Vertices, TexCoords;
+	std::vector<Vector4> Colors;
+	Stats FrameStats;
+	//!<Incremented whenever a font texture may have changed
+	unsigned long GlyphGeneration;
+
+	GlyphPage &GetPage(const sf::Font *Font, unsigned long FontSize);
+	const Glyph *GetGlyph(GlyphPage &Page, const sf::Font *Font, unsigned long FontSize, sf::Uint32 Character);
+	float GetKerning(GlyphPage &Page, const sf::Font *Font, unsigned long FontSize, sf::Uint32 First, sf::Uint32 Second);
+	void Layout(GlyphPage &Page, const sf::String &String, const sf::Font *Font, unsigned long FontSize);
+	void AddGlyphs(GlyphPage &Page, const sf::String &String, const TextParams &Params, const Vector2 &Offset, bool Border);
+public:
+	static TextEngine Instance;
+
+	TextEngine() : MetricsCapacity(1024), GlyphGeneration(0) {};
+
+	/*!
+	*	Draws a string through the SpriteBatch
+	*	\param String the string to draw
+	*	\param Font the font to use
+	*	\param FontSize the character size to use
+	*	\param Params the text parameters
+	*	\note New glyphs may grow the font texture, so we flush any pending geometry before loading them
+	*/
+	void Draw(const sf::String &String, const sf::Font *Font, unsigned long FontSize, const TextParams &Params);
+
+	/*!
+	*	Measures a string the same way sf::Text::getLocalBounds does
+	*	\param String the string to measure
+	*	\param Font the font to use
+	*	\param FontSize the character size to use
+	*	\return the bounds as (Left, Width, Top, Height)
+	*	\note Results are cached in a bounded LRU keyed by the string's hash, the font, and the size
+	*/
+	Rect Measure(const sf::String &String, const sf::Font *Font, unsigned long FontSize);
+
+	/*!
+	*	Breaks a string into lines that fit inside a rectangle, in a single pass
+	*	\param String the string to break
+	*	\param Font the font to use
+	*	\param FontSize the character size to use
+	*	\param Size the size of the rectangle
+	*	\param Out receives the lines as spans of String
+	*	\note Lines break on spaces, tabs and newlines; words wider than the rectangle are broken between characters
+	*	\note Stops once the next line would no longer fit vertically
+	*/
+	void BreakLines(const sf::String &String, const sf::Font *Font, unsigned long FontSize, const Vector2 &Size,
+		std::vector<TextLineSpan> &Out);
+
+	/*!
+	*	Gets the horizontal advance of a single character
+	*	\param Font the font to use
+	*	\param FontSize the character size to use
+	*	\param Character the character
+	*	\return the advance in pixels, not counting kerning
+	*/
+	float GetAdvance(const sf::Font *Font, unsigned long FontSize, sf::Uint32 Character);
+
+	/*!
+	*	Gets the kerning between two characters
+	*	\param Font the font to use
+	*	\param FontSize the character size to use
+	*	\param First the previous character (or 0 if there's none)
+	*	\param Second the current character
+	*	\return the kerning offset in pixels
+	*/
+	float GetKerning(const sf::Font *Font, unsigned long FontSize, sf::Uint32 First, sf::Uint32 Second);
+
+	/*!
+	*	Calculates the pen position after every character of a string without building any geometry
+	*	\param String the string to lay out
+	*	\param Font the font to use
+	*	\param FontSize the character size to use
+	*	\param Out receives, for each character, the horizontal pen position after it (relative to its line)
+	*/
+	void GetPrefixAdvances(const sf::String &String, const sf::Font *Font, unsigned long FontSize, std::vector<float> &Out);
+
+	/*!
+	*	Sets the maximum amount of cached measurements
+	*	\param Capacity the amount of measurements to keep
+	*/
+	void SetMetricsCacheCapacity(unsigned long Capacity);
+
+	/*!
+	*	\return the text measurement cache statistics
+	*/
+	const MetricsStats &GetMetricsStats() const
+	{
+		return MetricsCounters;
+	};
+
+	/*!
+	*	Resets the text measurement cache statistics
+	*/
+	void ResetMetricsStats()
+	{
+		MetricsCounters = MetricsStats();
+	};
+
+	/*!
+	*	Clears all cached glyphs
+	*	\note Must be called when a font we've drawn with is destroyed
+	*/
+	void Clear();
+
+	/*!
+	*	\return a number that changes whenever a font texture may have grown or been destroyed
+	*	\note Retained text geometry holds normalized texture coordinates, so it must be regenerated when this changes
+	*/
+	unsigned long GetGlyphGeneration() const
+	{
+		return GlyphGeneration;
+	};
+
+	/*!
+	*	Resets the frame statistics
+	*/
+	void BeginFrame()
+	{
+		FrameStats = Stats();
+	};
+
+	/*!
+	*	\return the statistics since the last BeginFrame
+	*/
+	const Stats &GetStats() const
+	{
+		return FrameStats;
+	};
+};
@@ -0,0 +1,270 @@
+#include <map>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <stdio.h>
+#include <GL/glew.h>
+#include <SFML/Graphics.hpp>
+#include <math.h>
+#include "SuperSmartPointer.hpp"
+#include "StringID.hpp"
+#include "Math.hpp"
+#include "TextureAtlas.hpp"
+#include "Future.hpp"
+#include "ThreadPool.hpp"
+
+class AtlasItem
+{
+public:
+	std::string Path;
+	SuperSmartPointer<sf::Image> Image;
+	unsigned long x, y, Page;
+	bool Packed, Loaded;
+
+	AtlasItem() : x(0), y(0), Page(0), Packed(false), Loaded(false) {};
+};
+
+/*!
+*	Counts the images that finished decoding, from any thread
+*/
+class AtlasDecodeProgress
+{
+	sf::Mutex Lock;
+	unsigned long Finished;
+public:
+	AtlasDecodeProgress() : Finished(0) {};
+
+	void Finish()
+	{
+		sf::Lock Guard(Lock);
+
+		Finished++;
+	};
+
+	unsigned long GetFinished()
+	{
+		sf::Lock Guard(Lock);
+
+		return Finished;
+	};
+};
+
+class AtlasDecodeJob : public ThreadPoolJob
+{
+	AtlasItem *Item;
+	AtlasDecodeProgress *Progress;
+public:
+	AtlasDecodeJob(AtlasItem *Item, AtlasDecodeProgress *Progress) : Item(Item), Progress(Progress) {};
+
+	void Run()
+	{
+		Item->Loaded = Item->Image->loadFromFile(Item->Path);
+
+		//Build may return as soon as this is counted, so nothing can be touched afterwards
+		Progress->Finish();
+	};
+};
+
+bool AtlasItemHeightSort(const AtlasItem *a, const AtlasItem *b)
+{
+	return a->Image->getSize().y > b->Image->getSize().y;
+};
+
+void TextureAtlas::Clear()
+{
+	TextureEntries.clear();
+	Entries.clear();
+	Pages.clear();
+};
+
+void TextureAtlas::Build(const std::vector<std::string> &Paths)
+{
+	Clear();
+
+	PageSize = DefaultPageSize;
+
+	if(sf::Texture::getMaximumSize() < PageSize)
+		PageSize = sf::Texture::getMaximumSize();
+
+	std::vector<AtlasItem> Candidates;
+	std::vector<StringID> CandidateIDs;
+	Candidates.reserve(Paths.size());
+
+	for(unsigned long i = 0; i < Paths.size(); i++)
+	{
+		StringID PathID = MakeStringID(Paths[i]);
+
+		if(std::find(CandidateIDs.begin(), CandidateIDs.end(), PathID) != CandidateIDs.end())
+			continue;
+
+		AtlasItem Item;
+		Item.Path = Paths[i];
+		Item.Image.Reset(new sf::Image());
+
+		Candidates.push_back(Item);
+		CandidateIDs.push_back(PathID);
+	};
+
+	//Decode on the workers since every image is needed before packing, then wait for all of them
+	AtlasDecodeProgress Progress;
+
+	for(unsigned long i = 0; i < Candidates.size(); i++)
+	{
+		ThreadPool::Instance.Submit(new AtlasDecodeJob(&Candidates[i], &Progress));
+	};
+
+	while(Progress.GetFinished() < Candidates.size())
+	{
+		sf::sleep(sf::milliseconds(1));
+	};
+
+	std::vector<AtlasItem> Items;
+	Items.reserve(Candidates.size());
+
+	for(unsigned long i = 0; i < Candidates.size(); i++)
+	{
+		AtlasItem &Item = Candidates[i];
+
+		if(!Item.Loaded)
+		{
+			printf("Unable to load texture '%s' into the texture atlas\n", Item.Path.c_str());
+
+			continue;
+		};
+
+		Entry &TheEntry = Entries[CandidateIDs[i]];
+		TheEntry.Source.Reset(new sf::Texture());
+
+		if(!TheEntry.Source->loadFromImage(*Item.Image))
+		{
+			Entries.erase(CandidateIDs[i]);
+
+			continue;
+		};
+
+		TextureEntries[TheEntry.Source.Get()] = &TheEntry;
+
+		Items.push_back(Item);
+	};
+
+	//Shelf packing: tallest first, fill rows left to right, new row when full, new page when out of rows
+	std::vector<AtlasItem *> Sorted;
+
+	for(unsigned long i = 0; i < Items.size(); i++)
+	{
+		Sorted.push_back(&Items[i]);
+	};
+
+	std::sort(Sorted.begin(), Sorted.end(), AtlasItemHeightSort);
+
+	std::vector<unsigned long> PageHeights;
+	unsigned long ShelfX = 0, ShelfY = 0, ShelfHeight = 0;
+
+	for(unsigned long i = 0; i < Sorted.size(); i++)
+	{
+		AtlasItem &Item = *Sorted[i];
+		unsigned long Width = Item.Image->getSize().x + Padding, Height = Item.Image->getSize().y + Padding;
+
+		if(Width > PageSize || Height > PageSize)
+			continue;
+
+		if(PageHeights.size() == 0)
+			PageHeights.push_back(0);
+
+		if(ShelfX + Width > PageSize)
+		{
+			ShelfX = 0;
+			ShelfY += ShelfHeight;
+			ShelfHeight = 0;
+		};
+
+		if(ShelfY + Height > PageSize)
+		{
+			PageHeights.push_back(0);
+			ShelfX = ShelfY = ShelfHeight = 0;
+		};
+
+		Item.x = ShelfX;
+		Item.y = ShelfY;
+		Item.Page = PageHeights.size() - 1;
+		Item.Packed = true;
+
+		ShelfX += Width;
+
+		if(Height > ShelfHeight)
+			ShelfHeight = Height;
+
+		if(PageHeights.back() < ShelfY + ShelfHeight)
+			PageHeights.back() = ShelfY + ShelfHeight;
+	};
+
+	for(unsigned long i = 0; i < PageHeights.size(); i++)
+	{
+		sf::Image PageImage;
+		PageImage.create(PageSize, PageHeights[i], sf::Color(0, 0, 0, 0));
+
+		for(unsigned long j = 0; j < Items.size(); j++)
+		{
+			if(!Items[j].Packed || Items[j].Page != i)
+				continue;
+
+			PageImage.copy(*Items[j].Image, Items[j].x, Items[j].y);
+		};
+
+		SuperSmartPointer<sf::Texture> Page(new sf::Texture());
+
+		if(!Page->loadFromImage(PageImage))
+		{
+			printf("Unable to create texture atlas page %lu (%lux%lu)\n", i, PageSize, PageHeights[i]);
+
+			Page.Dispose();
+		};
+
+		Pages.push_back(Page);
+	};
+
+	for(unsigned long i = 0; i < Items.size(); i++)
+	{
+		if(!Items[i].Packed || Pages[Items[i].Page].Get() == NULL)
+			continue;
+
+		Entry &TheEntry = Entries[MakeStringID(Items[i].Path)];
+		TheEntry.Page = Items[i].Page;
+		TheEntry.Region = Rect((float)Items[i].x, (float)(Items[i].x + Items[i].Image->getSize().x), (float)Items[i].y,
+			(float)(Items[i].y + Items[i].Image->getSize().y));
+	};
+};
+
+SuperSmartPointer<sf::Texture> TextureAtlas::GetTexture(const std::string &Path)
+{
+	EntryMap::iterator it = Entries.find(MakeStringID(Path));
+
+	if(it == Entries.end())
+		return SuperSmartPointer<sf::Texture>();
+
+	return it->second.Source;
+};
+
+bool TextureAtlas::Remap(const sf::Texture *&Texture, Vector2 *TexCoords, unsigned long Count)
+{
+	if(Texture == NULL)
+		return false;
+
+	TextureMap::iterator it = TextureEntries.find(Texture);
+
+	if(it == TextureEntries.end() || it->second->Page == -1)
+		return false;
+
+	const sf::Texture *Page = Pages[it->second->Page].Get();
+	Vector2 PageDimensions((float)Page->getSize().x, (float)Page->getSize().y);
+	Vector2 RegionPosition = it->second->Region.Position() / PageDimensions, RegionSize = it->second->Region.Size() / PageDimensions;
+
+	for(unsigned long i = 0; i < Count; i++)
+	{
+		TexCoords[i] = RegionPosition + TexCoords[i] * RegionSize;
+	};
+
+	Texture = Page;
+
+	return true;
+};
@@ -0,0 +1,78 @@
+#pragma once
+/*!
+*	Texture Atlas
+*	Packs many small textures into one or a few large pages so they can share a single texture bind
+*	\note Textures too large for a page are kept standalone and are never remapped
+*/
+class TextureAtlas
+{
+public:
+	/*!
+	*	Default page width and height, clamped to the maximum texture size
+	*/
+	static const unsigned long DefaultPageSize = 1024;
+
+	/*!
+	*	Empty pixels between packed textures, so filtering never picks up a neighbour
+	*/
+	static const unsigned long Padding = 1;
+private:
+	class Entry
+	{
+	public:
+		//!<The standalone texture widgets hold (used for its size and as a fallback)
+		SuperSmartPointer<sf::Texture> Source;
+		//!<Index of the page this texture lives in, or -1 if it isn't packed
+		long Page;
+		//!<Region of the page, in pixels
+		Rect Region;
+
+		Entry() : Page(-1) {};
+	};
+
+	typedef std::map<StringID, Entry> EntryMap;
+	EntryMap Entries;
+
+	typedef std::map<const sf::Texture *, Entry *> TextureMap;
+	TextureMap TextureEntries;
+
+	std::vector<SuperSmartPointer<sf::Texture> > Pages;
+	unsigned long PageSize;
+public:
+	TextureAtlas() : PageSize(DefaultPageSize) {};
+
+	/*!
+	*	Loads and packs textures, replacing whatever was packed before
+	*	\param Paths the texture file names
+	*/
+	void Build(const std::vector<std::string> &Paths);
+
+	/*!
+	*	Releases all pages and entries
+	*/
+	void Clear();
+
+	/*!
+	*	Gets a texture that was part of the last Build
+	*	\param Path the texture's file name
+	*	\return the texture, or Empty if it wasn't built into this atlas
+	*/
+	SuperSmartPointer<sf::Texture> GetTexture(const std::string &Path);
+
+	/*!
+	*	Redirects a texture and its texture coordinates into atlas space
+	*	\param Texture the texture to remap, replaced by the page texture if found
+	*	\param TexCoords the normalized texture coordinates to remap
+	*	\param Count the amount of texture coordinates
+	*	\return whether the texture was packed into this atlas
+	*/
+	bool Remap(const sf::Texture *&Texture, Vector2 *TexCoords, unsigned long Count);
+
+	/*!
+	*	\return the amount of pages in use
+	*/
+	unsigned long GetPageCount() const
+	{
+		return Pages.size();
+	};
+};
@@ -0,0 +1,259 @@
+#include <map>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <stdio.h>
+#include <GL/glew.h>
+#include <SFML/Graphics.hpp>
+#include "SuperSmartPointer.hpp"
+#include "StringID.hpp"
+#include "TextureCache.hpp"
+#include "Future.hpp"
+#include "ThreadPool.hpp"
+
+/*!
+*	Decodes a texture's image on a worker thread
+*/
+class TextureLoadJob : public ThreadPoolJob
+{
+public:
+	//!<The cache that wants the image, or NULL if it no longer exists
+	TextureCache *Cache;
+	std::string Path;
+	SuperSmartPointer<sf::Image> Image;
+	bool Loaded;
+
+	TextureLoadJob(TextureCache *Cache, const std::string &Path) : Cache(Cache), Path(Path), Image(new sf::Image()), Loaded(false) {};
+
+	~TextureLoadJob()
+	{
+		if(Cache)
+			Cache->ForgetLoad(this);
+	};
+
+	void Run()
+	{
+		Loaded = Image->loadFromFile(Path);
+	};
+
+	void Complete()
+	{
+		if(!Cache)
+			return;
+
+		TextureCache *Owner = Cache;
+		Cache = NULL;
+
+		Owner->FinishLoad(this, Path, Loaded ? Image : SuperSmartPointer<sf::Image>());
+	};
+};
+
+TextureCache::~TextureCache()
+{
+	for(unsigned long i = 0; i < Loads.size(); i++)
+	{
+		Loads[i]->Cache = NULL;
+	};
+
+	Clear();
+};
+
+SuperSmartPointer<sf::Texture> TextureCache::Get(const std::string &Path)
+{
+	StringID PathID = MakeStringID(Path);
+
+	EntryMap::iterator it = Entries.find(PathID);
+
+	if(it != Entries.end() && it->second.Texture.Get())
+	{
+		CacheStats.Hits++;
+
+		return it->second.Texture;
+	};
+
+	CacheStats.Misses++;
+
+	SuperSmartPointer<sf::Texture> Out(new sf::Texture());
+
+	if(!Out->loadFromFile(Path))
+	{
+		Out.Dispose();
+
+		return Out;
+	};
+
+	Add(Path, Out);
+
+	return Out;
+};
+
+SuperSmartPointer<sf::Texture> TextureCache::GetAsync(const std::string &Path)
+{
+	StringID PathID = MakeStringID(Path);
+
+	EntryMap::iterator it = Entries.find(PathID);
+
+	if(it != Entries.end() && it->second.Texture.Get())
+	{
+		CacheStats.Hits++;
+
+		return it->second.Texture;
+	};
+
+	CacheStats.Misses++;
+
+	SuperSmartPointer<sf::Texture> Out(new sf::Texture());
+
+	Entry &TheEntry = Entries[PathID];
+	TheEntry.Texture = Out;
+	TheEntry.Bytes = 0;
+
+	Out.SetReleaseCounter(&ReleasedReferences);
+
+	TextureLoadJob *Job = new TextureLoadJob(this, Path);
+
+	Loads.push_back(Job);
+
+	ThreadPool::Instance.Submit(Job);
+
+	return Out;
+};
+
+void TextureCache::FinishLoad(TextureLoadJob *Job, const std::string &Path, SuperSmartPointer<sf::Image> Image)
+{
+	ForgetLoad(Job);
+
+	if(!Image.Get())
+	{
+		printf("Unable to load texture '%s'\n", Path.c_str());
+
+		EntryMap::iterator it = Entries.find(MakeStringID(Path));
+
+		//Don't serve the empty texture as a hit forever, unless something else was added under the same path meanwhile
+		if(it != Entries.end() && it->second.Bytes == 0)
+			Evict(it);
+
+		return;
+	};
+
+	PendingUpload Item;
+	Item.Path = Path;
+	Item.Image = Image;
+
+	Uploads.push_back(Item);
+};
+
+void TextureCache::ForgetLoad(TextureLoadJob *Job)
+{
+	std::vector<TextureLoadJob *>::iterator it = std::find(Loads.begin(), Loads.end(), Job);
+
+	if(it != Loads.end())
+		Loads.erase(it);
+};
+
+unsigned long TextureCache::Upload(unsigned long long Budget)
+{
+	unsigned long Count = 0;
+	unsigned long long Uploaded = 0;
+
+	while(Uploads.size())
+	{
+		PendingUpload &Item = Uploads.front();
+		unsigned long long Bytes = (unsigned long long)Item.Image->getSize().x * Item.Image->getSize().y * 4;
+
+		if(Count && Uploaded + Bytes > Budget)
+			break;
+
+		EntryMap::iterator it = Entries.find(MakeStringID(Item.Path));
+
+		//Loading into the shared texture updates everyone holding it. It's gone if Collect evicted it meanwhile
+		if(it != Entries.end() && it->second.Texture.Get() && it->second.Texture->loadFromImage(*Item.Image))
+		{
+			CacheStats.Bytes += Bytes - it->second.Bytes;
+			it->second.Bytes = Bytes;
+		};
+
+		Uploaded += Bytes;
+		Count++;
+
+		Uploads.pop_front();
+	};
+
+	return Count;
+};
+
+void TextureCache::WaitForPending()
+{
+	while(GetPendingCount())
+	{
+		Future::Instance.Update();
+
+		Upload((unsigned long long)-1);
+
+		if(Loads.size())
+			sf::sleep(sf::milliseconds(1));
+	};
+};
+
+void TextureCache::Add(const std::string &Path, SuperSmartPointer<sf::Texture> Texture)
+{
+	if(Texture.Get() == NULL)
+		return;
+
+	Entry &TheEntry = Entries[MakeStringID(Path)];
+
+	CacheStats.Bytes -= TheEntry.Bytes;
+
+	if(TheEntry.Texture.Get() != Texture.Get())
+		TheEntry.Texture.SetReleaseCounter(NULL);
+
+	TheEntry.Texture = Texture;
+	TheEntry.Texture.SetReleaseCounter(&ReleasedReferences);
+	TheEntry.Bytes = (unsigned long long)Texture->getSize().x * Texture->getSize().y * 4;
+
+	CacheStats.Bytes += TheEntry.Bytes;
+};
+
+void TextureCache::Evict(EntryMap::iterator it)
+{
+	it->second.Texture.SetReleaseCounter(NULL);
+
+	CacheStats.Bytes -= it->second.Bytes;
+
+	Entries.erase(it);
+};
+
+void TextureCache::Collect()
+{
+	//Nobody let go of one of our textures, so we can't hold the only reference to any of them
+	if(ReleasedReferences == CollectedReferences)
+		return;
+
+	CollectedReferences = ReleasedReferences;
+
+	for(EntryMap::iterator it = Entries.begin(); it != Entries.end();)
+	{
+		//Our own reference is the only observer left
+		if(it->second.Texture.ObserverCount() <= 1)
+		{
+			CacheStats.Evictions++;
+
+			Evict(it++);
+
+			continue;
+		};
+
+		it++;
+	};
+};
+
+void TextureCache::Clear()
+{
+	for(EntryMap::iterator it = Entries.begin(); it != Entries.end(); it++)
+	{
+		it->second.Texture.SetReleaseCounter(NULL);
+	};
+
+	Entries.clear();
+	CacheStats.Bytes = 0;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+//!<How many bytes of decoded textures UIManager uploads per Update, at most (at least one texture is always uploaded)
+#define TEXTURECACHE_UPLOAD_BUDGET (1024 * 1024 * 4)
+
+class TextureLoadJob;
+
+/*!
+*	Texture Cache
+*	Shares textures loaded from disk between everyone that requests the same path
+*	\note Textures are evicted by Collect once the cache holds the only reference to them
+*	\note Collect only looks at the entries after a reference to one of them was released
+*	\note Textures requested with GetAsync are decoded on the ThreadPool and uploaded by Upload on the main thread
+*/
+class TextureCache
+{
+	friend class TextureLoadJob;
+public:
+	/*!
+	*	Cache statistics
+	*/
+	class Stats
+	{
+	public:
+		//!<Requests served from the cache
+		unsigned long Hits;
+		//!<Requests that had to load from disk
+		unsigned long Misses;
+		//!<Entries evicted because nobody referenced them anymore
+		unsigned long Evictions;
+		//!<Approximate texture memory held by the cache, in bytes
+		unsigned long long Bytes;
+
+		Stats() : Hits(0), Misses(0), Evictions(0), Bytes(0) {};
+	};
+private:
+	class Entry
+	{
+	public:
+		SuperSmartPointer<sf::Texture> Texture;
+		unsigned long long Bytes;
+
+		Entry() : Bytes(0) {};
+	};
+
+	class PendingUpload
+	{
+	public:
+		std::string Path;
+		SuperSmartPointer<sf::Image> Image;
+	};
+
+	typedef std::map<StringID, Entry> EntryMap;
+	EntryMap Entries;
+	Stats CacheStats;
+	//!<Incremented by our textures whenever we may be left holding their only reference, and its value at the last Collect
+	unsigned long ReleasedReferences, CollectedReferences;
+
+	//!<Loads that weren't decoded yet, so they can be detached if the cache goes away first
+	std::vector<TextureLoadJob *> Loads;
+	//!<Decoded images waiting for Upload, oldest first
+	std::deque<PendingUpload> Uploads;
+
+	TextureCache(const TextureCache &);
+	TextureCache &operator=(const TextureCache &);
+
+	/*!
+	*	Called on the main thread once a load was decoded
+	*	\param Job the job that decoded it
+	*	\param Path the texture's file name
+	*	\param Image the decoded image, or Empty if it failed to load
+	*/
+	void FinishLoad(TextureLoadJob *Job, const std::string &Path, SuperSmartPointer<sf::Image> Image);
+
+	/*!
+	*	Forgets a load that will never finish
+	*	\param Job the job that won't finish
+	*/
+	void ForgetLoad(TextureLoadJob *Job);
+
+	/*!
+	*	Removes an entry, so its texture no longer reports to us
+	*/
+	void Evict(EntryMap::iterator it);
+public:
+	TextureCache() : ReleasedReferences(0), CollectedReferences(0) {};
+	~TextureCache();
+
+	/*!
+	*	Gets a texture, loading it if it's not cached
+	*	\param Path the texture's file name
+	*	\return the shared texture, or Empty if it failed to load
+	*/
+	SuperSmartPointer<sf::Texture> Get(const std::string &Path);
+
+	/*!
+	*	Gets a texture, decoding it on a worker thread if it's not cached
+	*	\param Path the texture's file name
+	*	\return the shared texture, which stays empty (0x0) until it's uploaded
+	*	\note A texture that fails to load stays empty, and is dropped from the cache so the next request tries again
+	*/
+	SuperSmartPointer<sf::Texture> GetAsync(const std::string &Path);
+
+	/*!
+	*	Uploads decoded textures, oldest first
+	*	\param Budget how many bytes to upload, at most (at least one texture is always uploaded)
+	*	\return the amount of textures uploaded
+	*/
+	unsigned long Upload(unsigned long long Budget);
+
+	/*!
+	*	Waits until every texture requested with GetAsync is decoded and uploaded
+	*	\note Runs Future::Update while waiting, since that's where decoded textures are handed back
+	*/
+	void WaitForPending();
+
+	/*!
+	*	\return the amount of textures requested with GetAsync that weren't uploaded yet
+	*/
+	unsigned long GetPendingCount() const
+	{
+		return Loads.size() + Uploads.size();
+	};
+
+	/*!
+	*	\return whether there are decoded textures waiting for Upload
+	*/
+	bool HasPendingUploads() const
+	{
+		return Uploads.size() != 0;
+	};
+
+	/*!
+	*	Adds an already loaded texture to the cache
+	*	\param Path the texture's file name
+	*	\param Texture the texture to share under that path
+	*/
+	void Add(const std::string &Path, SuperSmartPointer<sf::Texture> Texture);
+
+	/*!
+	*	Evicts every texture that is only referenced by the cache
+	*	\note Does nothing unless a reference to a cached texture was released since the last time
+	*/
+	void Collect();
+
+	/*!
+	*	Releases all of the cache's references
+	*/
+	void Clear();
+
+	/*!
+	*	\return the amount of cached textures
+	*/
+	unsigned long GetCount() const
+	{
+		return Entries.size();
+	};
+
+	/*!
+	*	\return the cache statistics
+	*/
+	const Stats &GetStats() const
+	{
+		return CacheStats;
+	};
+};
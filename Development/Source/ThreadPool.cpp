@@ -0,0 +1,242 @@
+#include <map>
+#include <vector>
+#include <deque>
+#include <SFML/System.hpp>
+#include "StringID.hpp"
+#include "SuperSmartPointer.hpp"
+#include "Signal.h"
+#include "Delegate.h"
+using namespace Gallant;
+#include "Future.hpp"
+#include "ThreadPool.hpp"
+
+ThreadPool ThreadPool::Instance;
+
+/*!
+*	Completes a finished job on the main thread
+*/
+class ThreadPoolCompletion : public FutureCallback
+{
+	ThreadPool *Pool;
+	ThreadPoolJob *Job;
+public:
+	ThreadPoolCompletion(ThreadPool *Pool, ThreadPoolJob *Job) : Pool(Pool), Job(Job) {};
+
+	~ThreadPoolCompletion()
+	{
+		delete Job;
+	};
+
+	void Call()
+	{
+		Pool->PendingJobs--;
+
+		if(Pool->PendingJobs == 0)
+			Pool->Park();
+
+		Job->Complete();
+	};
+};
+
+ThreadPool::~ThreadPool()
+{
+	Stop();
+};
+
+bool ThreadPool::IsRunning()
+{
+	sf::Lock Lock(RunningLock);
+
+	return Running;
+};
+
+void ThreadPool::WorkerMain(ThreadPoolWorker *Worker)
+{
+	unsigned long IdleTime = 0;
+
+	while(Worker->Pool->IsRunning())
+	{
+		ThreadPoolJob *Job = Worker->Pool->TakeJob(Worker);
+
+		if(!Job)
+		{
+			//Back off while other workers run the pending jobs, since one of them may submit more
+			IdleTime = IdleTime == 0 ? 1 : (IdleTime * 2 > THREADPOOL_MAXIMUM_IDLE_TIME ? THREADPOOL_MAXIMUM_IDLE_TIME : IdleTime * 2);
+
+			sf::sleep(sf::milliseconds(IdleTime));
+
+			//Once nothing is pending, block until a job is submitted or the pool stops, then look again right away
+			{
+				sf::Lock Lock(Worker->Pool->ParkLock);
+			};
+
+			continue;
+		};
+
+		IdleTime = 0;
+
+		Job->Run();
+
+		Worker->Pool->Finish(Job);
+	};
+};
+
+ThreadPoolJob *ThreadPool::TakeJob(ThreadPoolWorker *Worker)
+{
+	{
+		sf::Lock Lock(Worker->Lock);
+
+		//Oldest first, so jobs that were submitted early can't be starved by newer ones
+		if(Worker->Jobs.size())
+		{
+			ThreadPoolJob *Job = Worker->Jobs.front();
+			Worker->Jobs.pop_front();
+
+			return Job;
+		};
+	};
+
+	//Steal the newest job of the next worker that has any, which its owner would run last
+	for(unsigned long i = 1; i < Workers.size(); i++)
+	{
+		ThreadPoolWorker *Victim = Workers[(Worker->Index + i) % Workers.size()];
+
+		sf::Lock Lock(Victim->Lock);
+
+		if(Victim->Jobs.size())
+		{
+			ThreadPoolJob *Job = Victim->Jobs.back();
+			Victim->Jobs.pop_back();
+
+			return Job;
+		};
+	};
+
+	return NULL;
+};
+
+void ThreadPool::Finish(ThreadPoolJob *Job)
+{
+	Future::Instance.PostFromThread(new ThreadPoolCompletion(this, Job));
+};
+
+void ThreadPool::Park()
+{
+	if(Parked || Workers.size() == 0)
+		return;
+
+	Parked = true;
+
+	ParkLock.lock();
+};
+
+void ThreadPool::Unpark()
+{
+	if(!Parked)
+		return;
+
+	Parked = false;
+
+	ParkLock.unlock();
+};
+
+void ThreadPool::Start(unsigned long WorkerCount)
+{
+	if(Workers.size() || WorkerCount == 0)
+		return;
+
+	{
+		sf::Lock Lock(RunningLock);
+
+		Running = true;
+	};
+
+	for(unsigned long i = 0; i < WorkerCount; i++)
+	{
+		ThreadPoolWorker *Worker = new ThreadPoolWorker();
+		Worker->Pool = this;
+		Worker->Index = i;
+		Worker->Thread = new sf::Thread(&ThreadPool::WorkerMain, Worker);
+
+		Workers.push_back(Worker);
+	};
+
+	//Workers start parked, unless jobs that ran before we started are still waiting to complete
+	if(PendingJobs == 0)
+		Park();
+
+	//Launch after every worker exists, since they steal from each other
+	for(unsigned long i = 0; i < Workers.size(); i++)
+	{
+		Workers[i]->Thread->launch();
+	};
+};
+
+void ThreadPool::Stop()
+{
+	if(Workers.size() == 0)
+		return;
+
+	{
+		sf::Lock Lock(RunningLock);
+
+		Running = false;
+	};
+
+	//Parked workers must wake up to see we stopped
+	Unpark();
+
+	for(unsigned long i = 0; i < Workers.size(); i++)
+	{
+		Workers[i]->Thread->wait();
+	};
+
+	for(unsigned long i = 0; i < Workers.size(); i++)
+	{
+		PendingJobs -= Workers[i]->Jobs.size();
+
+		for(unsigned long j = 0; j < Workers[i]->Jobs.size(); j++)
+		{
+			delete Workers[i]->Jobs[j];
+		};
+
+		delete Workers[i]->Thread;
+		delete Workers[i];
+	};
+
+	Workers.clear();
+};
+
+void ThreadPool::Submit(ThreadPoolJob *Job)
+{
+	PendingJobs++;
+
+	if(Workers.size() == 0)
+	{
+		Job->Run();
+
+		Finish(Job);
+
+		return;
+	};
+
+	ThreadPoolWorker *Worker = Workers[NextWorker++ % Workers.size()];
+
+	{
+		sf::Lock Lock(Worker->Lock);
+
+		Worker->Jobs.push_back(Job);
+	};
+
+	Unpark();
+};
+
+bool ThreadPool::GetTimeUntilNext(unsigned long &Milliseconds) const
+{
+	if(PendingJobs == 0)
+		return false;
+
+	Milliseconds = THREADPOOL_POLL_TIME;
+
+	return true;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+//!<How long an idle worker sleeps before looking for work again while jobs are pending, at most, in milliseconds
+#define THREADPOOL_MAXIMUM_IDLE_TIME 8
+//!<How often the main loop should check for finished jobs while some are running, in milliseconds
+#define THREADPOOL_POLL_TIME 5
+
+/*!
+*	A job for the ThreadPool
+*	\note Run is called on a worker thread and must not touch UI objects; Complete is called on the main thread afterwards
+*/
+class ThreadPoolJob
+{
+public:
+	virtual ~ThreadPoolJob() {};
+
+	/*!
+	*	Does the work, on a worker thread
+	*/
+	virtual void Run() = 0;
+
+	/*!
+	*	Uses the results, on the main thread during Future::Update
+	*/
+	virtual void Complete() {};
+};
+
+/*!
+*	A job that calls a function on a worker thread and a member with its result on the main thread
+*/
+template<class Class, class Result, class Argument>
+class ThreadPoolFunctionJob : public ThreadPoolJob
+{
+	Result (*Function)(const Argument &);
+	Argument Value;
+	Result Output;
+	Class *Instance;
+	void (Class::*Continuation)(Result &);
+public:
+	ThreadPoolFunctionJob(Result (*Function)(const Argument &), const Argument &Value, Class *Instance,
+		void (Class::*Continuation)(Result &)) : Function(Function), Value(Value), Instance(Instance), Continuation(Continuation) {};
+
+	void Run()
+	{
+		Output = Function(Value);
+	};
+
+	void Complete()
+	{
+		(Instance->*Continuation)(Output);
+	};
+};
+
+class ThreadPool;
+
+class ThreadPoolWorker
+{
+public:
+	ThreadPool *Pool;
+	unsigned long Index;
+	sf::Thread *Thread;
+	//!<Locks Jobs, since other workers steal from it
+	sf::Mutex Lock;
+	//!<Jobs are submitted to the back; the owner takes them from the front, thieves from the back
+	std::deque<ThreadPoolJob *> Jobs;
+
+	ThreadPoolWorker() : Pool(NULL), Index(0), Thread(NULL) {};
+};
+
+/*!
+*	Thread Pool
+*	Runs jobs on worker threads and sends them back to the main thread through Future
+*	\note Jobs are spread among the workers, and a worker with nothing to do steals from the others
+*	\note Submit and Update must be called from the main thread
+*/
+class ThreadPool
+{
+	friend class ThreadPoolCompletion;
+private:
+	std::vector<ThreadPoolWorker *> Workers;
+	sf::Mutex RunningLock;
+	bool Running;
+	//!<Held by the main thread while no jobs are pending, so idle workers block on it instead of polling
+	sf::Mutex ParkLock;
+	//!<Only used on the main thread
+	unsigned long NextWorker, PendingJobs;
+	//!<Whether the main thread holds ParkLock, only used on the main thread
+	bool Parked;
+
+	ThreadPool(const ThreadPool &);
+	ThreadPool &operator=(const ThreadPool &);
+
+	static void WorkerMain(ThreadPoolWorker *Worker);
+
+	bool IsRunning();
+
+	/*!
+	*	Takes a job from a worker's own queue, or steals one from another worker
+	*	\param Worker the worker looking for a job
+	*	\return the job or NULL if there was none
+	*/
+	ThreadPoolJob *TakeJob(ThreadPoolWorker *Worker);
+
+	/*!
+	*	Hands a finished job to Future, from a worker thread
+	*/
+	void Finish(ThreadPoolJob *Job);
+
+	/*!
+	*	Makes idle workers block until Unpark is called, from the main thread
+	*/
+	void Park();
+
+	/*!
+	*	Lets parked workers look for jobs again, from the main thread
+	*/
+	void Unpark();
+public:
+	static ThreadPool Instance;
+
+	ThreadPool() : Running(false), NextWorker(0), PendingJobs(0), Parked(false) {};
+	~ThreadPool();
+
+	/*!
+	*	Starts the worker threads
+	*	\param WorkerCount how many threads to use
+	*	\note Until this is called, jobs are run right away when submitted
+	*/
+	void Start(unsigned long WorkerCount);
+
+	/*!
+	*	Stops the worker threads after they finish their current jobs
+	*	\note Jobs that didn't start are deleted without being run
+	*/
+	void Stop();
+
+	/*!
+	*	Submits a job
+	*	\param Job the job, which the pool now owns and deletes after Complete is called
+	*/
+	void Submit(ThreadPoolJob *Job);
+
+	/*!
+	*	Runs Function(Value) on a worker thread, then (Instance->*Continuation)(Result) on the main thread
+	*/
+	template<class Class, class Result, class Argument> void Submit(Result (*Function)(const Argument &), const Argument &Value,
+		Class *Instance, void (Class::*Continuation)(Result &))
+	{
+		Submit(new ThreadPoolFunctionJob<Class, Result, Argument>(Function, Value, Instance, Continuation));
+	};
+
+	/*!
+	*	\return how many jobs were submitted and weren't completed yet
+	*/
+	unsigned long GetPendingJobCount() const
+	{
+		return PendingJobs;
+	};
+
+	/*!
+	*	Gets how long the main loop may wait before checking for finished jobs
+	*	\param Milliseconds receives the time
+	*	\return whether any jobs are pending
+	*/
+	bool GetTimeUntilNext(unsigned long &Milliseconds) const;
+};
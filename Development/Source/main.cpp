@@ -2,6 +2,8 @@
 #include <SFML/Graphics.hpp>
 #include <json/json.h>
 #include <sstream>
+#include <list>
+#include <deque>
 #include <math.h>
 #include <stdio.h>
 #include "SuperSmartPointer.hpp"
@@ -13,8 +15,15 @@ using namespace Gallant;
 #include "Math.hpp"
 #include "Input.hpp"
 #include "Sprite.hpp"
+#include "TextureAtlas.hpp"
+#include "TextureCache.hpp"
+#include "DrawCommandList.hpp"
+#include "SpriteBatch.hpp"
+#include "TextEngine.hpp"
 #include "Future.hpp"
+#include "ThreadPool.hpp"
 #include "StringUtils.hpp"
+#include "GapBuffer.hpp"
 #include "GUI.hpp"
 
 int main(int argc, char **argv)
@@ -25,6 +34,9 @@ int main(int argc, char **argv)
 	if(!Window.isOpen())
 		return 1;
 
+	//Heavy work is handed to these so it doesn't stall the window
+	ThreadPool::Instance.Start(2);
+
 	InputCenter Input;
 	UIManager UI(&Window, &Input);
 
@@ -87,17 +99,45 @@ int main(int argc, char **argv)
 	glLoadIdentity();
 	glEnable(GL_TEXTURE_2D);
 
-	while(Input.Update(&Window))
+	UI.SetDamageTracking(true);
+
+	unsigned long Timeout = 0;
+
+	while(Input.Update(&Window, Timeout))
 	{
 		UI.Update();
 		Future::Instance.Update();
 
-		Window.clear(sf::Color(255, 255, 255, 255));
+		Rect RedrawArea;
+
+		//Skip drawing if nothing changed, since what's on screen is still valid
+		if(UI.GetRedrawArea(RedrawArea))
+		{
+			SpriteBatch::Instance.SetOuterScissor(RedrawArea, (float)Window.getSize().y);
+
+			Window.clear(sf::Color(255, 255, 255, 255));
+
+			UI.Draw(&Window);
 
-		UI.Draw(&Window);
+			SpriteBatch::Instance.ClearOuterScissor();
 
-		Window.display();
+			Window.display();
+		};
+
+		//Sleep until there's input or something is due
+		Timeout = UI.GetTimeUntilUpdate();
+
+		unsigned long FutureTimeout;
+
+		if(Future::Instance.GetTimeUntilNext(FutureTimeout) && FutureTimeout < Timeout)
+			Timeout = FutureTimeout;
+
+		//Finished jobs are only noticed by polling
+		if(ThreadPool::Instance.GetTimeUntilNext(FutureTimeout) && FutureTimeout < Timeout)
+			Timeout = FutureTimeout;
 	};
 
+	ThreadPool::Instance.Stop();
+
 	return 0;
 };
@@ -39,6 +39,106 @@ solution "GUISandbox"
 
 			flags { "Optimize" }
 
+	-- Compares SuperSmartPointer against the observer list implementation it replaced
+	project "SmartPointerBenchmark"
+		kind "ConsoleApp"
+		language "C++"
+		files {
+			"Benchmarks/SmartPointerBenchmark.cpp"
+		}
+		
+		includedirs { "Include/", "Source/" } 
+		
+		configuration "Debug"
+			if os.get() == "windows" then
+				links { "sfml-system-d" }
+			else
+				links { "sfml-system" }
+			end
+
+			flags { "Symbols" }
+		
+		configuration "Release"
+			links { "sfml-system" }
+
+			flags { "Optimize" }
+
+	-- Measures hit testing among 10000 widgets, run it from the Content directory
+	project "HitTestBenchmark"
+		kind "ConsoleApp"
+		language "C++"
+		files {
+			"Benchmarks/HitTestBenchmark.cpp",
+			"Source/**.hpp",
+			"Source/**.cpp"
+		}
+
+		excludes { "Source/main.cpp" }
+		
+		includedirs { "Include/", "Source/" } 
+		
+		defines({ "UNICODE", "GLEW_STATIC" })
+		
+		configuration "Debug"
+			if os.get() == "windows" then
+				links { "opengl32", "glu32", "glew", "sfml-system-d", "sfml-window-d", "sfml-graphics-d" }
+			end
+
+			if os.get() == "linux" then
+				links { "GL", "GLU", "GLEW", "sfml-system", "sfml-window", "sfml-graphics" }
+			end
+
+			flags { "Symbols" }
+		
+		configuration "Release"
+			if os.get() == "windows" then
+				links { "opengl32", "glu32", "glew", "sfml-system", "sfml-window", "sfml-graphics" }
+			end
+
+			if os.get() == "linux" then
+				links { "GL", "GLU", "GLEW", "sfml-system", "sfml-window", "sfml-graphics" }
+			end
+
+			flags { "Optimize" }
+
+	-- Measures TextEngine::BreakLines on 1KB, 10KB and 100KB of text, run it from the Content directory
+	project "LineBreakBenchmark"
+		kind "ConsoleApp"
+		language "C++"
+		files {
+			"Benchmarks/LineBreakBenchmark.cpp",
+			"Source/**.hpp",
+			"Source/**.cpp"
+		}
+
+		excludes { "Source/main.cpp" }
+		
+		includedirs { "Include/", "Source/" } 
+		
+		defines({ "UNICODE", "GLEW_STATIC" })
+		
+		configuration "Debug"
+			if os.get() == "windows" then
+				links { "opengl32", "glu32", "glew", "sfml-system-d", "sfml-window-d", "sfml-graphics-d" }
+			end
+
+			if os.get() == "linux" then
+				links { "GL", "GLU", "GLEW", "sfml-system", "sfml-window", "sfml-graphics" }
+			end
+
+			flags { "Symbols" }
+		
+		configuration "Release"
+			if os.get() == "windows" then
+				links { "opengl32", "glu32", "glew", "sfml-system", "sfml-window", "sfml-graphics" }
+			end
+
+			if os.get() == "linux" then
+				links { "GL", "GLU", "GLEW", "sfml-system", "sfml-window", "sfml-graphics" }
+			end
+
+			flags { "Optimize" }
+
 
 -- From http://industriousone.com/topic/how-get-current-configuration
 -- iterate over all solutions